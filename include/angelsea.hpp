@@ -3,4 +3,5 @@
 #pragma once
 
 #include <angelsea/config.hpp>
+#include <angelsea/intrinsics.hpp>
 #include <angelsea/jit.hpp>
\ No newline at end of file
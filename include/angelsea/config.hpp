@@ -127,12 +127,60 @@ struct JitConfig {
 	/// to care all that much performance-wise.
 	int mir_optimization_level = 2;
 
-	/// Maximum number of bytecode size in bytes for a function to be considered by the JIT compiler. This is to limit
-	/// the effect of extremely large functions that take disproportionately much memory and compute time when compiled
-	/// with MIR.
+	struct CompileCostModel {
+		/// Maximum estimated compile cost for a function to be considered by the JIT compiler. This is to limit the
+		/// effect of extremely large or complex functions that take disproportionately much memory and compute time
+		/// when compiled with MIR.
+		///
+		/// It can also avoid needlessly triggering compilation for long functions that are cold and very long to the
+		/// point they hit enough JIT entry points to trigger compilation.
+		///
+		/// The cost is unitless and is computed from the weights below. It is only meant to grow along with the MIR
+		/// compile time and memory usage of a function, not to predict them; use \ref log_calibration to relate it to
+		/// measured compile times for your workload. Negative values disable the check entirely.
+		double max_cost = 20000.0;
+
+		/// Cost of any bytecode instruction, which roughly models the amount of C code and MIR instructions emitted.
+		double per_instruction = 2.0;
+
+		/// Cost of a branch target, i.e. a basic block boundary in the generated code. MIR passes (register
+		/// allocation in particular) scale with the number of basic blocks far worse than with straight-line code.
+		double per_branch_target = 10.0;
+
+		/// Cost of a `switch` case target, which results in many edges out of a single basic block.
+		double per_switch_case = 6.0;
+
+		/// Cost of a function call instruction, which typically results in a large amount of generated code
+		/// (especially direct system calls) and in values that are live across calls.
+		double per_call = 15.0;
+
+		/// Cost of an object allocation or release instruction (`asBC_ALLOC`, `asBC_FREE`). These are common in
+		/// ordinary object code and translate to a short runtime call, so they weigh much less than other calls.
+		double per_allocation = 4.0;
+
+		/// Cost of a variable slot (in dwords) of the function's stack frame.
+		double per_variable = 1.0;
+
+		/// Cost of a variable slot multiplied by a branch target. This models the superlinear growth in live range
+		/// analysis for functions that have both many variables and a complex control flow.
+		double per_variable_branch_target = 0.05;
+
+		/// Log the estimated compile cost against the measured compile time of every function with the verbose
+		/// severity. Useful to calibrate the weights above for a specific workload.
+		bool log_calibration = false;
+	};
+
+	/// Heuristics used to estimate how expensive a function is to compile, and to reject functions that are deemed too
+	/// expensive.
+	CompileCostModel compile_cost;
+
+	/// Maximum bytecode size in bytes for a function to be considered by the JIT compiler, checked in addition to \ref
+	/// CompileCostModel::max_cost. 0 disables the check.
 	///
-	/// It can also avoid needlessly triggering compilation for long functions that are cold and very long to the point
-	/// they hit enough JIT entry points to trigger compilation.
+	/// This keeps its historical default until the weights of \ref compile_cost are calibrated against real
+	/// workloads, so that functions rejected before are still rejected. Set it to 0 to only rely on \ref
+	/// compile_cost, which also accounts for the control flow complexity of functions. It will be deprecated once its
+	/// default becomes 0.
 	std::size_t max_bytecode_bytes = 25000;
 
 	/// Gross hack that frees a bunch of memory internally used by MIR that is not really used after the code generation
@@ -142,21 +190,95 @@ struct JitConfig {
 	/// Ignore asBC_SUSPEND instructions, and never check for the suspend status in the VM. This is useful even if
 	/// `asEP_BUILD_WITHOUT_LINE_CUES` is set, as some suspend instructions may remain, and some instructions implicitly
 	/// check for suspend.
+	///
+	/// If disabled, line callbacks, `asIScriptContext::Suspend` and timeouts built upon them work as in the VM. Suspend
+	/// checks are translated to a test of the `doProcessSuspend` VM register, and only leave JIT code when a suspend is
+	/// actually requested.
 	bool hack_ignore_suspend = true;
 
-	/// Ignore C++ exceptions thrown by application functions during direct system calls from JIT functions. If this
-	/// hack is disabled, scripts won't be able to perform native calls and will become significantly slower.
+	/// Ignore C++ exceptions thrown by application functions during direct system calls from JIT functions.
+	///
+	/// If this hack is disabled, direct system calls go through a C++ trampoline that turns exceptions into script
+	/// exceptions, like the VM does, as exceptions cannot unwind through JIT code. Native calls can only be guarded if
+	/// they take up to 8 integer or pointer arguments; other native calls are made through the VM and become
+	/// significantly slower.
 	bool hack_ignore_exceptions = true;
 
 	/// Do not update the program pointer, stack pointer and the stack frame pointers on direct system function calls
 	/// and some other scenarios. This breaks callees that may rely on the debug interface to inspect script state, but
 	/// is safe otherwise.
+	///
+	/// If disabled, the context is brought up to date right before each system call instead: the registers are saved
+	/// and promoted variables are written back to the stack frame. Script code that cannot be observed from a system
+	/// function is not affected.
+	///
+	/// This does not affect the call stack itself, which system functions can always walk, see \ref
+	/// experimental_shadow_call_stack.
 	bool hack_ignore_context_inspect = true;
 
-	/// Speeds up script calls by replacing complex call runtime logic with code generation. Does not enable inlining
-	/// yet. This is subject to breakage with AngelScript updates.
+	/// Speeds up script calls by replacing complex call runtime logic with code generation. When both the caller and
+	/// callee are compiled, the callee returns directly into the caller, which resumes execution without going through
+	/// the VM. This is subject to breakage with AngelScript updates.
 	bool experimental_fast_script_call = true;
 
+	/// Avoids pushing to the context call stack on script calls performed via \ref experimental_fast_script_call. The
+	/// call state is instead kept in a record on the native stack, and only pushed to the call stack when execution
+	/// has to return to the VM (VM fallbacks, script exceptions, calls into functions that are not compiled yet).
+	///
+	/// The call stack is always complete when observed from the VM, system functions, the line callback or the
+	/// exception callback: the records of the callers are pushed to the call stack before a system call, at most once
+	/// per frame. Records count towards `asEP_MAX_CALL_STACK_SIZE` as if they were pushed.
+	bool experimental_shadow_call_stack = true;
+
+	/// Inlines calls to small script functions (e.g. getters, setters, small math helpers) into the caller, skipping
+	/// the script call entirely. Only callees made of simple instructions that do not perform calls are considered.
+	/// If the inlined code raises a script exception, execution restarts from a regular call, so that the exception
+	/// is raised from the callee as usual.
+	///
+	/// As inlined callees never perform calls, they cannot be observed as missing from the call stack. Functions with
+	/// \ref FnConfig::disable_jit or \ref FnConfig::dump_c set are never inlined.
+	bool experimental_script_inlining = true;
+
+	/// Maximum number of bytecode instructions for a script function to be considered for inlining, see \ref
+	/// experimental_script_inlining.
+	std::size_t script_inlining_max_instructions = 32;
+
+	/// Calls script functions that only use primitive types and that can never fall back to the VM nor raise script
+	/// exceptions through a native C function with typed parameters, which bypasses the AngelScript stack, call stack
+	/// and VM registers entirely. This mostly benefits small recursive numeric functions.
+	///
+	/// Such calls do not appear in the call stack, but as they never perform other calls, they cannot be observed.
+	/// Recursion deeper than \ref typed_script_call_max_depth or than `asEP_MAX_CALL_STACK_SIZE` continues through a
+	/// regular call in a nested state of the context, so that the limits of the engine apply.
+	///
+	/// Functions with \ref FnConfig::disable_jit or \ref FnConfig::dump_c set are never called this way.
+	bool experimental_typed_script_call = true;
+
+	/// Maximum number of bytecode instructions for a script function to be called through a typed entry point, see
+	/// \ref experimental_typed_script_call. The typed entry point is emitted along with the function itself, so this
+	/// limits how much code is generated for it.
+	std::size_t typed_script_call_max_instructions = 256;
+
+	/// Maximum number of nested calls through typed entry points, see \ref experimental_typed_script_call. Typed
+	/// entry points run on the native stack, so this bounds how much of it they may use.
+	int typed_script_call_max_depth = 1024;
+
+	/// Keeps primitive variables of the stack frame in C locals rather than reading and writing them through memory
+	/// for every instruction, which lets the C compiler keep them in registers. Only variables whose address is never
+	/// taken and that are only accessed by simple instructions are considered. They are written back to the stack
+	/// frame whenever the JIT function returns to the VM.
+	///
+	/// The stack frame is then out of date while JIT code runs. Unless \ref hack_ignore_context_inspect is set, they
+	/// are also written back before and reloaded after system calls.
+	bool experimental_promote_frame_variables = true;
+
+	/// Runs constant propagation, copy propagation and dead-store elimination over the primitive frame variables of
+	/// every function, and emits the arithmetic they are involved in from the optimized IR rather than instruction by
+	/// instruction. See angelsea::detail::ir.
+	///
+	/// Null checks that are known to always pass are removed regardless of this setting.
+	bool experimental_ir_optimizations = true;
+
 	/// Speeds up the generic calling convention by replacing complex call runtime logic with code generation. This is
 	/// subject to breakage with AngelScript updates. It also tries to be clever with the C++ ABI (as it has to populate
 	/// the vtable pointer for asCGeneric correctly), which could be prone to breakage.
@@ -177,6 +299,11 @@ struct JitConfig {
 	/// was found to regress performance in microbenchmarks.
 	bool experimental_fast_script_return = true;
 
+	/// Translates simple functions (only made of primitive arithmetic, comparisons and branches on local variables)
+	/// straight to MIR, bypassing C generation and the C frontend of MIR, which considerably reduces compile latency
+	/// and memory usage for those functions. Other functions are still translated to C.
+	bool experimental_direct_mir = false;
+
 	/// Speeds up the generic calling convention if \ref experimental_direct_generic_call is true by assuming that the
 	/// called system functions will always set the return value. If the callee fails to do so when this function is
 	/// set, uninitialized reads can happen script-side, which may result in crashes with pointers.
@@ -6,13 +6,17 @@
 #include <angelscript.h>
 #include <angelsea/config.hpp>
 #include <angelsea/detail/bytecodeinstruction.hpp>
+#include <angelsea/detail/ir.hpp>
 #include <angelsea/fnconfig.hpp>
+#include <angelsea/intrinsics.hpp>
 #include <as_property.h>
 #include <as_scriptengine.h>
 #include <as_scriptfunction.h>
 #include <fmt/format.h>
 #include <functional>
 #include <iterator>
+#include <map>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <unordered_map>
@@ -52,6 +56,10 @@ class BytecodeToC {
 	struct ExternSystemFunction {
 		int id;
 	};
+	/// The auxiliary object of a system function called as a method of it, e.g. with `asCALL_THISCALL_ASGLOBAL`.
+	struct ExternSystemFunctionAuxiliary {
+		int id;
+	};
 	struct ExternGlobalVariable {
 		void*              ptr;
 		asCGlobalProperty* property;
@@ -63,19 +71,56 @@ class BytecodeToC {
 	struct ExternTypeInfo {
 		asITypeInfo* object_type;
 	};
+	/// A native symbol declared by the intrinsic of a system function, see \ref SystemFunctionIntrinsic::symbols.
+	struct ExternIntrinsicSymbol {
+		int id;
+	};
+	/// An inline cache of a method resolving call site, see \ref asea_method_cache. The raw value is null: the cache
+	/// must be allocated, zero-initialized and eventually released by the receiver of the mapping.
+	struct ExternMethodCache {};
+	/// The typed entry point of a script function, see \ref JitConfig::experimental_typed_script_call. The raw value is
+	/// null: the receiver must provide a pointer-sized slot, which holds the address of the typed entry point once the
+	/// function was compiled, and null until then (see \ref set_map_typed_entry_callback).
+	struct ExternTypedEntry {
+		asIScriptFunction* fn;
+	};
 	using ExternMapping = std::variant<
 	    ExternBytecodeDefinition,
 	    ExternGlobalVariable,
 	    ExternStringConstant,
 	    ExternScriptFunction,
 	    ExternSystemFunction,
-	    ExternTypeInfo>;
+	    ExternSystemFunctionAuxiliary,
+	    ExternTypeInfo,
+	    ExternIntrinsicSymbol,
+	    ExternMethodCache,
+	    ExternTypedEntry>;
 
 	using OnMapFunctionCallback = std::function<void(asIScriptFunction&, const std::string& name)>;
 	using OnMapExternCallback   = std::function<void(const char* c_name, const ExternMapping& kind, void* raw_value)>;
+	using FnConfigCallback      = std::function<FnConfig(asIScriptFunction&)>;
+
+	/// Static metrics of a function's bytecode that are relevant to predict how expensive it is to translate and
+	/// compile, see \ref estimate_compile_cost.
+	struct CompileCostEstimate {
+		std::size_t instruction_count   = 0;
+		std::size_t branch_target_count = 0;
+		std::size_t switch_case_count   = 0;
+		std::size_t call_count          = 0;
+		std::size_t allocation_count    = 0;
+		std::size_t variable_count      = 0;
+
+		/// Weighted cost according to \ref JitConfig::compile_cost.
+		double cost = 0.0;
+	};
 
 	BytecodeToC(const JitConfig& config, asIScriptEngine& engine, std::string c_symbol_prefix = "asea_jit");
 
+	/// Estimates the cost of compiling a function from a quick analysis of its bytecode. This does not require a
+	/// context and does not modify the bytecode, so this can be called before \ref translate_function to decide whether
+	/// the function is worth translating at all.
+	[[nodiscard]] CompileCostEstimate estimate_compile_cost(asIScriptFunction& fn) const;
+
 	void           prepare_new_context();
 	TranspiledCode finalize_context();
 
@@ -86,6 +131,13 @@ class BytecodeToC {
 	/// the source code.
 	void set_map_function_callback(OnMapFunctionCallback callback) { m_on_map_function_callback = std::move(callback); }
 
+	/// Configure the callback to be invoked when the typed entry point of the translated function is emitted, along
+	/// with its C function name. Once compiled, its address must be stored to the slot mapped by \ref ExternTypedEntry
+	/// for the function, so that other functions can call it.
+	void set_map_typed_entry_callback(OnMapFunctionCallback callback) {
+		m_on_map_typed_entry_callback = std::move(callback);
+	}
+
 	/// Configure the callback to be invoked when the C code is declaring an
 	/// `extern` asPWORD variable that it knows the value of (through the
 	/// engine); typically to allow making the C code not hardcode references to
@@ -98,11 +150,33 @@ class BytecodeToC {
 	/// changed.
 	void set_map_extern_callback(OnMapExternCallback callback) { m_on_map_extern_callback = std::move(callback); }
 
+	/// Configure the callback used to obtain the \ref FnConfig of script functions that are called by the translated
+	/// function, which must be respected when bypassing their JIT entry point, e.g. when inlining them. If unset, the
+	/// default configuration is assumed.
+	void set_fn_config_callback(FnConfigCallback callback) { m_fn_config_callback = std::move(callback); }
+
+	/// Declares the traits of the system function `fn_idx`, which are taken into account by calls to it that are
+	/// translated afterwards.
+	void set_system_function_traits(int fn_idx, SystemFunctionTraits traits) {
+		m_system_function_traits[fn_idx] = traits;
+	}
+
+	/// Declares the intrinsic of the system function `fn_idx`, which replaces calls to it that are translated
+	/// afterwards.
+	void set_system_function_intrinsic(int fn_idx, SystemFunctionIntrinsic intrinsic) {
+		m_system_function_intrinsics[fn_idx] = std::move(intrinsic);
+	}
+
 	/// Returns the number of fallbacks to the VM generated since
 	/// `prepare_new_context`.
 	/// If `== 0`, then all translated functions were fully translated.
 	std::size_t get_fallback_count() const { return m_module_state.fallback_count; }
 
+	/// Whether direct script calls keep their call state in a shadow frame, see \ref
+	/// JitConfig::experimental_shadow_call_stack. Any JIT function that may be called directly must then accept a
+	/// tagged shadow frame pointer as its entry label.
+	[[nodiscard]] bool uses_shadow_call_stack() const;
+
 	private:
 	struct StackPushInfo {
 		VarType type;
@@ -113,6 +187,17 @@ class BytecodeToC {
 		ERR_NULL            = 1 << 1,
 		ERR_DIVIDE_BY_ZERO  = 1 << 2,
 		ERR_DIVIDE_OVERFLOW = 1 << 3,
+		ERR_POW_OVERFLOW    = 1 << 4,
+	};
+
+	/// Information about the inlined function being translated, see \ref emit_inlined_script_call.
+	struct InlineInfo {
+		/// Label to jump to when the inlined code cannot proceed (e.g. on a script exception), which performs the call
+		/// regularly instead.
+		std::string deopt_label;
+
+		/// Label to jump to on return from the inlined function.
+		std::string return_label;
 	};
 
 	struct FnState {
@@ -139,12 +224,30 @@ class BytecodeToC {
 
 		std::unordered_map<std::size_t, VirtualInstruction> overriden_instructions;
 
+		/// IR of the function, see \ref build_ir. Only built for the function being translated, not for inlined
+		/// callees and typed entries.
+		std::optional<ir::Function> ir;
+
 		/// Symbols that already have been emitted, to avoid duplicated declarations
 		std::unordered_set<std::string> emitted_symbols; // (might be good to find a way to remove?)
 
 		bool has_direct_generic_call;
 
 		std::underlying_type_t<ErrorHandler> error_handlers_mask;
+
+		/// Prefix of the labels of bytecode instructions, which differs for inlined functions to avoid clashes.
+		std::string label_prefix;
+
+		/// Non-null if the function is being inlined into another.
+		const InlineInfo* inline_info;
+
+		/// Whether the function is being translated as a typed entry point, see \ref emit_typed_entry.
+		bool is_typed_entry;
+
+		/// Number of dwords and pointers that were pushed below `sp` without adjusting it yet, see \ref
+		/// emit_virtual_stack_push.
+		int pending_push_dwords = 0;
+		int pending_push_pwords = 0;
 	};
 
 	std::string create_new_entry_point_name(asIScriptFunction& fn);
@@ -212,18 +315,95 @@ class BytecodeToC {
 	/// Discover peephole optimizations to populate the virtual instructions.
 	void discover_peephole(FnState& state);
 
+	/// Discovers which variables of the stack frame can be kept in C locals instead, as long as they are written back
+	/// to the stack frame before returning to the VM, and populates \ref ModuleState::promoted_variables. See
+	/// find_promotable_variables.
+	void discover_promotable_variables(FnState& state);
+
+	/// Builds \ref FnState::ir and runs the IR passes that are enabled by the config. Null checks that are known to pass
+	/// are always eliminated.
+	///
+	/// This function depends on \ref discover_switch_map and \ref configure_jit_entries being executed prior.
+	void build_ir(FnState& state);
+
+	/// Emits the current instruction from its optimized IR, which must be modelled, i.e. not \ref ir::Opcode::OPAQUE
+	/// nor \ref ir::Opcode::NULL_CHECK. Stores of dead values are omitted and constants are stored as is.
+	void emit_ir_instruction(FnState& state, const ir::Instruction& ins);
+
+	/// Emits the declaration of the C locals of promoted variables, initialized from the stack frame. This must precede
+	/// the entry dispatch, as they need to be reloaded on every entry from the VM.
+	void emit_promoted_variables_load(FnState& state);
+
+	/// Returns code writing back the promoted variables to the stack frame, one statement per line prefixed by
+	/// `indent`. This must precede any return to the VM other than through `asBC_RET`.
+	[[nodiscard]] std::string promoted_variables_spill_code(std::string_view indent);
+
+	/// Returns code reloading the promoted variables from the stack frame, as the counterpart of \ref
+	/// promoted_variables_spill_code for when execution resumes in JIT code after the context may have been inspected.
+	[[nodiscard]] std::string promoted_variables_reload_code(std::string_view indent);
+
 	void emit_entry_dispatch(FnState& state);
 	void emit_error_handlers(FnState& state);
 
+	/// Emits the end of the current instruction, including the fallback requested by
+	/// `config.debug.fallback_after_instruction`.
+	void emit_instruction_footer(FnState& state);
+
 	void        emit_vm_fallback(FnState& state, std::string_view reason);
 	std::string jump_to_error_handler_code(FnState& state, ErrorHandler handler);
 
+	/// Returns a statement raising a null pointer exception if `expr` is null, or nothing if the null check of the
+	/// current instruction is redundant according to \ref FnState::ir.
+	std::string null_check_code(FnState& state, std::string_view expr);
+
+	/// Emits code pushing the shadow frames of the current function and its callers to the context call stack, if
+	/// needed. This must precede any return to the VM other than through `asBC_RET`.
+	void emit_materialize_shadow_frames(FnState& state);
+
+	/// Emits the handler for `asBC_SUSPEND`, which only leaves JIT code when a suspend was actually requested. The line
+	/// callback, if any, is invoked without leaving JIT code.
+	void emit_suspend_ins(FnState& state);
+
+	/// Unless \ref JitConfig::hack_ignore_context_inspect is set, emits code bringing the context up to date before a
+	/// system call, so that the callee can inspect it: shadow frames are pushed to the call stack, and promoted
+	/// variables are written back to the stack frame.
+	void emit_context_sync_before_system_call(FnState& state);
+
+	/// Counterpart of \ref emit_context_sync_before_system_call, reloading promoted variables after the call.
+	void emit_context_sync_after_system_call(FnState& state);
+
+	/// Emits the check that the VM performs after `asBC_CALLSYS`, returning to the VM past the call if the called
+	/// function requested a suspend or raised an exception. Does nothing if neither can happen, i.e. if both suspends
+	/// and exceptions are ignored or if the callee `traits` rule them out.
+	void emit_system_call_status_check(FnState& state, SystemFunctionTraits traits);
+
+	/// Returns the traits declared for the system function `fn_idx`, or the default (conservative) traits if none were.
+	[[nodiscard]] SystemFunctionTraits get_system_function_traits(int fn_idx) const;
+
+	/// Returns the intrinsic declared for the system function `fn_idx` if it can be used in place of calls to it, or
+	/// null otherwise.
+	[[nodiscard]] const SystemFunctionIntrinsic* get_system_function_intrinsic(int fn_idx) const;
+
+	/// Emits the definitions of the intrinsic of the system function `fn_idx` if they were not emitted yet in the
+	/// current module, and maps the symbols it declares.
+	void emit_intrinsic_definitions(int fn_idx, const SystemFunctionIntrinsic& intrinsic);
+
+	/// Whether a direct call to a function with `traits` can skip bringing the VM registers and the context up to date,
+	/// as the callee can neither observe them nor leave through an exception.
+	[[nodiscard]] static bool can_skip_system_call_state_sync(SystemFunctionTraits traits) {
+		return traits.no_context_access && traits.nothrow;
+	}
+
 	void emit_save_sp(FnState& state);
 	void emit_save_pc(FnState& state, bool next_pc);
 
 	std::string emit_global_lookup(FnState& state, void* pointer, bool global_var_only);
 	std::string emit_type_info_lookup(FnState& state, asITypeInfo& type);
+	/// Declares and maps the symbol referring to the `asCScriptFunction` of index `fn_idx`, and returns its name.
+	std::string emit_script_function_lookup(FnState& state, int fn_idx);
 
+	/// Whether `type` is a value type that is not trivially copyable for the purpose of calls, i.e. that native code
+	/// passes by invisible reference and returns through a hidden pointer rather than in registers.
 	[[nodiscard]] bool is_complex_passed_by_value(const asCDataType& type) const;
 
 	/// Emits a struct that emulates the layout for ABI purposes in the current scope and returns its generated name.
@@ -235,6 +415,10 @@ class BytecodeToC {
 		std::string_view object_pointer_override;
 		/// Is this a direct function call from the VM (e.g. for behaviors), or is this a script call
 		bool is_internal_call;
+		/// Filled in by \ref emit_system_call from \ref get_system_function_traits.
+		SystemFunctionTraits traits = {};
+		/// Filled in by \ref emit_system_call from \ref get_system_function_intrinsic.
+		const SystemFunctionIntrinsic* intrinsic = nullptr;
 	};
 
 	struct SystemCallEmitResult {
@@ -247,7 +431,7 @@ class BytecodeToC {
 	};
 
 	/// Script call where the function index is not known, e.g. during virtual or interface calls, but the signature is
-	/// known and provided through an asCScriptFunction pointer.
+	/// known and provided through an asCScriptFunction pointer (or null when calling through a function handle).
 	struct ScriptCallByExpr {
 		asCScriptFunction* fn_decl;
 		std::string_view   expr;
@@ -255,6 +439,69 @@ class BytecodeToC {
 
 	void emit_direct_script_call_ins(FnState& state, std::variant<ScriptCallByIdx, ScriptCallByExpr> call);
 
+	/// Emits the complete handler for `asBC_CALLINTF` on the interface method `interface_fn`. The method is resolved
+	/// through a small per call site cache of object types to methods, see `asea_method_cache`, and called through
+	/// \ref emit_direct_script_call_ins.
+	void emit_interface_call_ins(FnState& state, asCScriptFunction& interface_fn);
+
+	struct VirtualCallTarget {
+		/// Implementation that a virtual call most likely resolves to, or null if there is no good guess.
+		asCScriptFunction* fn;
+		/// Whether every possible receiver of the call resolves to `fn`, so that no runtime check is required.
+		bool is_guaranteed;
+	};
+
+	/// Finds out which implementation a call to the virtual method `virtual_fn` resolves to. The call is guaranteed to
+	/// resolve to the implementation of the declaring class if either the method or the class is `final`, or if the
+	/// class is not shared and no class of its module overrides the method (as no other module can derive from it).
+	[[nodiscard]] VirtualCallTarget devirtualize(asCScriptFunction& virtual_fn) const;
+
+	/// Emits the complete handler for `asBC_CALLINTF` on the virtual method `virtual_fn`. When the call can be
+	/// devirtualized (see \ref devirtualize), the known implementation is called directly. Otherwise, the call is
+	/// speculated to resolve to the likely implementation, guarded by a check on the vtable entry of the receiver.
+	void emit_virtual_call_ins(FnState& state, asCScriptFunction& virtual_fn);
+
+	/// Emits a call to a function that is only known at runtime, as for `asBC_CallPtr` and `asBC_CALLBND`, where
+	/// `fn_expr` evaluates to the `asCScriptFunction*` to call, which may be a delegate or null. This dispatches at
+	/// runtime on the kind of the function: script functions are called through \ref emit_direct_script_call_ins, and
+	/// system functions (including delegates to system methods) through the VM system call path, without leaving JIT
+	/// code. Null functions are left to the VM, which raises the appropriate exception.
+	void emit_dynamic_call(FnState& state, std::string_view fn_expr);
+
+	/// Determines whether a script function is suitable to be inlined by \ref emit_inlined_script_call into the
+	/// function being translated.
+	[[nodiscard]] bool can_inline_script_function(FnState& state, asCScriptFunction& callee) const;
+
+	/// Emits the translated body of `callee` within the current function, with its stack frame mapped to a local
+	/// array, and its arguments copied from the stack. Jumps past the regular call on successful return. Returns the
+	/// name of the label that the caller must emit after the regular call, which the inlined code may jump into if it
+	/// cannot proceed.
+	std::string emit_inlined_script_call(FnState& state, asCScriptFunction& callee);
+
+	/// Determines whether the \ref FnConfig of `callee` allows calls to it to bypass its JIT entry point, e.g. by
+	/// inlining it.
+	[[nodiscard]] bool can_bypass_script_function(asCScriptFunction& callee) const;
+
+	/// Determines whether a typed entry point can be generated for a script function, see \ref emit_typed_entry.
+	[[nodiscard]] bool can_use_typed_entry(asCScriptFunction& fn) const;
+
+	/// Emits (if not already done within the current module) the typed entry point of `fn`, which is a C function in
+	/// the form of e.g. `asQWORD f(asea_vm_registers *regs, asea_typed_call *call, int depth, asDWORD a, float b)`
+	/// returning the value register. This is only done in the module of `fn` itself: other modules call it through
+	/// \ref ExternTypedEntry.
+	/// It runs without a VM stack frame or call stack entry, which means only functions that can never fall back to the
+	/// VM or raise errors are supported (see \ref can_use_typed_entry). Returns its symbol name.
+	///
+	/// `depth` is the number of nested typed calls that may still be performed, including this one. Past it, the
+	/// function is called regularly through \ref asea_call_script_nested, which sets `call->failed` if it raised an
+	/// exception, in which case the return value is meaningless.
+	std::string emit_typed_entry(FnState& state, asCScriptFunction& fn);
+
+	/// Emits a call to the typed entry point of `callee` using the arguments that were pushed to the stack, and pops
+	/// them. Outside of typed entries, returns the name of the label that the caller must emit after the regular call,
+	/// which is used as a fallback if the typed entry point of `callee` was not compiled yet.
+	std::string emit_typed_script_call(FnState& state, asCScriptFunction& callee);
+
 	/// Emit code to perform a system call, potentially directly if config allows. On failure, a direct call is emitted.
 	/// This function never calls emit_vm_fallback; i.e. it may perform calls via the VM but it will never return from
 	/// the JIT function to do so.
@@ -288,6 +535,20 @@ class BytecodeToC {
 	    std::string_view   fn_callable_symbol
 	);
 
+	/// Returns how many arguments the current call passes to the variadic parameter of `fn`. AngelScript pushes this
+	/// count as a constant right after the fixed parameters, which come after `hidden_pushes` pointers (the object and
+	/// return location). Returns `std::nullopt` if the count cannot be found among the pushes preceding the call.
+	[[nodiscard]] std::optional<asUINT>
+	get_variadic_argument_count(FnState& state, const asCScriptFunction& fn, std::size_t hidden_pushes) const;
+
+	/// Returns the AddRef behaviour (if `is_addref`) or the Release behaviour that the VM calls for an auto handle
+	/// (`@+`) of `type` around system calls, or 0 if there is none.
+	[[nodiscard]] static int get_auto_handle_behaviour(const asCDataType& type, bool is_addref);
+
+	/// Emits a call to the AddRef or Release behaviour `behaviour_fn_idx` for the auto handle `handle_expr` if it is
+	/// not null.
+	void emit_auto_handle_call(FnState& state, std::string_view handle_expr, int behaviour_fn_idx);
+
 	/// Emits the complete handler for a stack push instruction. In case of stack pushes that are relevant to a function
 	/// call, the actual stack push may be omitted and instead redirect to a temporary variable, see \ref
 	/// discover_function_call_pushes.
@@ -300,6 +561,14 @@ class BytecodeToC {
 
 	void emit_stack_push(FnState& state, std::string_view expr, VarType type);
 
+	/// Emits a stack push that writes to its known offset below `sp` without adjusting `sp`. The adjustments of
+	/// consecutive pushes are accumulated at translation time and applied at once by \ref emit_flush_virtual_stack,
+	/// which must happen before anything else reads `sp`.
+	void emit_virtual_stack_push(FnState& state, std::string_view expr, VarType type);
+
+	/// Emits the pending `sp` adjustment of virtual stack pushes, if any.
+	void emit_flush_virtual_stack(FnState& state);
+
 	void emit_assign_ins(FnState& state, std::string_view dst, std::string_view src);
 
 	/// Emits a conditional branch: If `expr` is true then jump to the specified bytecode offset, otherwise continue.
@@ -316,10 +585,8 @@ class BytecodeToC {
 	/// Writes the boolean result of `valueRegister {op} 0` to `valueRegister`.
 	void emit_test_ins(FnState& state, std::string_view op_with_rhs_0);
 
-	/// Emits the complete handler for a primitive cast of a variable on the stack to another.
-	/// Automatically determines whether the instruction takes two arguments (source and destination), or whether the
-	/// operation occurs in place in the same variable location.
-	void emit_primitive_cast_var_ins(FnState& state, VarType src, VarType dst);
+	/// Emits the complete handler for a primitive cast of a variable on the stack to another, or in place.
+	void emit_primitive_cast_var_ins(FnState& state, const bcins::PrimitiveCast& cast);
 
 	/// Emits the complete handler for an in-place prefix operation on the valueRegister, that is,
 	/// `{op}valueRegister` (`op` normally being either `++` or `--`).
@@ -355,12 +622,24 @@ class BytecodeToC {
 	/// there is no `lhs_overflow_value` logic.
 	void emit_divmod_var_unsigned_ins(FnState& state, std::string_view op, VarType type);
 
+	/// Emits the complete handler for any of the `asBC_POW*` instructions, which call into the runtime as the
+	/// overflow rules of AngelScript are not trivial to replicate inline.
+	void emit_pow_var_ins(FnState& state);
+
 	std::string frame_ptr(std::string_view expr);
 	std::string frame_ptr(int offset);
 
 	std::string frame_var(std::string_view expr, VarType type);
 	std::string frame_var(int offset, VarType type);
 
+	/// Returns an expression reading the raw bits of a frame variable as `type`, regardless of what type the variable
+	/// was promoted to (if at all). This may emit a temporary beforehand.
+	std::string frame_var_bits(FnState& state, int offset, VarType type);
+
+	/// Emits an assignment of the raw bits of `expr` of `type` to a frame variable, regardless of what type the
+	/// variable was promoted to (if at all).
+	void emit_frame_var_bits_store(FnState& state, int offset, VarType type, std::string_view expr);
+
 	std::string stack_var(int offset, VarType type);
 
 	const JitConfig* m_config;
@@ -368,7 +647,12 @@ class BytecodeToC {
 	std::string      m_c_symbol_prefix;
 
 	OnMapFunctionCallback m_on_map_function_callback;
+	OnMapFunctionCallback m_on_map_typed_entry_callback;
 	OnMapExternCallback   m_on_map_extern_callback;
+	FnConfigCallback      m_fn_config_callback;
+
+	std::unordered_map<int, SystemFunctionTraits>    m_system_function_traits;
+	std::unordered_map<int, SystemFunctionIntrinsic> m_system_function_intrinsics;
 
 	/// State for the current `prepare_new_context` context.
 	struct ModuleState {
@@ -377,9 +661,23 @@ class BytecodeToC {
 		std::size_t      string_constant_idx = 0;
 		std::size_t      type_info_idx       = 0;
 		std::size_t      fn_idx              = 0;
+		std::size_t      inline_idx          = 0;
+		std::size_t      typed_call_idx      = 0;
 		std::string      fn_name;
 		std::string      fn_bytecode_ptr;
 		FnConfig         fn_config;
+
+		/// Typed entry points that were already emitted in this module, see \ref emit_typed_entry.
+		std::unordered_map<asIScriptFunction*, std::string> typed_entries;
+
+		/// System functions whose intrinsic definitions were already emitted in this module, see \ref
+		/// emit_intrinsic_definitions.
+		std::unordered_set<int> emitted_intrinsics;
+
+		/// Variables of the current function that live in C locals, by stack frame offset, with the type of their
+		/// local. See \ref discover_promotable_variables.
+		std::map<int, VarType> promoted_variables;
+
 		// TODO: refactor some stuff between FnState and ModuleState, because it's not really clear where the line is
 		// drawn atm. FnState should probably be state that can evolve *within* the translation of a function, so things
 		// like the script function pointer should be in the module state instead.
@@ -423,7 +721,7 @@ inline VarType BytecodeToC::make_local_from_operand(FnState& state, std::string_
 		        "\t\t{TYPE} {NAME} = {VAR};\n",
 		        fmt::arg("TYPE", v.type.c),
 		        fmt::arg("NAME", name),
-		        fmt::arg("VAR", frame_var(v.idx, v.type))
+		        fmt::arg("VAR", frame_var_bits(state, v.idx, v.type))
 		    );
 		    return v.type;
 	    },
@@ -454,6 +752,11 @@ inline VarType BytecodeToC::make_local_from_operand(FnState& state, std::string_
 		    );
 		    return var_types::void_ptr;
 	    },
+	    [&](const operands::FunctionPointer& v) {
+		    const auto fn_symbol = emit_script_function_lookup(state, v.ptr->GetId());
+		    emit("\t\tvoid* {NAME} = &{FN};\n", fmt::arg("NAME", name), fmt::arg("FN", fn_symbol));
+		    return var_types::void_ptr;
+	    },
 	    [&](const operands::ValueRegister& v) {
 		    // FIXME: can't handle fp yet
 		    emit("\t\t{TYPE} {NAME} = value_reg;\n", fmt::arg("TYPE", v.type.c), fmt::arg("NAME", name));
@@ -0,0 +1,45 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+#pragma once
+
+#include <angelscript.h>
+#include <angelsea/config.hpp>
+#include <cstddef>
+#include <string>
+
+extern "C" {
+#include <mir.h>
+}
+
+namespace angelsea::detail {
+
+/// Translates script functions to MIR directly through the MIR API, bypassing C generation and the c2mir frontend,
+/// which make up most of the compile latency of small functions.
+///
+/// Only a subset of functions is supported for now: those made exclusively of primitive arithmetic, comparisons and
+/// branches on frame variables, see \ref can_translate. Any other function should be translated by \ref BytecodeToC.
+///
+/// The frame analyses that do not depend on the backend are shared with BytecodeToC, see frameanalysis.hpp.
+class BytecodeToMir {
+	public:
+	explicit BytecodeToMir(const JitConfig& config);
+
+	/// Whether every instruction of `fn` is supported by this backend.
+	[[nodiscard]] bool can_translate(asIScriptFunction& fn) const;
+
+	/// Marks every asBC_JitEntry of `fn` as a valid entry point. Must be called before \ref translate_function.
+	void configure_jit_entries(asIScriptFunction& fn) const;
+
+	/// Creates a new module in `ctx` holding the JIT entry function of `fn`, and returns the name of that function.
+	/// `fn` must be supported per \ref can_translate.
+	///
+	/// If `uses_shadow_call_stack` is set, the function accepts a tagged pointer to the shadow frame of its caller as
+	/// an entry label, see BytecodeToC::uses_shadow_call_stack.
+	std::string translate_function(MIR_context_t ctx, asIScriptFunction& fn, bool uses_shadow_call_stack);
+
+	private:
+	const JitConfig* m_config;
+	std::size_t      m_function_idx = 0;
+};
+
+} // namespace angelsea::detail
@@ -133,6 +133,15 @@ struct ObjectType {
 	bool operator==(const ObjectType&) const = default;
 };
 
+/// Models a pointer to a script or system function, as pushed for function handles.
+struct FunctionPointer {
+	asCScriptFunction* ptr;
+
+	static constexpr VarType get_type() { return var_types::void_ptr; }
+
+	bool operator==(const FunctionPointer&) const = default;
+};
+
 /// Models that the operand should be the value register interpreted as a specific type.
 struct ValueRegister {
 	VarType type;
@@ -207,7 +216,8 @@ struct StackPush : InsRef {
 	       asBC_PshRPtr,
 	       asBC_PSF,
 	       asBC_PGA,
-	       asBC_OBJTYPE};
+	       asBC_OBJTYPE,
+	       asBC_FuncPtr};
 
 	explicit StackPush(const InsRef& ins) : InsRef(ins) {
 		using namespace var_types;
@@ -217,7 +227,6 @@ struct StackPush : InsRef {
 
 		switch (ins.opcode()) {
 			// TODO: when supported
-			// case asBC_FuncPtr:
 			// case asBC_PshListElmnt:
 		case asBC_TYPEID:
 		case asBC_PshC4:   value = Immediate<asDWORD>{ins.dword0()}; break;
@@ -233,6 +242,7 @@ struct StackPush : InsRef {
 		case asBC_PSF:     value = FrameVariablePointer{ins.sword0()}; break;
 		case asBC_PGA:     value = GlobalVariable{std::bit_cast<void*>(ins.pword0()), {}, true, false}; break;
 		case asBC_OBJTYPE: value = ObjectType{std::bit_cast<asCObjectType*>(ins.pword0())}; break;
+		case asBC_FuncPtr: value = FunctionPointer{std::bit_cast<asCScriptFunction*>(ins.pword0())}; break;
 		default:           angelsea_assert(false);
 		}
 	}
@@ -241,6 +251,7 @@ struct StackPush : InsRef {
 	    operands::FrameVariablePointer,
 	    operands::GlobalVariable,
 	    operands::ObjectType,
+	    operands::FunctionPointer,
 	    operands::ValueRegister,
 	    operands::Immediate<asDWORD>,
 	    operands::Immediate<asQWORD>>
@@ -322,6 +333,61 @@ struct Compare : InsRef {
 	    rhs;
 };
 
+/// Conversion between primitive types of a variable, either in place or from a source variable to a destination one.
+struct PrimitiveCast : InsRef {
+	static constexpr std::array valid_opcodes
+	    = {asBC_iTOf,   asBC_fTOi,   asBC_uTOf,   asBC_fTOu,   asBC_sbTOi,  asBC_swTOi,  asBC_ubTOi,
+	       asBC_uwTOi,  asBC_iTOb,   asBC_iTOw,   asBC_i64TOi, asBC_uTOi64, asBC_iTOi64, asBC_fTOd,
+	       asBC_dTOf,   asBC_fTOi64, asBC_dTOi64, asBC_fTOu64, asBC_dTOu64, asBC_i64TOf, asBC_u64TOf,
+	       asBC_i64TOd, asBC_u64TOd, asBC_dTOi,   asBC_dTOu,   asBC_iTOd,   asBC_uTOd};
+
+	explicit PrimitiveCast(const InsRef& ins) : InsRef(ins) {
+		using namespace var_types;
+
+		angelsea_assert(is_specific_ins<PrimitiveCast>(ins));
+
+		switch (ins.opcode()) {
+		case asBC_iTOf:   src = s32, dst = f32; break;
+		case asBC_fTOi:   src = f32, dst = s32; break;
+		case asBC_uTOf:   src = u32, dst = f32; break;
+		case asBC_fTOu:   src = f32, dst = u32; break;
+		case asBC_sbTOi:  src = s8, dst = s32; break;
+		case asBC_swTOi:  src = s16, dst = s32; break;
+		case asBC_ubTOi:  src = u8, dst = s32; break;
+		case asBC_uwTOi:  src = u16, dst = s32; break;
+		case asBC_iTOb:   src = u32, dst = s8; break;
+		case asBC_iTOw:   src = u32, dst = s16; break;
+		case asBC_i64TOi: src = s64, dst = s32; break;
+		case asBC_uTOi64: src = u32, dst = s64; break;
+		case asBC_iTOi64: src = s32, dst = s64; break;
+		case asBC_fTOd:   src = f32, dst = f64; break;
+		case asBC_dTOf:   src = f64, dst = f32; break;
+		case asBC_fTOi64: src = f32, dst = s64; break;
+		case asBC_dTOi64: src = f64, dst = s64; break;
+		case asBC_fTOu64: src = f32, dst = u64; break;
+		case asBC_dTOu64: src = f64, dst = u64; break;
+		case asBC_i64TOf: src = s64, dst = f32; break;
+		case asBC_u64TOf: src = u64, dst = f32; break;
+		case asBC_i64TOd: src = s64, dst = f64; break;
+		case asBC_u64TOd: src = u64, dst = f64; break;
+		case asBC_dTOi:   src = f64, dst = s32; break;
+		case asBC_dTOu:   src = f64, dst = u32; break;
+		case asBC_iTOd:   src = s32, dst = f64; break;
+		case asBC_uTOd:   src = u32, dst = f64; break;
+		default:          break;
+		}
+	}
+
+	/// Whether the conversion occurs within a single variable, rather than from a source to a destination variable.
+	bool is_in_place() const { return size() == 1; }
+
+	short dst_offset() const { return sword0(); }
+	short src_offset() const { return is_in_place() ? sword0() : sword1(); }
+
+	VarType src;
+	VarType dst;
+};
+
 /// System call (aka app function) to a known function or to a virtual method.
 struct CallSystemDirect : InsRef {
 	public:
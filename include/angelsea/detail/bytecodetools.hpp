@@ -6,6 +6,7 @@
 #include <angelsea/detail/bytecodeinstruction.hpp>
 #include <angelsea/detail/debug.hpp>
 #include <span>
+#include <vector>
 
 namespace angelsea::detail {
 
@@ -64,4 +65,26 @@ inline BytecodeView get_bytecode(asIScriptFunction& fn) {
 	return {std::span{bytecode, length}};
 }
 
+/// Returns the stack frame offsets of all the variables that an instruction refers to through its arguments, as
+/// described by the instruction type. Variables that are only referred to indirectly (e.g. through the stack) are not
+/// included.
+inline std::vector<short> get_variable_operands(InsRef ins) {
+	switch (ins.info().type) {
+	case asBCTYPE_wW_ARG:
+	case asBCTYPE_rW_ARG:
+	case asBCTYPE_rW_DW_ARG:
+	case asBCTYPE_wW_DW_ARG:
+	case asBCTYPE_wW_QW_ARG:
+	case asBCTYPE_rW_QW_ARG:
+	case asBCTYPE_wW_W_ARG:
+	case asBCTYPE_rW_W_DW_ARG:
+	case asBCTYPE_rW_DW_DW_ARG:  return {ins.sword0()};
+	case asBCTYPE_wW_rW_ARG:
+	case asBCTYPE_rW_rW_ARG:
+	case asBCTYPE_wW_rW_DW_ARG:  return {ins.sword0(), ins.sword1()};
+	case asBCTYPE_wW_rW_rW_ARG:  return {ins.sword0(), ins.sword1(), ins.sword2()};
+	default:                     return {};
+	}
+}
+
 } // namespace angelsea::detail
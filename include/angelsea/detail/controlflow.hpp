@@ -0,0 +1,92 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+#pragma once
+
+#include <angelscript.h>
+#include <cstddef>
+#include <deque>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+namespace angelsea::detail {
+
+/// Maximal sequence of bytecode instructions that can only be entered through its first instruction, and that can only
+/// be left after its last instruction (besides returning to the VM).
+struct BasicBlock {
+	/// Bytecode offset of the first instruction of the block.
+	std::size_t begin;
+
+	/// Bytecode offset past the last instruction of the block.
+	std::size_t end;
+
+	/// Whether the function may be entered at the start of this block by the VM, i.e. for the first instruction and
+	/// for valid JIT entry points. Nothing can be assumed about the state on entry of such blocks.
+	bool is_entry_point;
+
+	/// Offsets of the blocks that may execute immediately after this one.
+	std::vector<std::size_t> successors;
+
+	/// Offsets of the blocks that may execute immediately before this one.
+	std::vector<std::size_t> predecessors;
+};
+
+/// Control flow graph of a script function, with the basic blocks indexed by their first bytecode offset.
+struct ControlFlowGraph {
+	std::map<std::size_t, BasicBlock> blocks;
+};
+
+/// Builds the control flow graph of `fn`. `switch_map` maps the offset of every `asBC_JMPP` to its targets, see
+/// BytecodeToC::discover_switch_map. Valid JIT entry points must already be configured.
+ControlFlowGraph build_control_flow_graph(
+    asIScriptFunction&                                                 fn,
+    const std::unordered_map<std::size_t, std::vector<std::size_t>>& switch_map
+);
+
+/// Solves a forward dataflow problem over `cfg` by iterating to a fixed point, and returns the state on entry of every
+/// block that is reachable from an entry point.
+/// - `entry_state` is the state on entry of blocks that may be entered by the VM.
+/// - `meet(State& into, const State& from)` merges the state at the end of a predecessor into another.
+/// - `transfer(const BasicBlock&, State)` returns the state at the end of a block given the state on its entry.
+/// `State` must be equality comparable for the fixed point to be detected.
+template<class State, class Meet, class Transfer>
+std::unordered_map<std::size_t, State>
+solve_forward_dataflow(const ControlFlowGraph& cfg, const State& entry_state, Meet&& meet, Transfer&& transfer) {
+	std::unordered_map<std::size_t, State> block_entry_states;
+	std::deque<std::size_t>                worklist;
+
+	for (const auto& [offset, block] : cfg.blocks) {
+		if (block.is_entry_point) {
+			block_entry_states.emplace(offset, entry_state);
+			worklist.push_back(offset);
+		}
+	}
+
+	while (!worklist.empty()) {
+		const std::size_t offset = worklist.front();
+		worklist.pop_front();
+
+		const BasicBlock& block     = cfg.blocks.at(offset);
+		const State       end_state = transfer(block, block_entry_states.at(offset));
+
+		for (const std::size_t successor : block.successors) {
+			auto it = block_entry_states.find(successor);
+			if (it == block_entry_states.end()) {
+				block_entry_states.emplace(successor, end_state);
+				worklist.push_back(successor);
+				continue;
+			}
+
+			State merged = it->second;
+			meet(merged, end_state);
+			if (!(merged == it->second)) {
+				it->second = std::move(merged);
+				worklist.push_back(successor);
+			}
+		}
+	}
+
+	return block_entry_states;
+}
+
+} // namespace angelsea::detail
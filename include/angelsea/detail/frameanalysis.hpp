@@ -0,0 +1,37 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+#pragma once
+
+#include <angelscript.h>
+#include <angelsea/detail/bytecodeinstruction.hpp>
+#include <cstddef>
+#include <map>
+#include <string_view>
+
+namespace angelsea::detail {
+
+/// Whether a type is a floating-point type, as opposed to an integral one.
+inline bool is_floating_point(VarType type) { return type == var_types::f32 || type == var_types::f64; }
+
+/// Operand types and runtime implementation of an `asBC_POW*` instruction.
+struct PowInfo {
+	/// Type of the destination and of the base.
+	VarType type;
+	/// Type of the exponent.
+	VarType exponent_type;
+	/// Runtime function computing the result, see runtime.hpp.
+	std::string_view runtime_function;
+};
+
+PowInfo get_pow_info(asEBCInstr opcode);
+
+/// Finds the frame variables of `fn` that can be kept out of the stack frame by the translated code (e.g. in C locals
+/// or in registers), and returns them by stack frame offset along with the type they should be held as. This is only
+/// the case for primitive variables whose address is never taken, that are not overlapped by any other variable, and
+/// that are only accessed by instructions that are known to handle it with a consistent type.
+///
+/// Promoted variables must be loaded from the stack frame on entry, and written back to it before anything else may
+/// observe the stack frame, e.g. before returning to the VM.
+std::map<int, VarType> find_promotable_variables(asIScriptFunction& fn);
+
+} // namespace angelsea::detail
@@ -0,0 +1,182 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+#pragma once
+
+#include <angelscript.h>
+#include <angelsea/detail/bytecodeinstruction.hpp>
+#include <angelsea/detail/controlflow.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/// Intermediate representation of a script function in SSA form, which BytecodeToC builds from the bytecode and
+/// optimizes before emitting C.
+///
+/// Every value is held by a frame variable, and the values of a variable never live at the same time, so that C can
+/// be emitted from the IR by reading and writing the variables like the bytecode does (whether they are promoted or
+/// not). The passes preserve this: an operand is only ever replaced by a constant, or by a value that its variable
+/// still holds at that point.
+namespace angelsea::detail::ir {
+
+/// Index of a value in \ref Function::values.
+using ValueId = std::size_t;
+
+/// Index of an instruction in \ref Function::instructions.
+using InstructionId = std::size_t;
+
+enum class ValueKind : std::uint8_t {
+	/// Result of a modelled instruction, see \ref Instruction::result.
+	DEFINITION,
+	/// Merge of the values of a variable on entry of a block, see \ref Phi.
+	PHI,
+	/// Value written by an instruction that is not modelled, or held on entry from the VM. Nothing is known about it.
+	UNKNOWN,
+};
+
+struct Value {
+	/// Stack frame offset of the variable holding the value.
+	int variable;
+
+	/// Type of the value if its variable is always accessed as a single primitive type, see find_promotable_variables.
+	/// Other variables are only tracked for null checks.
+	std::optional<VarType> type;
+
+	ValueKind kind;
+
+	/// Index of the defining instruction for definitions, or of the phi in \ref Function::phis for phis.
+	std::size_t definition = 0;
+
+	/// Raw bits of the value if it is known to be constant, see \ref propagate_constants.
+	std::optional<std::uint64_t> constant;
+
+	/// Whether the value may be read from its variable, see \ref eliminate_dead_stores.
+	bool is_live = true;
+};
+
+enum class Opcode : std::uint8_t {
+	/// `result = immediate`, e.g. asBC_SetV4.
+	CONSTANT,
+	/// `result = operands[0]`, copying the raw bits, e.g. asBC_CpyVtoV4.
+	COPY,
+	/// `result = c_operator operands[0]`, e.g. asBC_NEGi.
+	UNARY,
+	/// `result = operands[0] c_operator operands[1]`, or `operands[0] c_operator immediate` if there is a single
+	/// operand, e.g. asBC_ADDi or asBC_ADDIi.
+	BINARY,
+	/// Null check of `operands[0]` before dereferencing it, e.g. asBC_ChkNullV. Otherwise handled as \ref OPAQUE.
+	NULL_CHECK,
+	/// Any other instruction, translated as is. It reads `operands` and writes unknown values to `clobbers`.
+	OPAQUE,
+};
+
+struct Instruction {
+	Opcode opcode;
+
+	/// Bytecode offset of the instruction this was built from.
+	std::size_t offset;
+
+	/// Type of the operation and of its result for \ref Opcode::UNARY and \ref Opcode::BINARY, or type of the raw
+	/// bits for \ref Opcode::CONSTANT and \ref Opcode::COPY.
+	VarType type = {};
+
+	/// Type of the right-hand side of \ref Opcode::BINARY, which only differs from `type` for shifts.
+	VarType rhs_type = {};
+
+	std::string_view c_operator;
+
+	std::uint64_t immediate = 0;
+
+	std::vector<ValueId> operands;
+
+	/// Value defined by modelled instructions.
+	std::optional<ValueId> result;
+
+	/// Unknown values written by other instructions, see \ref ValueKind::UNKNOWN.
+	std::vector<ValueId> clobbers;
+
+	/// Whether the instruction may leave JIT code or run other code (calls, VM fallbacks, script exceptions), which
+	/// may observe or modify the stack frame through the context. Barriers read and clobber every typed variable, except
+	/// for null checks, which never resume once they leave.
+	bool is_barrier = false;
+
+	/// Whether this is a null check that is known to pass, see \ref eliminate_redundant_null_checks.
+	bool is_redundant = false;
+};
+
+/// Merges the values of a variable on entry of a block. `incoming` holds the value at the end of each predecessor, in
+/// the order of \ref BasicBlock::predecessors, then an unknown value if the VM may enter the block.
+struct Phi {
+	std::size_t          block;
+	ValueId              result;
+	std::vector<ValueId> incoming;
+};
+
+struct Block {
+	/// Indices in \ref Function::phis of the phis on entry of the block.
+	std::vector<std::size_t> phis;
+
+	/// Range of the instructions of the block in \ref Function::instructions.
+	InstructionId first_instruction = 0, end_instruction = 0;
+
+	/// Value held by every variable on entry and on exit of the block, by stack frame offset.
+	std::map<int, ValueId> entry_values, exit_values;
+};
+
+struct Function {
+	ControlFlowGraph cfg;
+
+	/// Blocks by bytecode offset, like in \ref cfg.
+	std::map<std::size_t, Block> blocks;
+
+	/// Variables that values are tracked for, by stack frame offset, along with their type if known. Variables whose
+	/// address is taken are never tracked, as they can be modified behind our back.
+	std::map<int, std::optional<VarType>> variables;
+
+	std::vector<Value>       values;
+	std::vector<Phi>         phis;
+	std::vector<Instruction> instructions;
+
+	/// Index of the instruction built from the bytecode instruction at a given offset.
+	std::unordered_map<std::size_t, InstructionId> instruction_at_offset;
+
+	const Instruction* find_instruction(std::size_t offset) const {
+		const auto it = instruction_at_offset.find(offset);
+		return it != instruction_at_offset.end() ? &instructions[it->second] : nullptr;
+	}
+};
+
+/// Builds the IR of `fn`. `switch_map` is as in \ref build_control_flow_graph, and valid JIT entry points must already
+/// be configured. Instructions with an opcode in `opaque_opcodes` are never modelled and are treated as barriers, e.g.
+/// because they fall back to the VM.
+Function build_function(
+    asIScriptFunction&                                                 fn,
+    const std::unordered_map<std::size_t, std::vector<std::size_t>>& switch_map,
+    std::span<const asEBCInstr>                                        opaque_opcodes
+);
+
+/// Replaces the operands of modelled instructions that are copies of another value by that value, when its variable
+/// still holds it.
+void propagate_copies(Function& fn);
+
+/// Determines which values are constant, folding integral arithmetic, and populates \ref Value::constant.
+void propagate_constants(Function& fn);
+
+/// Determines which values may be read, populating \ref Value::is_live. Modelled instructions that define a value that
+/// is never read do not need to be emitted. Constants are emitted as is, so their operands are not read.
+///
+/// This must run after \ref propagate_constants.
+void eliminate_dead_stores(Function& fn);
+
+/// Marks the null checks that are known to pass because their value was already checked on every path leading to
+/// them, see \ref Instruction::is_redundant.
+void eliminate_redundant_null_checks(Function& fn);
+
+/// Runs the passes that optimize the arithmetic of `fn`, in order.
+void optimize(Function& fn);
+
+} // namespace angelsea::detail::ir
@@ -5,13 +5,16 @@
 #include <angelscript.h>
 #include <angelsea/config.hpp>
 #include <angelsea/detail/bytecode2c.hpp>
+#include <angelsea/detail/bytecode2mir.hpp>
 #include <angelsea/detail/debug.hpp>
 #include <angelsea/fnconfig.hpp>
 #include <atomic>
 #include <condition_variable>
+#include <memory>
 #include <mutex>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 extern "C" {
 #include <c2mir/c2mir.h>
@@ -21,6 +24,8 @@ extern "C" {
 #include <mir.h>
 }
 
+struct asea_method_cache;
+
 namespace angelsea::detail {
 
 class Mir {
@@ -71,11 +76,17 @@ struct AsyncMirFunction {
 	std::vector<std::pair<asPWORD*, asPWORD>>  jit_entry_args;
 	std::vector<std::pair<std::string, void*>> deferred_bindings;
 	std::string                                c_name;
+	/// C name of the typed entry point of the function, if it has one, see \ref MirJit::get_typed_entry_slot.
+	std::string                                typed_entry_c_name;
 	TranspiledCode                             c_source;
+	/// If non-null, the function was translated directly to a module of this context, and \ref c_source is empty.
+	std::unique_ptr<Mir>                       direct_mir;
 	std::string                                pretty_name;
+	BytecodeToC::CompileCostEstimate           cost_estimate;
 	struct {
 		std::atomic<bool> ready;
 		asJITFunction     jit_function;
+		void*             typed_entry;
 		MIR_module_t      module;
 	} compiled;
 };
@@ -120,17 +131,43 @@ class MirJit {
 
 	void discover_fn_config();
 
+	/// Returns the configuration of a script function, even after it was translated or if it was not registered yet.
+	FnConfig get_fn_config(asIScriptFunction& script_function);
+
+	void set_system_function_traits(int function_id, SystemFunctionTraits traits) {
+		m_c_generator.set_system_function_traits(function_id, traits);
+	}
+
+	void set_system_function_intrinsic(int function_id, SystemFunctionIntrinsic intrinsic) {
+		m_c_generator.set_system_function_intrinsic(function_id, std::move(intrinsic));
+	}
+
 	private:
+	/// Returns the slot holding the address of the typed entry point of `script_function`, or null if it was not
+	/// compiled yet. Generated code of other functions reads it to call it, see \ref BytecodeToC::ExternTypedEntry.
+	void** get_typed_entry_slot(asIScriptFunction& script_function);
+
 	JitConfig        m_config;
 	asIScriptEngine* m_engine;
 
 	Mir        m_mir;
 	std::mutex m_mir_lock;
 
-	BytecodeToC m_c_generator;
+	BytecodeToC   m_c_generator;
+	BytecodeToMir m_mir_generator;
 
 	std::unordered_map<asIScriptFunction*, LazyMirFunction> m_lazy_functions;
 
+	/// Configuration of every registered function whose configuration is known, see \ref get_fn_config.
+	std::unordered_map<asIScriptFunction*, FnConfig> m_fn_configs;
+
+	/// Inline caches referenced by the generated code of a script function, released when it is unregistered.
+	std::unordered_map<asIScriptFunction*, std::vector<std::unique_ptr<asea_method_cache>>> m_method_caches;
+
+	/// Slots of the typed entry points of script functions, see \ref get_typed_entry_slot, freed when the function is
+	/// unregistered.
+	std::unordered_map<asIScriptFunction*, std::unique_ptr<void*>> m_typed_entry_slots;
+
 	// because the AS engine may unregister a function at any time, during the time the compile thread is working, it is
 	// possible that the asIScriptFunction* will be dangling and reallocating, causing a host of issues. since the
 	// compile thread is not manipulating any of those structures directly, when a function being compiled is being
@@ -15,6 +15,55 @@ class asCScriptObject;
 // - registered to MIR in jitcompiler.cpp
 
 extern "C" {
+/// \brief Call state of a JIT-to-JIT script call that has not necessarily been pushed to the context call stack yet.
+///
+/// These records live on the native stack of the caller and form a linked list up to the function that was entered
+/// from the VM. They are only copied to `asCContext::m_callStack` by \ref asea_materialize_shadow_frames when
+/// execution has to return to the VM.
+struct asea_shadow_frame {
+	asea_shadow_frame* parent;
+	asPWORD            state[CALLSTACK_FRAME_SIZE]; ///< Same layout as a `m_callStack` frame
+	asPWORD            materialized;                ///< Non-zero if `state` was pushed to `m_callStack`
+	asPWORD            depth;                       ///< Frames up to this one that were not pushed to `m_callStack`
+};
+
+/// \brief State shared by a chain of typed calls, from the JIT function that performed the outermost one.
+///
+/// Typed entry points run without any VM frame, so this carries what \ref asea_call_script_nested needs to perform a
+/// regular call from within them.
+struct asea_typed_call {
+	asea_shadow_frame* shadow; ///< Shadow frame of the outermost caller, if any
+	asDWORD*           pc;     ///< Program pointer of the outermost caller, past the call instruction
+	asDWORD*           sp;     ///< Stack pointer of the outermost caller
+	int                failed; ///< Non-zero if a nested call failed, which the caller must return on
+};
+
+/// \brief Number of entries of a \ref asea_method_cache.
+static constexpr int asea_method_cache_size = 4;
+
+/// \brief Maximum number of entries a \ref asea_method_cache allocates over its lifetime. Past this, the call site is
+/// considered megamorphic and misses are resolved without being cached.
+static constexpr int asea_method_cache_max_allocations = 32;
+
+/// \brief Resolved method of a \ref asea_method_cache. Entries are immutable once published.
+struct asea_method_cache_entry {
+	asCObjectType*           type; ///< Holds a reference, so that the address cannot be reused by another type
+	asCScriptFunction*       fn;
+	asea_method_cache_entry* next_allocated;
+};
+
+/// \brief Inline cache of a call site performing method resolution, mapping object types to the resolved method.
+///
+/// Caches are owned by the JIT engine, which releases them along with the script function of the call site. Entries
+/// are replaced in a round-robin fashion once all slots are taken, but replaced entries are only freed with the cache,
+/// so readers may use an entry they loaded without synchronization.
+struct asea_method_cache {
+	asea_method_cache_entry* entries[asea_method_cache_size];
+	asea_method_cache_entry* allocated; ///< Every entry this cache allocated, most recent first
+	asPWORD                  allocation_count;
+	asPWORD                  next_replaced;
+};
+
 /// \brief Calls a script function by pointer (from m_engine->scriptFunctions).
 ///
 /// The caller must ensure that the VM registers are saved before calling.
@@ -30,6 +79,29 @@ void asea_call_script_function(asSVMRegisters* vm_registers, asCScriptFunction&
 [[gnu::hot]]
 int asea_call_system_function(asSVMRegisters* vm_registers, int fn);
 
+/// \brief Calls the generic calling convention function `fn`, catching any C++ exception it throws to raise it as a
+/// script exception on the context, like the VM does.
+///
+/// The caller should check the context status after the call, as the VM does for `asBC_CALLSYS`.
+void asea_call_generic_guarded(asSVMRegisters* vm_registers, asGENFUNC_t fn, asIScriptGeneric* generic);
+
+/// \brief Maximum number of arguments of a native call made through \ref asea_call_native_guarded.
+static constexpr int asea_native_guarded_max_args = 8;
+
+/// \brief Calls the native function `fn` with `arg_count` integer or pointer arguments, catching any C++ exception it
+/// throws to raise it as a script exception on the context, like the VM does.
+///
+/// `fn` is called as a function taking `asQWORD` parameters, which is how integer and pointer arguments are passed
+/// on every supported ABI, as long as they all fit in registers. Returns the integer return register, of which the
+/// caller should only read as many bytes as the actual return type has.
+asQWORD asea_call_native_guarded(asSVMRegisters* vm_registers, void* fn, const asQWORD* args, int arg_count);
+
+/// \brief Same as \ref asea_call_native_guarded, for functions returning a `float`.
+float asea_call_native_guarded_f32(asSVMRegisters* vm_registers, void* fn, const asQWORD* args, int arg_count);
+
+/// \brief Same as \ref asea_call_native_guarded, for functions returning a `double`.
+double asea_call_native_guarded_f64(asSVMRegisters* vm_registers, void* fn, const asQWORD* args, int arg_count);
+
 /// \brief Shim for CallObjectMethod.
 [[gnu::hot]]
 void asea_call_object_method(asSVMRegisters* vm_registers, void* obj, int fn);
@@ -55,6 +127,55 @@ int asea_prepare_script_stack_and_vars(
     asDWORD*           fp
 );
 
+/// \brief Same as \ref asea_prepare_script_stack, but the call state is written to \ref frame rather than pushed to
+/// the context call stack. \ref parent should be the shadow frame of the caller, if any.
+///
+/// The caller must call \ref asea_materialize_shadow_frames on \ref frame if this function fails.
+[[gnu::hot]]
+int asea_prepare_script_stack_shadow(
+    asSVMRegisters*    vm_registers,
+    asCScriptFunction& fn,
+    asDWORD*           pc,
+    asDWORD*           sp,
+    asDWORD*           fp,
+    asea_shadow_frame* frame,
+    asea_shadow_frame* parent
+);
+
+/// \brief Same as \ref asea_prepare_script_stack_and_vars, see \ref asea_prepare_script_stack_shadow.
+[[gnu::hot]]
+int asea_prepare_script_stack_shadow_and_vars(
+    asSVMRegisters*    vm_registers,
+    asCScriptFunction& fn,
+    asDWORD*           pc,
+    asDWORD*           sp,
+    asDWORD*           fp,
+    asea_shadow_frame* frame,
+    asea_shadow_frame* parent
+);
+
+/// \brief Pushes \ref frame and all of its parents that were not pushed yet to the context call stack, outermost
+/// first. This must be done before returning to the VM with shadow frames still live.
+void asea_materialize_shadow_frames(asSVMRegisters* vm_registers, asea_shadow_frame* frame);
+
+/// \brief Returns how many nested calls can be made from the current function before reaching the
+/// `asEP_MAX_CALL_STACK_SIZE` limit of the engine, capped to `max_depth`. `shadow` is the shadow frame of the current
+/// function, if any.
+int asea_remaining_call_depth(asSVMRegisters* vm_registers, asea_shadow_frame* shadow, int max_depth);
+
+/// \brief Calls the script function `fn` through the VM in a nested state of the context, for a typed call that
+/// exceeded its maximum depth. `args` holds the arguments laid out as on the script stack.
+///
+/// If the call raises an exception, it is raised on the context again and `call->failed` is set. If it is aborted, the
+/// context is aborted and `call->failed` is set as well. If it is suspended, it is resumed until it finishes, and the
+/// context is suspended once back in the caller.
+asQWORD asea_call_script_nested(
+    asSVMRegisters*    vm_registers,
+    asea_typed_call*   call,
+    asCScriptFunction* fn,
+    asDWORD*           args
+);
+
 /// \brief Prints a debug message via the engine, only enabled when debugging.
 void asea_debug_message(asSVMRegisters* vm_registers, const char* text);
 
@@ -65,6 +186,53 @@ void asea_debug_int(asSVMRegisters* vm_registers, asPWORD x);
 /// be use one of the TXT_* AngelScript macros for the relevant exception.
 void asea_set_internal_exception(asSVMRegisters* vm_registers, const char* text);
 
+/// \brief Performs what `asBC_SUSPEND` does when `doProcessSuspend` is set: calls the line callback, if any, then
+/// suspends the context if that was requested. The registers must be saved and point to the `asBC_SUSPEND` before
+/// calling.
+///
+/// Returns non-zero if the context was suspended, in which case the caller should return to the VM past the
+/// instruction.
+int asea_process_suspend(asSVMRegisters* vm_registers);
+
+/// \brief Performs the checks of `asBC_CALLSYS` after a system call when `doProcessSuspend` is set: suspends the
+/// context if that was requested by the called function.
+///
+/// Returns non-zero if the context was suspended or is not active anymore, in which case the caller should return to
+/// the VM past the call.
+int asea_check_call_status(asSVMRegisters* vm_registers);
+
+/// \brief Resolves the function that an `asBC_CallPtr` through the function handle `fn` should call. For delegates,
+/// `*delegate_object` is set to the bound object, which the caller must push as the object pointer; otherwise it is
+/// set to null.
+///
+/// Returns null if `fn` is null or if the call cannot be handled by the JIT, in which case the caller should let the VM
+/// perform the call.
+asCScriptFunction* asea_resolve_function_handle(asCScriptFunction* fn, void** delegate_object);
+
+/// \brief Resolves the method of the object `obj` that implements the interface method `interface_fn`, like
+/// `asCContext::CallInterfaceMethod` does, and records it into `cache`.
+///
+/// Returns null if the object type does not implement the interface, in which case the caller should let the VM
+/// perform the call so that it raises the exception.
+asCScriptFunction*
+asea_resolve_interface_method(asea_method_cache* cache, asCScriptObject* obj, asCScriptFunction* interface_fn);
+
+/// \brief Returns the function that the imported function `import_id` (as referred to by `asBC_CALLBND`) is currently
+/// bound to, or null if it is not bound.
+[[gnu::hot]]
+asCScriptFunction* asea_resolve_bound_function(asSVMRegisters* vm_registers, int import_id);
+
+/// \brief Exponentiation with the exact semantics of the `asBC_POW*` instructions. `overflow` is set to non-zero if
+/// the result overflows (or for an integral `0 ** 0` or `0 ** -n`), in which case the caller should raise a
+/// `TXT_POW_OVERFLOW` exception.
+int     asea_powi(int base, int exponent, int* overflow);
+asDWORD asea_powu(asDWORD base, asDWORD exponent, int* overflow);
+asINT64 asea_powi64(asINT64 base, asINT64 exponent, int* overflow);
+asQWORD asea_powu64(asQWORD base, asQWORD exponent, int* overflow);
+float   asea_powf(float base, float exponent, int* overflow);
+double  asea_powd(double base, double exponent, int* overflow);
+double  asea_powdi(double base, int exponent, int* overflow);
+
 /// \brief Performs cleanup for arguments of a function. This generally amounts
 /// to calling ref release or destruct behaviors.
 [[gnu::hot]]
@@ -73,6 +241,10 @@ void asea_clean_args(asSVMRegisters* vm_registers, asCScriptFunction& fn, asDWOR
 /// \brief Casts script object \ref obj to the requested \ref type_id; stores result in object register
 void asea_cast(asSVMRegisters* vm_registers, asCScriptObject* obj, asDWORD type_id);
 
+/// \brief Releases or destroys the elements of the list buffer `list` of an initialization list of `list_type`,
+/// without freeing the buffer itself.
+void asea_destroy_list(asSVMRegisters* vm_registers, void* list, asCObjectType* list_type);
+
 /// \brief Heap-allocate a new script object and construct it, then return the pointer to it. The caller should still be
 /// calling the scripted constructor for that object.
 [[gnu::hot]]
@@ -94,6 +266,8 @@ static constexpr asPWORD asea_offset_ctx_stackindex = offsetof(asCContext, m_sta
 static constexpr asPWORD asea_offset_ctx_engine     = offsetof(asCContext, m_engine);
 
 static constexpr asPWORD asea_offset_scriptfn_scriptdata = offsetof(asCScriptFunction, scriptData);
+static constexpr asPWORD asea_offset_scriptfn_functype   = offsetof(asCScriptFunction, funcType);
+static constexpr asPWORD asea_offset_scriptfn_id         = offsetof(asCScriptFunction, id);
 static constexpr asPWORD asea_offset_scriptdata_jitfunction
     = offsetof(asCScriptFunction::ScriptFunctionData, jitFunction);
 
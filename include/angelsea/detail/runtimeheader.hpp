@@ -113,6 +113,7 @@ typedef struct asCScriptObject_t asCScriptObject;
 typedef struct asSTypeBehaviour_t asSTypeBehaviour;
 
 extern void* memcpy (void *restrict, const void *restrict, __SIZE_TYPE__);
+extern void* memset (void *, int, __SIZE_TYPE__);
 
 #endif
 
@@ -163,6 +164,33 @@ typedef struct {
 	asUINT max_len;
 } asea_array;
 
+typedef struct asea_shadow_frame {
+	struct asea_shadow_frame* parent;
+	asPWORD state[5];
+	asPWORD materialized;
+	asPWORD depth;
+} asea_shadow_frame;
+
+typedef struct asea_typed_call {
+	asea_shadow_frame* shadow;
+	asDWORD* pc;
+	asDWORD* sp;
+	int failed;
+} asea_typed_call;
+
+typedef struct asea_method_cache_entry {
+	asCObjectType* type;
+	asCScriptFunction* fn;
+	struct asea_method_cache_entry* next_allocated;
+} asea_method_cache_entry;
+
+typedef struct asea_method_cache {
+	asea_method_cache_entry* entries[4];
+	asea_method_cache_entry* allocated;
+	asPWORD allocation_count;
+	asPWORD next_replaced;
+} asea_method_cache;
+
 static asea_i2f asea_i2f_inst;
 static asea_i2f64 asea_i2f64_inst;
 )___"
@@ -173,14 +201,36 @@ static asea_i2f64 asea_i2f64_inst;
 void asea_call_script_function(asSVMRegisters* vm_registers, void* function);
 int asea_prepare_script_stack(asSVMRegisters* vm_registers, void* function, void* pc, void* sp, void *fp);
 int asea_prepare_script_stack_and_vars(asSVMRegisters* vm_registers, void* function, void* pc, void* sp, void *fp);
+int asea_prepare_script_stack_shadow(asSVMRegisters* vm_registers, void* function, void* pc, void* sp, void *fp, asea_shadow_frame* frame, asea_shadow_frame* parent);
+int asea_prepare_script_stack_shadow_and_vars(asSVMRegisters* vm_registers, void* function, void* pc, void* sp, void *fp, asea_shadow_frame* frame, asea_shadow_frame* parent);
+void asea_materialize_shadow_frames(asSVMRegisters* vm_registers, asea_shadow_frame* frame);
+int asea_remaining_call_depth(asSVMRegisters* vm_registers, asea_shadow_frame* shadow, int max_depth);
+asQWORD asea_call_script_nested(asSVMRegisters* vm_registers, asea_typed_call* call, asCScriptFunction* fn, asDWORD* args);
 void asea_debug_message(asSVMRegisters* vm_registers, const char* text);
 void asea_debug_int(asSVMRegisters* vm_registers, asPWORD x);
 void asea_set_internal_exception(asSVMRegisters* vm_registers, const char* text);
+int asea_process_suspend(asSVMRegisters* vm_registers);
+int asea_check_call_status(asSVMRegisters* vm_registers);
 float fmodf(float a, float b);
 double fmod(double a, double b);
+asCScriptFunction* asea_resolve_function_handle(asCScriptFunction* fn, void** delegate_object);
+asCScriptFunction* asea_resolve_interface_method(asea_method_cache* cache, asCScriptObject* obj, asCScriptFunction* interface_fn);
+asCScriptFunction* asea_resolve_bound_function(asSVMRegisters* vm_registers, int import_id);
+int asea_powi(int base, int exponent, int* overflow);
+asDWORD asea_powu(asDWORD base, asDWORD exponent, int* overflow);
+asINT64 asea_powi64(asINT64 base, asINT64 exponent, int* overflow);
+asQWORD asea_powu64(asQWORD base, asQWORD exponent, int* overflow);
+float asea_powf(float base, float exponent, int* overflow);
+double asea_powd(double base, double exponent, int* overflow);
+double asea_powdi(double base, int exponent, int* overflow);
 void asea_clean_args(asSVMRegisters* vm_registers, void* function, asDWORD* args);
 int asea_call_system_function(asSVMRegisters* vm_registers, int fn);
+void asea_call_generic_guarded(asSVMRegisters* vm_registers, void (*fn)(asea_generic*), asea_generic* generic);
+asQWORD asea_call_native_guarded(asSVMRegisters* vm_registers, void* fn, const asQWORD* args, int arg_count);
+float asea_call_native_guarded_f32(asSVMRegisters* vm_registers, void* fn, const asQWORD* args, int arg_count);
+double asea_call_native_guarded_f64(asSVMRegisters* vm_registers, void* fn, const asQWORD* args, int arg_count);
 int asea_call_object_method(asSVMRegisters* vm_registers, void* obj, int fn);
+void asea_destroy_list(asSVMRegisters* vm_registers, void* list, asCObjectType* list_type);
 void* asea_new_script_object(asCObjectType* obj_type);
 void asea_cast(asSVMRegisters* vm_registers, asCScriptObject* obj, asDWORD type_id);
 void* asea_alloc(asQWORD size);
@@ -201,6 +251,8 @@ constexpr const char* angelsea_c_header_offsets =
 extern const asPWORD asea_offset_ctx_status;
 extern const asPWORD asea_offset_ctx_currentfn;
 extern const asPWORD asea_offset_ctx_stackindex;
+extern const asPWORD asea_offset_scriptfn_functype;
+extern const asPWORD asea_offset_scriptfn_id;
 )___";
 
 } // namespace angelsea::detail
@@ -13,6 +13,18 @@ struct FnConfig {
 	bool dump_c : 1               = false;
 };
 
+/// Describes properties of a registered system function that the JIT cannot figure out by itself, allowing it to emit
+/// cheaper calls to it. See \ref Jit::SetSystemFunctionTraits.
+///
+/// Declaring a property that the function does not actually have is undefined behavior.
+struct SystemFunctionTraits {
+	/// The function never throws a C++ exception.
+	bool nothrow : 1 = false;
+	/// The function never uses the active script context: it does not inspect it (e.g. its call stack or variables),
+	/// does not suspend it, does not set a script exception on it and does not execute scripts.
+	bool no_context_access : 1 = false;
+};
+
 /// Parses one function metadata entry, e.g. as obtained from
 /// https://www.angelcode.com/angelscript/sdk/docs/manual/doc_addon_build.html#doc_addon_build_metadata
 /// If using this method, you would call \ref parse_function_metadata once per metadata entry.
@@ -0,0 +1,91 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+#pragma once
+
+#include <angelscript.h>
+#include <bit>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace angelsea {
+
+class Jit;
+
+/// C code that the JIT emits in place of calls to a registered system function, see \ref
+/// Jit::SetSystemFunctionIntrinsic.
+///
+/// The code is evaluated within JIT code, so it must not throw, nor use the script context.
+struct SystemFunctionIntrinsic {
+	/// C expression that evaluates to the return value of the function, or that is evaluated for its side effects if
+	/// the function returns `void`.
+	///
+	/// `$0`, `$1`, etc. are replaced with the arguments of the function, with the same C types as with the native
+	/// calling convention (e.g. `float`, `asINT32`, or `void*` for references and handles). `$this` is replaced with
+	/// the script object the function is called on (as a `void*`) for methods and functions registered with an object
+	/// parameter. For methods called on an auxiliary object (e.g. `asCALL_THISCALL_OBJFIRST`), this is still the
+	/// script object rather than the auxiliary object, and `$this` cannot be used with `asCALL_THISCALL_ASGLOBAL`.
+	/// Arguments may be evaluated any number of times.
+	std::string expression;
+
+	/// C code emitted once per module before the first use of \ref expression, e.g. `static inline` helper functions
+	/// or prototypes for \ref symbols.
+	std::string definitions = {};
+
+	/// Native symbols that \ref definitions declares as `extern`, with their address.
+	std::vector<std::pair<std::string, void*>> symbols = {};
+};
+
+/// Registers intrinsics for the functions of the `scriptmath` add-on (e.g. `sqrt`, `cos` or `abs`) that are registered
+/// to `engine`, so that calls to them directly call the C math library.
+///
+/// Only functions registered with the native calling convention and bound to the C math library function itself are
+/// affected, so this is safe to call even if some of these names are bound to other functions.
+void register_script_math_intrinsics(Jit& jit, asIScriptEngine& engine);
+
+namespace detail {
+
+/// Makes `jit` use `intrinsic` for `fn` if it is registered with a native calling convention and bound to `method`.
+void set_intrinsic_if_bound_to(
+    Jit&                    jit,
+    asIScriptFunction*      fn,
+    const asSFuncPtr&       method,
+    SystemFunctionIntrinsic intrinsic
+);
+
+template<class ScriptArray> asUINT script_array_size(const void* array) {
+	return static_cast<const ScriptArray*>(array)->GetSize();
+}
+
+} // namespace detail
+
+/// Registers intrinsics for the accessors of the default array type registered by the `scriptarray` add-on to
+/// `engine` (`length()` and `isEmpty()`), so that calls to them directly read the size of the array.
+///
+/// `ScriptArray` is the `CScriptArray` class of the add-on, which angelsea does not build itself. Like \ref
+/// register_script_math_intrinsics, only methods bound to the add-on's own implementation are affected.
+template<class ScriptArray> void register_script_array_intrinsics(Jit& jit, asIScriptEngine& engine) {
+	asITypeInfo* array_type = engine.GetTypeInfoById(engine.GetDefaultArrayTypeId());
+	if (array_type == nullptr) {
+		return;
+	}
+
+	const std::vector<std::pair<std::string, void*>> symbols
+	    = {{"asea_script_array_size", std::bit_cast<void*>(&detail::script_array_size<ScriptArray>)}};
+	const std::string definitions = "asUINT asea_script_array_size(void*);";
+
+	detail::set_intrinsic_if_bound_to(
+	    jit,
+	    array_type->GetMethodByDecl("uint length() const"),
+	    asMETHOD(ScriptArray, GetSize),
+	    {.expression = "asea_script_array_size($this)", .definitions = definitions, .symbols = symbols}
+	);
+	detail::set_intrinsic_if_bound_to(
+	    jit,
+	    array_type->GetMethodByDecl("bool isEmpty() const"),
+	    asMETHOD(ScriptArray, IsEmpty),
+	    {.expression = "asea_script_array_size($this) == 0", .definitions = definitions, .symbols = symbols}
+	);
+}
+
+} // namespace angelsea
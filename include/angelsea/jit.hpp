@@ -5,6 +5,7 @@
 #include <angelscript.h>
 #include <angelsea/config.hpp>
 #include <angelsea/fnconfig.hpp>
+#include <angelsea/intrinsics.hpp>
 #include <functional>
 #include <memory>
 
@@ -57,6 +58,21 @@ class Jit final : public asIJITCompilerV2 {
 	/// callback to be called, and never again after.
 	void DiscoverFnConfig();
 
+	/// Declares properties of the registered system function `function_id`, e.g. as returned by
+	/// `RegisterGlobalFunction`. Calls to it from JIT code can then skip saving the VM state, checking for suspends and
+	/// handling exceptions where the traits allow it.
+	///
+	/// This only affects functions that are compiled afterwards, so this should be called before building modules.
+	void SetSystemFunctionTraits(int function_id, SystemFunctionTraits traits);
+
+	/// Makes JIT code evaluate `intrinsic` in place of calls to the registered system function `function_id`, which
+	/// lets the C compiler inline the operation. The intrinsic implies the nothrow and no_context_access \ref
+	/// SystemFunctionTraits. See also \ref register_script_math_intrinsics.
+	///
+	/// Intrinsics are only used for functions registered with a native calling convention. Calls that cannot use the
+	/// intrinsic go through the regular system call path. Like traits, this only affects functions compiled afterwards.
+	void SetSystemFunctionIntrinsic(int function_id, SystemFunctionIntrinsic intrinsic);
+
 	private:
 	std::unique_ptr<detail::MirJit> m_compiler;
 };
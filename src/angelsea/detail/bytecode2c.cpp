@@ -10,6 +10,7 @@
 #include <angelsea/detail/bytecodeinstruction.hpp>
 #include <angelsea/detail/bytecodetools.hpp>
 #include <angelsea/detail/debug.hpp>
+#include <angelsea/detail/frameanalysis.hpp>
 #include <angelsea/detail/log.hpp>
 #include <angelsea/detail/runtimeheader.hpp>
 #include <angelsea/detail/stringutil.hpp>
@@ -24,6 +25,8 @@
 #include <deque>
 #include <fmt/format.h>
 #include <fmt/ranges.h>
+#include <map>
+#include <optional>
 #include <variant>
 
 #define DIRECT_VALUE_IF_POSSIBLE(var) (m_config->c.emit_hardcoded_vm_offsets ? fmt::to_string(var) : #var)
@@ -116,9 +119,15 @@ void BytecodeToC::translate_function(std::string_view internal_module_name, asIS
 	    .stack_push_infos         = {},    // populated by discover_function_call_pushes
 	    .fn_to_stack_push         = {},    // ^
 	    .overriden_instructions   = {},    // populated by several passes, but primarily discover_peephole
+	    .ir                       = {},    // populated by build_ir
 	    .emitted_symbols          = {},    // populated by whatever emits extern declarations
 	    .has_direct_generic_call  = false, // populated by discover_function_calls
 	    .error_handlers_mask      = 0,     // populated by any translate_instruction
+	    .label_prefix             = "bc",
+	    .inline_info              = nullptr,
+	    .is_typed_entry           = false,
+	    .pending_push_dwords      = 0,
+	    .pending_push_pwords      = 0,
 	};
 
 	discover_switch_map(state);
@@ -129,6 +138,28 @@ void BytecodeToC::translate_function(std::string_view internal_module_name, asIS
 		discover_function_call_pushes(state);
 	}
 	discover_peephole(state);
+	discover_promotable_variables(state);
+	build_ir(state);
+
+	if (uses_shadow_call_stack()) {
+		asPWORD max_entry_label = 1;
+		for (InsRef ins : get_bytecode(fn)) {
+			if (ins.opcode() == asBC_JitEntry) {
+				max_entry_label = std::max(max_entry_label, ins.pword0());
+			}
+		}
+
+		// direct JIT calls pass a tagged pointer to the shadow frame of the caller instead of a regular entry label,
+		// see emit_direct_script_call_ins
+		emit(
+		    "\tasea_shadow_frame* shadow = 0;\n"
+		    "\tif (entryLabel > {MAX_ENTRY}) {{\n"
+		    "\t\tshadow = (asea_shadow_frame*)(entryLabel & ~(asPWORD)1);\n"
+		    "\t\tentryLabel = 1;\n"
+		    "\t}}\n",
+		    fmt::arg("MAX_ENTRY", max_entry_label)
+		);
+	}
 
 	if (m_config->experimental_direct_generic_call /* && state.has_direct_generic_call*/) {
 		// FIXME: has_direct_generic_call is broken with refcpyv
@@ -159,6 +190,7 @@ void BytecodeToC::translate_function(std::string_view internal_module_name, asIS
 		);
 	}
 
+	emit_promoted_variables_load(state);
 	emit_entry_dispatch(state);
 
 	for (InsRef ins : get_bytecode(fn)) {
@@ -169,6 +201,87 @@ void BytecodeToC::translate_function(std::string_view internal_module_name, asIS
 	emit_error_handlers(state);
 
 	emit("}}\n");
+
+	// other modules call the typed entry point of this function through its slot, see emit_typed_script_call
+	auto& script_fn = static_cast<asCScriptFunction&>(fn);
+	if (can_use_typed_entry(script_fn)) {
+		const std::string typed_entry = emit_typed_entry(state, script_fn);
+		if (m_on_map_typed_entry_callback) {
+			m_on_map_typed_entry_callback(fn, typed_entry);
+		}
+	}
+}
+
+BytecodeToC::CompileCostEstimate BytecodeToC::estimate_compile_cost(asIScriptFunction& fn) const {
+	CompileCostEstimate estimate;
+
+	// this mirrors (roughly) what discover_switch_map and discover_branch_targets compute, but we cannot rely on JIT
+	// entries being configured yet, so assume all of them are live. this is pessimistic, but only slightly so.
+	std::unordered_set<std::size_t> branch_targets;
+	bool                            in_switch = false;
+
+	for (InsRef ins : get_bytecode(fn)) {
+		++estimate.instruction_count;
+
+		switch (ins.opcode()) {
+		case asBC_JMPP: {
+			in_switch = true;
+			continue;
+		}
+		case asBC_JMP: {
+			if (in_switch) {
+				++estimate.switch_case_count;
+				branch_targets.emplace(ins.offset + ins.size() + ins.int0());
+				continue;
+			}
+			break;
+		}
+		case asBC_JitEntry: {
+			branch_targets.emplace(ins.offset);
+			break;
+		}
+		case asBC_CALL:
+		case asBC_CALLSYS:
+		case asBC_CALLINTF:
+		case asBC_CALLBND:
+		case asBC_CallPtr:
+		case asBC_Thiscall1: {
+			++estimate.call_count;
+			break;
+		}
+		case asBC_ALLOC:
+		case asBC_FREE: {
+			++estimate.allocation_count;
+			break;
+		}
+		default: break;
+		}
+
+		in_switch = false;
+
+		if (auto jmp = bcins::try_as<bcins::Jump>(ins); jmp.has_value()) {
+			branch_targets.emplace(jmp->target_offset());
+		}
+	}
+
+	estimate.branch_target_count = branch_targets.size();
+
+	const auto& script_fn = static_cast<asCScriptFunction&>(fn);
+	if (script_fn.scriptData != nullptr) {
+		estimate.variable_count = script_fn.scriptData->variableSpace;
+	}
+
+	const auto& model = m_config->compile_cost;
+	estimate.cost     = (double(estimate.instruction_count) * model.per_instruction)
+	              + (double(estimate.branch_target_count) * model.per_branch_target)
+	              + (double(estimate.switch_case_count) * model.per_switch_case)
+	              + (double(estimate.call_count) * model.per_call)
+	              + (double(estimate.allocation_count) * model.per_allocation)
+	              + (double(estimate.variable_count) * model.per_variable)
+	              + (double(estimate.variable_count) * double(estimate.branch_target_count)
+	                 * model.per_variable_branch_target);
+
+	return estimate;
 }
 
 std::string BytecodeToC::create_new_entry_point_name([[maybe_unused]] asIScriptFunction& fn) {
@@ -216,13 +329,11 @@ void BytecodeToC::configure_jit_entries(FnState& state) {
 		// consider skipping some JitEntry we believe the VM should never be hitting. this is useful to avoid
 		// pessimizing optimizations, so that the optimizer can merge subsequent basic blocks.
 		switch (ins.opcode()) {
-		case asBC_SUSPEND: // TODO: falls back as of writing, remove when fixed
-			is_trace_supported = m_config->hack_ignore_suspend;
-			break;
-
 			// assume script calls can always fallback
 		case asBC_CALL:
 		case asBC_CALLINTF:
+		case asBC_CallPtr:
+		case asBC_CALLBND:
 		// TODO: those only have partial support and can fallback to the vm
 		// TODO: asBC_ALLOC should only be considered a possible fallback for script entities even after they are
 		// implemented because we yield back to the VM just like asBC_CALL in that case anyway
@@ -231,22 +342,8 @@ void BytecodeToC::configure_jit_entries(FnState& state) {
 		// TODO: all of those are not implemented as of writing, remove when fixed
 		case asBC_SwapPtr:
 		case asBC_LdGRdR4:
-		case asBC_CALLBND:
-		case asBC_CallPtr:
 		case asBC_ChkRefS:
-		case asBC_ClrHi:
-		case asBC_FuncPtr:
-		case asBC_AllocMem:
-		case asBC_SetListSize:
-		case asBC_PshListElmnt:
-		case asBC_SetListType:
-		case asBC_POWi:
-		case asBC_POWu:
-		case asBC_POWf:
-		case asBC_POWd:
-		case asBC_POWdi:
-		case asBC_POWi64:
-		case asBC_POWu64:       is_trace_supported = false; break;
+		case asBC_ClrHi:        is_trace_supported = false; break;
 
 		// only skip if it's a known instruction as of writing
 		default:                is_trace_supported = ins.opcode() <= asBC_Thiscall1;
@@ -256,7 +353,8 @@ void BytecodeToC::configure_jit_entries(FnState& state) {
 		// instructions, and AS should always be emitting a jit entry at _some point_ before
 
 		// NOTE: we shouldn't remove the jitentry after an asBC_CALL because it's not unlikely the callee is going
-		// to want to return execution to the VM -- in that case, we always immediately return to the VM
+		// to want to return execution to the VM -- in that case, we return to the VM, which enters again through the
+		// jitentry once the callee returns
 	}
 
 	state.has_any_late_jit_entries = jit_entry_id > 2; // because of the increment
@@ -365,6 +463,174 @@ void BytecodeToC::discover_peephole(FnState& state) {
 	}
 }
 
+/// Name of the C local that holds a promoted frame variable, see \ref BytecodeToC::discover_promotable_variables.
+static std::string promoted_variable_name(int offset) {
+	return offset > 0 ? fmt::format("var{}", offset) : fmt::format("var_arg{}", -offset);
+}
+
+/// Offset in dwords below `sp` of the last pending push, see \ref BytecodeToC::emit_virtual_stack_push.
+static std::string pending_push_offset(int dwords, int pwords) {
+	if (pwords == 0) {
+		return std::to_string(dwords);
+	}
+	return fmt::format("({} + {} * (sizeof(asPWORD) / 4))", dwords, pwords);
+}
+
+void BytecodeToC::discover_promotable_variables(FnState& state) {
+	m_module_state.promoted_variables.clear();
+
+	if (m_config->experimental_promote_frame_variables) {
+		m_module_state.promoted_variables = find_promotable_variables(*state.fn);
+	}
+}
+
+void BytecodeToC::build_ir(FnState& state) {
+	// instructions that fall back to the VM must not be optimized out, and the VM may observe the stack frame
+	std::vector<asEBCInstr> opaque_opcodes{m_config->debug.fallback_after_instruction};
+#ifndef ASEA_NO_DEBUG
+	opaque_opcodes.insert(
+	    opaque_opcodes.end(),
+	    m_config->debug.blacklist_instructions.begin(),
+	    m_config->debug.blacklist_instructions.end()
+	);
+#endif
+
+	state.ir = ir::build_function(*state.fn, state.switch_map, opaque_opcodes);
+	ir::eliminate_redundant_null_checks(*state.ir);
+
+	if (m_config->experimental_ir_optimizations) {
+		ir::optimize(*state.ir);
+	}
+}
+
+/// Returns a literal of `type` from the raw bits of an integral constant.
+static std::string integer_literal(std::uint64_t bits, VarType type) {
+	if (type.size == 8) {
+		return fmt::format("({}){}ull", type.c, bits);
+	}
+	if (type == var_types::s32) {
+		return imm_int(std::int32_t(std::uint32_t(bits)), type);
+	}
+	return imm_int(std::uint32_t(bits), type);
+}
+
+void BytecodeToC::emit_ir_instruction(FnState& state, const ir::Instruction& ins) {
+	using namespace var_types;
+
+	const ir::Value& result    = state.ir->values[*ins.result];
+	const VarType    bits_type = result.type->size == 8 ? u64 : u32;
+
+	if (!result.is_live) {
+		if (m_config->c.human_readable) {
+			emit("\t\t/* eliminated dead store */\n");
+		}
+		return;
+	}
+
+	if (result.constant.has_value()) {
+		emit_frame_var_bits_store(state, result.variable, bits_type, integer_literal(*result.constant, bits_type));
+		return;
+	}
+
+	// floating-point constants are reinterpreted from their bits, as their literals could be inexact
+	const auto constant_expr = [&](std::uint64_t bits, VarType type, std::string_view name) {
+		if (!is_floating_point(type)) {
+			return integer_literal(bits, type);
+		}
+		emit(
+		    "\t\t{UNION} {NAME} = {{.i={BITS}}};\n",
+		    fmt::arg("UNION", type.size == 8 ? "asea_i2f64" : "asea_i2f"),
+		    fmt::arg("NAME", name),
+		    fmt::arg("BITS", integer_literal(bits, type.size == 8 ? u64 : u32))
+		);
+		return fmt::format("{}.f", name);
+	};
+
+	const auto operand_expr = [&](ir::ValueId id, VarType type, std::string_view name) {
+		const ir::Value& value = state.ir->values[id];
+		return value.constant.has_value() ? constant_expr(*value.constant, type, name)
+		                                  : frame_var(value.variable, type);
+	};
+
+	switch (ins.opcode) {
+	case ir::Opcode::CONSTANT:
+		emit_frame_var_bits_store(state, result.variable, ins.type, integer_literal(ins.immediate, ins.type));
+		break;
+
+	case ir::Opcode::COPY: {
+		const std::string src = frame_var_bits(state, state.ir->values[ins.operands[0]].variable, ins.type);
+		emit_frame_var_bits_store(state, result.variable, ins.type, src);
+		break;
+	}
+
+	case ir::Opcode::UNARY: {
+		const std::string src = operand_expr(ins.operands[0], ins.type, "src_c");
+		emit(
+		    "\t\t{DST} = {OP} {SRC};\n",
+		    fmt::arg("OP", ins.c_operator),
+		    fmt::arg("DST", frame_var(result.variable, ins.type)),
+		    fmt::arg("SRC", src)
+		);
+		break;
+	}
+
+	case ir::Opcode::BINARY: {
+		const std::string lhs = operand_expr(ins.operands[0], ins.type, "lhs_c");
+		const std::string rhs = ins.operands.size() > 1 ? operand_expr(ins.operands[1], ins.rhs_type, "rhs_c")
+		                                                : constant_expr(ins.immediate, ins.rhs_type, "rhs_c");
+		emit(
+		    "\t\t{DST} = {LHS} {OP} {RHS};\n",
+		    fmt::arg("OP", ins.c_operator),
+		    fmt::arg("DST", frame_var(result.variable, ins.type)),
+		    fmt::arg("LHS", lhs),
+		    fmt::arg("RHS", rhs)
+		);
+		break;
+	}
+
+	default: angelsea_assert(false && "instruction is not modelled by the IR");
+	}
+}
+
+void BytecodeToC::emit_promoted_variables_load([[maybe_unused]] FnState& state) {
+	for (const auto& [offset, type] : m_module_state.promoted_variables) {
+		emit(
+		    "\t{TYPE} {NAME} = {VAR};\n",
+		    fmt::arg("TYPE", type.c),
+		    fmt::arg("NAME", promoted_variable_name(offset)),
+		    fmt::arg("VAR", frame_var(std::to_string(offset), type))
+		);
+	}
+}
+
+std::string BytecodeToC::promoted_variables_spill_code(std::string_view indent) {
+	std::string code;
+	for (const auto& [offset, type] : m_module_state.promoted_variables) {
+		emit_to(
+		    code,
+		    "{INDENT}{VAR} = {NAME};\n",
+		    fmt::arg("INDENT", indent),
+		    fmt::arg("VAR", frame_var(std::to_string(offset), type)),
+		    fmt::arg("NAME", promoted_variable_name(offset))
+		);
+	}
+	return code;
+}
+
+std::string BytecodeToC::promoted_variables_reload_code(std::string_view indent) {
+	std::string code;
+	for (const auto& [offset, type] : m_module_state.promoted_variables) {
+		emit_to(
+		    code,
+		    "{INDENT}{NAME} = {VAR};\n",
+		    fmt::arg("INDENT", indent),
+		    fmt::arg("NAME", promoted_variable_name(offset)),
+		    fmt::arg("VAR", frame_var(std::to_string(offset), type))
+		);
+	}
+	return code;
+}
+
 void BytecodeToC::emit_entry_dispatch(FnState& state) {
 	if (!state.has_any_late_jit_entries) {
 		if (m_config->c.human_readable) {
@@ -404,8 +670,9 @@ void BytecodeToC::emit_error_handlers(FnState& state) {
 	};
 
 	if (requires_handler(ErrorHandler::ERR_NULL)) {
+		emit("\terr_null:\n");
+		emit_materialize_shadow_frames(state);
 		emit(
-		    "\terr_null:\n"
 		    "\t\tasea_set_internal_exception(_regs, \"" TXT_NULL_POINTER_ACCESS
 		    "\");\n"
 		    "\t\tgoto vm;\n"
@@ -415,8 +682,9 @@ void BytecodeToC::emit_error_handlers(FnState& state) {
 	}
 
 	if (requires_handler(ErrorHandler::ERR_DIVIDE_BY_ZERO)) {
+		emit("\terr_divide_by_zero:\n");
+		emit_materialize_shadow_frames(state);
 		emit(
-		    "\terr_divide_by_zero:\n"
 		    "\t\tasea_set_internal_exception(_regs, \"" TXT_DIVIDE_BY_ZERO
 		    "\");\n"
 		    "\t\tgoto vm;\n"
@@ -426,8 +694,9 @@ void BytecodeToC::emit_error_handlers(FnState& state) {
 	}
 
 	if (requires_handler(ErrorHandler::ERR_DIVIDE_OVERFLOW)) {
+		emit("\terr_divide_overflow:\n");
+		emit_materialize_shadow_frames(state);
 		emit(
-		    "\terr_divide_overflow:\n"
 		    "\t\tasea_set_internal_exception(_regs, \"" TXT_DIVIDE_OVERFLOW
 		    "\");\n"
 		    "\t\tgoto vm;\n"
@@ -436,8 +705,22 @@ void BytecodeToC::emit_error_handlers(FnState& state) {
 		state.error_handlers_mask |= std::uint64_t(ErrorHandler::VM_FALLBACK);
 	}
 
+	if (requires_handler(ErrorHandler::ERR_POW_OVERFLOW)) {
+		emit("\terr_pow_overflow:\n");
+		emit_materialize_shadow_frames(state);
+		emit(
+		    "\t\tasea_set_internal_exception(_regs, \"" TXT_POW_OVERFLOW
+		    "\");\n"
+		    "\t\tgoto vm;\n"
+		    "\t\n"
+		);
+		state.error_handlers_mask |= std::uint64_t(ErrorHandler::VM_FALLBACK);
+	}
+
 	if (requires_handler(ErrorHandler::VM_FALLBACK)) {
 		emit("\tvm:\n");
+		emit_materialize_shadow_frames(state);
+		emit("{}", promoted_variables_spill_code("\t\t"));
 		emit_save_sp(state);
 		emit("\treturn;\n");
 	}
@@ -456,15 +739,25 @@ void BytecodeToC::translate_instruction(FnState& state) {
 	using namespace var_types;
 	auto& ins = state.ins;
 
+	// consecutive stack pushes do not adjust sp, see emit_virtual_stack_push. any other instruction and any branch
+	// target expects an up-to-date sp. pushes are lowered below, before the main switch, so that anything that is not
+	// lowered as a virtual push is guaranteed to flush.
+	const bool is_virtual_push = !is_instruction_blacklisted(ins.opcode())
+	                          && !state.overriden_instructions.contains(ins.offset)
+	                          && bcins::is_specific_ins<bcins::StackPush>(ins);
+	if (!is_virtual_push || state.branch_targets.contains(ins.offset)) {
+		emit_flush_virtual_stack(state);
+	}
+
 	if (m_config->c.human_readable) {
 		emit("\t/* bytecode: {} */\n", disassemble(*m_script_engine, ins));
 	}
 
 	if (state.branch_targets.contains(ins.offset)) {
-		emit("\tbc{}: {{\n", ins.offset);
+		emit("\t{}{}: {{\n", state.label_prefix, ins.offset);
 	} else {
 		if (m_config->c.human_readable) {
-			emit("\t/* bc{}: */ {{\n", ins.offset);
+			emit("\t/* {}{}: */ {{\n", state.label_prefix, ins.offset);
 		} else {
 			emit("\t{{\n");
 		}
@@ -482,15 +775,17 @@ void BytecodeToC::translate_instruction(FnState& state) {
 		    make_local_from_operand(state, "rhs", fused.compare.rhs);
 		    if (m_config->c.use_builtin_expect) {
 			    emit(
-			        "\t\tif (__builtin_expect(lhs {OP} rhs, {EXPECTED_BRANCH_VALUE})) {{ goto bc{TARGET}; }}\n",
+			        "\t\tif (__builtin_expect(lhs {OP} rhs, {EXPECTED_BRANCH_VALUE})) {{ goto {PREFIX}{TARGET}; }}\n",
 			        fmt::arg("OP", fused.jump.cond_expr->c_comparison_op),
+			        fmt::arg("PREFIX", state.label_prefix),
 			        fmt::arg("TARGET", fused.jump.target_offset()),
 			        fmt::arg("EXPECTED_BRANCH_VALUE", fused.jump.target_offset() < int(state.ins.offset) ? 1 : 0)
 			    );
 		    } else {
 			    emit(
-			        "\t\tif (lhs {OP} rhs) {{ goto bc{TARGET}; }}\n",
+			        "\t\tif (lhs {OP} rhs) {{ goto {PREFIX}{TARGET}; }}\n",
 			        fmt::arg("OP", fused.jump.cond_expr->c_comparison_op),
+			        fmt::arg("PREFIX", state.label_prefix),
 			        fmt::arg("TARGET", fused.jump.target_offset())
 			    );
 		    }
@@ -508,43 +803,36 @@ void BytecodeToC::translate_instruction(FnState& state) {
 		}
 
 		std::visit(virt_visitor, virt_it->second);
+		emit_instruction_footer(state);
+		return;
+	}
 
-		// TODO: dedup footer here
-		if (ins.opcode() == m_config->debug.fallback_after_instruction) {
-			emit_vm_fallback(state, "debug.fallback_after_instruction");
-		}
-
-		emit("\t}}\n");
+	if (is_virtual_push) {
+		emit_stack_push_ins(state, bcins::StackPush{ins});
+		emit_instruction_footer(state);
 		return;
 	}
 
+	if (m_config->experimental_ir_optimizations && state.ir.has_value()) {
+		const ir::Instruction* ir_ins = state.ir->find_instruction(ins.offset);
+		if (ir_ins != nullptr && ir_ins->opcode != ir::Opcode::OPAQUE && ir_ins->opcode != ir::Opcode::NULL_CHECK) {
+			emit_ir_instruction(state, *ir_ins);
+			emit_instruction_footer(state);
+			return;
+		}
+	}
+
 	switch (ins.opcode()) {
 	case asBC_JitEntry: break;
 	case asBC_STR:      emit_vm_fallback(state, "deprecated instruction"); break;
 
 	case asBC_SUSPEND:  {
-		if (m_config->hack_ignore_suspend) {
-			break;
+		if (!m_config->hack_ignore_suspend) {
+			emit_suspend_ins(state);
 		}
-		emit_vm_fallback(state, "SUSPEND is not implemented yet");
 		break;
 	}
 
-	case asBC_TYPEID:
-	case asBC_PshC4:
-	case asBC_PshV4:
-	case asBC_PshG4:
-	case asBC_PshC8:
-	case asBC_PshV8:
-	case asBC_VAR:
-	case asBC_PshNull:
-	case asBC_PshVPtr:
-	case asBC_PshGPtr:
-	case asBC_PshRPtr:
-	case asBC_PSF:
-	case asBC_PGA:
-	case asBC_OBJTYPE: emit_stack_push_ins(state, bcins::StackPush{ins}); break;
-
 	case asBC_PopRPtr: {
 		emit(
 		    "\t\tvalue_reg = sp->as_asPWORD;\n"
@@ -575,14 +863,7 @@ void BytecodeToC::translate_instruction(FnState& state) {
 		break;
 	}
 
-	case asBC_ChkNullV: {
-		emit(
-		    "\t\tif ({VAR} == 0) {{ {ERR_NULL_HANDLER} }}\n",
-		    fmt::arg("ERR_NULL_HANDLER", jump_to_error_handler_code(state, ErrorHandler::ERR_NULL)),
-		    fmt::arg("VAR", frame_var(ins.sword0(), pword))
-		);
-		break;
-	}
+	case asBC_ChkNullV: emit("{}", null_check_code(state, frame_var(ins.sword0(), pword))); break;
 
 	case asBC_ChkNullS: {
 		emit(
@@ -639,11 +920,6 @@ void BytecodeToC::translate_instruction(FnState& state) {
 		auto*             type = std::bit_cast<asCObjectType*>(ins.pword0());
 		asSTypeBehaviour& beh  = type->beh;
 
-		if ((type->flags & asOBJ_LIST_PATTERN) != 0) {
-			emit_vm_fallback(state, "Can't handle FREE of list patterns yet");
-			break;
-		}
-
 		emit(
 		    "\t\tasPWORD *a = &{}, v = *a;\n"
 		    "\t\tif (v) {{\n",
@@ -662,7 +938,15 @@ void BytecodeToC::translate_instruction(FnState& state) {
 				    state,
 				    {.fn_idx = beh.destruct, .object_pointer_override = "(void*)v", .is_internal_call = true}
 				);
-			} // TODO: LIST_PATTERN
+			} else if ((type->flags & asOBJ_LIST_PATTERN) != 0) {
+				// releasing the elements may run arbitrary code
+				emit_save_sp(state);
+				emit_save_pc(state, true);
+				emit(
+				    "\t\t\tasea_destroy_list(_regs, (void*)v, (asCObjectType*)&{LIST_TYPE});\n",
+				    fmt::arg("LIST_TYPE", emit_type_info_lookup(state, *type))
+				);
+			}
 			emit("\t\t\tasea_free((void*)v);\n");
 		}
 		emit(
@@ -673,6 +957,39 @@ void BytecodeToC::translate_instruction(FnState& state) {
 		break;
 	}
 
+	// list buffers, as used by initialization lists, are zeroed so that the elements can be safely destroyed at any
+	// point, see asCScriptEngine::DestroyList
+	case asBC_AllocMem: {
+		emit(
+		    "\t\tvoid* list = asea_alloc({SIZE});\n"
+		    "\t\tmemset(list, 0, {SIZE});\n"
+		    "\t\t{VAR} = (asPWORD)list;\n",
+		    fmt::arg("SIZE", ins.dword0()),
+		    fmt::arg("VAR", frame_var(ins.sword0(), pword))
+		);
+		break;
+	}
+
+	case asBC_SetListSize:
+	case asBC_SetListType: {
+		emit(
+		    "\t\t*(asUINT*)((char*){LIST} + {OFFSET}) = {VALUE};\n",
+		    fmt::arg("LIST", frame_var(ins.sword0(), pword)),
+		    fmt::arg("OFFSET", ins.dword0()),
+		    fmt::arg("VALUE", imm_int(ins.dword0(1), u32))
+		);
+		break;
+	}
+
+	case asBC_PshListElmnt: {
+		emit_stack_push(
+		    state,
+		    fmt::format("(asPWORD)((char*){} + {})", frame_var(ins.sword0(), pword), ins.dword0()),
+		    pword
+		);
+		break;
+	}
+
 	case asBC_COPY: {
 		emit(
 		    "\t\tvoid *dst = sp->as_ptr;\n"
@@ -690,17 +1007,25 @@ void BytecodeToC::translate_instruction(FnState& state) {
 	// V1/V2 are equivalent to V4
 	case asBC_SetV1:
 	case asBC_SetV2:
-	case asBC_SetV4:    emit_assign_ins(state, frame_var(ins.sword0(), u32), imm_int(ins.dword0(), u32)); break;
-	case asBC_SetV8:    emit_assign_ins(state, frame_var(ins.sword0(), u64), imm_int(ins.qword0(), u64)); break;
+	case asBC_SetV4:    emit_frame_var_bits_store(state, ins.sword0(), u32, imm_int(ins.dword0(), u32)); break;
+	case asBC_SetV8:    emit_frame_var_bits_store(state, ins.sword0(), u64, imm_int(ins.qword0(), u64)); break;
 
 	case asBC_ClrVPtr:  emit_assign_ins(state, frame_var(ins.sword0(), pword), "0"); break;
 
-	case asBC_CpyVtoR4: emit_assign_ins(state, "value_reg", frame_var(ins.sword0(), u32)); break;
-	case asBC_CpyRtoV4: emit_assign_ins(state, frame_var(ins.sword0(), u32), "value_reg"); break;
-	case asBC_CpyVtoR8: emit_assign_ins(state, "value_reg", frame_var(ins.sword0(), u64)); break;
-	case asBC_CpyRtoV8: emit_assign_ins(state, frame_var(ins.sword0(), u64), "value_reg"); break;
-	case asBC_CpyVtoV4: emit_assign_ins(state, frame_var(ins.sword0(), u32), frame_var(ins.sword1(), u32)); break;
-	case asBC_CpyVtoV8: emit_assign_ins(state, frame_var(ins.sword0(), u64), frame_var(ins.sword1(), u64)); break;
+	case asBC_CpyVtoR4: emit_assign_ins(state, "value_reg", frame_var_bits(state, ins.sword0(), u32)); break;
+	case asBC_CpyRtoV4: emit_frame_var_bits_store(state, ins.sword0(), u32, "value_reg"); break;
+	case asBC_CpyVtoR8: emit_assign_ins(state, "value_reg", frame_var_bits(state, ins.sword0(), u64)); break;
+	case asBC_CpyRtoV8: emit_frame_var_bits_store(state, ins.sword0(), u64, "value_reg"); break;
+	case asBC_CpyVtoV4: {
+		const std::string src = frame_var_bits(state, ins.sword1(), u32);
+		emit_frame_var_bits_store(state, ins.sword0(), u32, src);
+		break;
+	}
+	case asBC_CpyVtoV8: {
+		const std::string src = frame_var_bits(state, ins.sword1(), u64);
+		emit_frame_var_bits_store(state, ins.sword0(), u64, src);
+		break;
+	}
 
 	case asBC_CpyVtoG4: {
 		std::string symbol = emit_global_lookup(state, std::bit_cast<void*>(ins.pword0()), true);
@@ -858,9 +1183,9 @@ void BytecodeToC::translate_instruction(FnState& state) {
 	case asBC_LoadRObjR: {
 		emit(
 		    "\t\tasPWORD base = {VAR};\n"
-		    "\t\tif (base == 0) {{ {ERR_NULL_HANDLER} }}\n"
+		    "{NULL_CHECK}"
 		    "\t\tvalue_reg = base + {SWORD1};\n",
-		    fmt::arg("ERR_NULL_HANDLER", jump_to_error_handler_code(state, ErrorHandler::ERR_NULL)),
+		    fmt::arg("NULL_CHECK", null_check_code(state, "base")),
 		    fmt::arg("VAR", frame_var(ins.sword0(), pword)),
 		    fmt::arg("SWORD1", ins.sword1())
 		);
@@ -879,9 +1204,9 @@ void BytecodeToC::translate_instruction(FnState& state) {
 	case asBC_LoadThisR: {
 		emit(
 		    "\t\tasPWORD base = {THIS};\n"
-		    "\t\tif (base == 0) {{ {ERR_NULL_HANDLER} }}\n"
+		    "{NULL_CHECK}"
 		    "\t\tvalue_reg = base + {SWORD0};\n",
-		    fmt::arg("ERR_NULL_HANDLER", jump_to_error_handler_code(state, ErrorHandler::ERR_NULL)),
+		    fmt::arg("NULL_CHECK", null_check_code(state, "base")),
 		    fmt::arg("THIS", frame_var(0, pword)),
 		    fmt::arg("SWORD0", ins.sword0())
 		);
@@ -891,8 +1216,12 @@ void BytecodeToC::translate_instruction(FnState& state) {
 	// FIXME: strict aliasing
 	case asBC_WRTV1: emit_assign_ins(state, "((asea_var*)value_reg)->as_asBYTE", frame_var(ins.sword0(), u8)); break;
 	case asBC_WRTV2: emit_assign_ins(state, "((asea_var*)value_reg)->as_asWORD", frame_var(ins.sword0(), u16)); break;
-	case asBC_WRTV4: emit_assign_ins(state, "((asea_var*)value_reg)->as_asDWORD", frame_var(ins.sword0(), u32)); break;
-	case asBC_WRTV8: emit_assign_ins(state, "((asea_var*)value_reg)->as_asQWORD", frame_var(ins.sword0(), u64)); break;
+	case asBC_WRTV4:
+		emit_assign_ins(state, "((asea_var*)value_reg)->as_asDWORD", frame_var_bits(state, ins.sword0(), u32));
+		break;
+	case asBC_WRTV8:
+		emit_assign_ins(state, "((asea_var*)value_reg)->as_asQWORD", frame_var_bits(state, ins.sword0(), u64));
+		break;
 
 	case asBC_RDR1:  {
 		emit(
@@ -910,8 +1239,8 @@ void BytecodeToC::translate_instruction(FnState& state) {
 		);
 		break;
 	}
-	case asBC_RDR4: emit_assign_ins(state, frame_var(ins.sword0(), u32), "((asea_var*)value_reg)->as_asDWORD"); break;
-	case asBC_RDR8: emit_assign_ins(state, frame_var(ins.sword0(), u64), "((asea_var*)value_reg)->as_asQWORD"); break;
+	case asBC_RDR4: emit_frame_var_bits_store(state, ins.sword0(), u32, "((asea_var*)value_reg)->as_asDWORD"); break;
+	case asBC_RDR8: emit_frame_var_bits_store(state, ins.sword0(), u64, "((asea_var*)value_reg)->as_asQWORD"); break;
 
 	case asBC_Cast: {
 		emit(
@@ -925,31 +1254,19 @@ void BytecodeToC::translate_instruction(FnState& state) {
 
 	case asBC_CALL:     emit_direct_script_call_ins(state, ScriptCallByIdx{ins.int0()}); break;
 	case asBC_CALLINTF: {
-		// TODO: devirtualization optimization using `final` like asllvm did -- in fact, could we infer `final`
-		// ourselves? i don't know if we can look at the descendants safely from within our module
-
-		const auto fn_idx = ins.int0();
-		// const std::string  fn_symbol = fmt::format("{}_scriptfn{}", m_c_symbol_prefix, fn_idx);
-		asCScriptFunction* virtual_fn = m_script_engine->scriptFunctions[fn_idx];
+		asCScriptFunction* virtual_fn = m_script_engine->scriptFunctions[ins.int0()];
 
 		if (virtual_fn->funcType == asFUNC_INTERFACE) {
-			// TODO: write tests with a few interfaces then implement
-			emit_vm_fallback(state, "Cannot handle interface calls yet");
-			break;
+			emit_interface_call_ins(state, *virtual_fn);
+		} else {
+			emit_virtual_call_ins(state, *virtual_fn);
 		}
+		break;
+	}
 
-		// FIXME: if v_obj is null then null exception
-
-		emit(
-		    "\t\tasCScriptObject* v_obj = sp->as_ptr;\n"
-		    "\t\tasITypeInfo* v_obj_type = *(asITypeInfo**)((char*)v_obj + {OFF_SCRIPTOBJ_OBJTYPE});\n"
-		    "\t\tasea_array* v_vftable = (asea_array*)((char*)v_obj_type + {OFF_OBJTYPE_VFTABLE});\n"
-		    "\t\tasCScriptFunction* v_fn = ((asCScriptFunction**)(v_vftable->ptr))[{VTABLE_IDX}];\n",
-		    fmt::arg("OFF_SCRIPTOBJ_OBJTYPE", DIRECT_VALUE_IF_POSSIBLE(asea_offset_scriptobj_objtype)),
-		    fmt::arg("OFF_OBJTYPE_VFTABLE", DIRECT_VALUE_IF_POSSIBLE(asea_offset_objtype_vtable)),
-		    fmt::arg("VTABLE_IDX", virtual_fn->vfTableIdx)
-		);
-		emit_direct_script_call_ins(state, ScriptCallByExpr{.fn_decl = virtual_fn, .expr = "v_fn"});
+	case asBC_CallPtr: emit_dynamic_call(state, frame_var(ins.sword0(), var_types::void_ptr)); break;
+	case asBC_CALLBND: {
+		emit_dynamic_call(state, fmt::format("asea_resolve_bound_function(_regs, {})", ins.int0()));
 		break;
 	}
 
@@ -963,12 +1280,41 @@ void BytecodeToC::translate_instruction(FnState& state) {
 	}
 
 	case asBC_RET: {
+		if (state.inline_info != nullptr) {
+			emit("\t\tgoto {};\n", state.inline_info->return_label);
+			break;
+		}
+
+		if (state.is_typed_entry) {
+			emit("\t\treturn value_reg;\n");
+			break;
+		}
+
 		if (!m_config->experimental_fast_script_return) {
 			emit("\t\tregs->value = value_reg;\n");
 			emit_vm_fallback(state, "experimental_fast_script_return == false");
 			break;
 		}
 
+		if (uses_shadow_call_stack()) {
+			// we were called by JIT code that did not push its state to the call stack
+			emit(
+			    "\t\tif (shadow && !shadow->materialized) {{\n"
+			    "\t\t\tregs->fp = (asDWORD*)shadow->state[0];\n"
+			    "\t\t\t*(asCScriptFunction**)((char*)regs->ctx + {OFF_CURRENTFN}) = "
+			    "(asCScriptFunction*)shadow->state[1];\n"
+			    "\t\t\tregs->pc = (asDWORD*)shadow->state[2];\n"
+			    "\t\t\tregs->sp = (asDWORD*)shadow->state[3] + {POP};\n"
+			    "\t\t\t*(asUINT*)((char*)regs->ctx + {OFF_STACKINDEX}) = (asUINT)shadow->state[4];\n"
+			    "\t\t\tregs->value = value_reg;\n"
+			    "\t\t\treturn;\n"
+			    "\t\t}}\n",
+			    fmt::arg("OFF_CURRENTFN", DIRECT_VALUE_IF_POSSIBLE(asea_offset_ctx_currentfn)),
+			    fmt::arg("OFF_STACKINDEX", DIRECT_VALUE_IF_POSSIBLE(asea_offset_ctx_stackindex)),
+			    fmt::arg("POP", ins.word0())
+			);
+		}
+
 		emit(
 		    "\t\tasea_array* cs = (asea_array*)((char*)regs->ctx + {OFF_CALLSTACK});\n"
 		    "\t\tasPWORD* cs_ptr = (asPWORD*)(cs->ptr);\n"
@@ -997,7 +1343,7 @@ void BytecodeToC::translate_instruction(FnState& state) {
 		break;
 	}
 
-	case asBC_JMP:  emit("\t\tgoto bc{};\n", bcins::Jump{ins}.target_offset()); break;
+	case asBC_JMP:  emit("\t\tgoto {}{};\n", state.label_prefix, bcins::Jump{ins}.target_offset()); break;
 
 	case asBC_JMPP: {
 		emit("\t\tswitch({}) {{\n", frame_var(ins.sword0(), s32));
@@ -1006,7 +1352,7 @@ void BytecodeToC::translate_instruction(FnState& state) {
 		std::size_t i = 0;
 		// TODO: also investigate label as values for this
 		for (const std::size_t target : mapping_it->second) {
-			emit("\t\tcase {}: goto bc{};\n", i, target);
+			emit("\t\tcase {}: goto {}{};\n", i, state.label_prefix, target);
 			++i;
 		}
 		emit("\t\t}}\n");
@@ -1130,6 +1476,14 @@ void BytecodeToC::translate_instruction(FnState& state) {
 	case asBC_MODf:   emit_divmod_var_float_ins(state, "fmodf", f32); break;
 	case asBC_MODd:   emit_divmod_var_float_ins(state, "fmod", f64); break;
 
+	case asBC_POWi:
+	case asBC_POWu:
+	case asBC_POWf:
+	case asBC_POWd:
+	case asBC_POWdi:
+	case asBC_POWi64:
+	case asBC_POWu64: emit_pow_var_ins(state); break;
+
 	case asBC_BNOT64: emit_unop_var_inplace_ins(state, "~", u64); break;
 	case asBC_BAND64: emit_binop_var_var_ins(state, "&", u64, u64, u64); break;
 	case asBC_BXOR64: emit_binop_var_var_ins(state, "^", u64, u64, u64); break;
@@ -1146,33 +1500,33 @@ void BytecodeToC::translate_instruction(FnState& state) {
 	case asBC_BSRL:   emit_binop_var_var_ins(state, ">>", u32, u32, u32); break;
 	case asBC_BSRA:   emit_binop_var_var_ins(state, ">>", s32, u32, s32); break;
 
-	case asBC_iTOf:   emit_primitive_cast_var_ins(state, s32, f32); break;
-	case asBC_fTOi:   emit_primitive_cast_var_ins(state, f32, s32); break;
-	case asBC_uTOf:   emit_primitive_cast_var_ins(state, u32, f32); break;
-	case asBC_fTOu:   emit_primitive_cast_var_ins(state, f32, u32); break;
-	case asBC_sbTOi:  emit_primitive_cast_var_ins(state, s8, s32); break;
-	case asBC_swTOi:  emit_primitive_cast_var_ins(state, s16, s32); break;
-	case asBC_ubTOi:  emit_primitive_cast_var_ins(state, u8, s32); break;
-	case asBC_uwTOi:  emit_primitive_cast_var_ins(state, u16, s32); break;
-	case asBC_iTOb:   emit_primitive_cast_var_ins(state, u32, s8); break;
-	case asBC_iTOw:   emit_primitive_cast_var_ins(state, u32, s16); break;
-	case asBC_i64TOi: emit_primitive_cast_var_ins(state, s64, s32); break;
-	case asBC_uTOi64: emit_primitive_cast_var_ins(state, u32, s64); break;
-	case asBC_iTOi64: emit_primitive_cast_var_ins(state, s32, s64); break;
-	case asBC_fTOd:   emit_primitive_cast_var_ins(state, f32, f64); break;
-	case asBC_dTOf:   emit_primitive_cast_var_ins(state, f64, f32); break;
-	case asBC_fTOi64: emit_primitive_cast_var_ins(state, f32, s64); break;
-	case asBC_dTOi64: emit_primitive_cast_var_ins(state, f64, s64); break;
-	case asBC_fTOu64: emit_primitive_cast_var_ins(state, f32, u64); break;
-	case asBC_dTOu64: emit_primitive_cast_var_ins(state, f64, u64); break;
-	case asBC_i64TOf: emit_primitive_cast_var_ins(state, s64, f32); break;
-	case asBC_u64TOf: emit_primitive_cast_var_ins(state, u64, f32); break;
-	case asBC_i64TOd: emit_primitive_cast_var_ins(state, s64, f64); break;
-	case asBC_u64TOd: emit_primitive_cast_var_ins(state, u64, f64); break;
-	case asBC_dTOi:   emit_primitive_cast_var_ins(state, f64, s32); break;
-	case asBC_dTOu:   emit_primitive_cast_var_ins(state, f64, u32); break;
-	case asBC_iTOd:   emit_primitive_cast_var_ins(state, s32, f64); break;
-	case asBC_uTOd:   emit_primitive_cast_var_ins(state, u32, f64); break;
+	case asBC_iTOf:
+	case asBC_fTOi:
+	case asBC_uTOf:
+	case asBC_fTOu:
+	case asBC_sbTOi:
+	case asBC_swTOi:
+	case asBC_ubTOi:
+	case asBC_uwTOi:
+	case asBC_iTOb:
+	case asBC_iTOw:
+	case asBC_i64TOi:
+	case asBC_uTOi64:
+	case asBC_iTOi64:
+	case asBC_fTOd:
+	case asBC_dTOf:
+	case asBC_fTOi64:
+	case asBC_dTOi64:
+	case asBC_fTOu64:
+	case asBC_dTOu64:
+	case asBC_i64TOf:
+	case asBC_u64TOf:
+	case asBC_i64TOd:
+	case asBC_u64TOd:
+	case asBC_dTOi:
+	case asBC_dTOu:
+	case asBC_iTOd:
+	case asBC_uTOd:   emit_primitive_cast_var_ins(state, bcins::PrimitiveCast{ins}); break;
 
 	case asBC_ADDIi:  emit_binop_var_imm_ins(state, "+", s32, fmt::to_string(ins.int0(1)), s32); break;
 	case asBC_SUBIi:  emit_binop_var_imm_ins(state, "-", s32, fmt::to_string(ins.int0(1)), s32); break;
@@ -1193,22 +1547,8 @@ void BytecodeToC::translate_instruction(FnState& state) {
 
 	case asBC_SwapPtr:      // TODO: find way to emit
 	case asBC_LdGRdR4:      // TODO: find way to emit
-	case asBC_CALLBND:      // TODO: find way to emit & implement (calls & syscalls)
-	case asBC_CallPtr:      // TODO: find way to emit & implement (calls & syscalls) -- probably just functors
 	case asBC_ChkRefS:      // TODO: find way to emit
 	case asBC_ClrHi:        // TODO: find way to emit
-	case asBC_FuncPtr:      // TODO: find way to emit
-	case asBC_AllocMem:     // TODO: implement (seems used in list factories)
-	case asBC_SetListSize:  // TODO: implement
-	case asBC_PshListElmnt: // TODO: implement
-	case asBC_SetListType:  // TODO: find way to emit
-	case asBC_POWi:         // TODO: write tests and implement
-	case asBC_POWu:         // TODO: write tests and implement
-	case asBC_POWf:         // TODO: write tests and implement
-	case asBC_POWd:         // TODO: write tests and implement
-	case asBC_POWdi:        // TODO: write tests and implement
-	case asBC_POWi64:       // TODO: write tests and implement
-	case asBC_POWu64:       // TODO: write tests and implement
 	{
 		emit_vm_fallback(state, "unsupported instruction");
 		break;
@@ -1220,7 +1560,12 @@ void BytecodeToC::translate_instruction(FnState& state) {
 	}
 	}
 
-	if (ins.opcode() == m_config->debug.fallback_after_instruction) {
+	emit_instruction_footer(state);
+}
+
+void BytecodeToC::emit_instruction_footer(FnState& state) {
+	if (state.ins.opcode() == m_config->debug.fallback_after_instruction) {
+		emit_flush_virtual_stack(state);
 		emit_vm_fallback(state, "debug.fallback_after_instruction");
 	}
 
@@ -1230,6 +1575,15 @@ void BytecodeToC::translate_instruction(FnState& state) {
 void BytecodeToC::emit_vm_fallback(FnState& state, std::string_view reason) {
 	++m_module_state.fallback_count;
 
+	// the VM expects an up-to-date sp. the pending pushes are only applied to this path rather than flushed, because
+	// the fallback may be conditional.
+	if (state.inline_info == nullptr && (state.pending_push_dwords != 0 || state.pending_push_pwords != 0)) {
+		emit(
+		    "\t\tsp = (asea_var*)((asDWORD*)sp - {OFFSET});\n",
+		    fmt::arg("OFFSET", pending_push_offset(state.pending_push_dwords, state.pending_push_pwords))
+		);
+	}
+
 	if (m_config->c.human_readable) {
 		emit("\t\t{} /* {} */\n", jump_to_error_handler_code(state, ErrorHandler::VM_FALLBACK), reason);
 	} else {
@@ -1238,6 +1592,11 @@ void BytecodeToC::emit_vm_fallback(FnState& state, std::string_view reason) {
 }
 
 std::string BytecodeToC::jump_to_error_handler_code(FnState& state, ErrorHandler handler) {
+	if (state.inline_info != nullptr) {
+		// let the regular call raise the error, see can_inline_script_function for why this is safe
+		return fmt::format("goto {};", state.inline_info->deopt_label);
+	}
+
 	state.error_handlers_mask |= std::uint64_t(handler);
 
 	std::string_view handler_name;
@@ -1246,6 +1605,7 @@ std::string BytecodeToC::jump_to_error_handler_code(FnState& state, ErrorHandler
 	case ErrorHandler::ERR_NULL:            handler_name = "err_null"; break;
 	case ErrorHandler::ERR_DIVIDE_BY_ZERO:  handler_name = "err_divide_by_zero"; break;
 	case ErrorHandler::ERR_DIVIDE_OVERFLOW: handler_name = "err_divide_overflow"; break;
+	case ErrorHandler::ERR_POW_OVERFLOW:    handler_name = "err_pow_overflow"; break;
 	}
 
 	return fmt::format(
@@ -1256,54 +1616,247 @@ std::string BytecodeToC::jump_to_error_handler_code(FnState& state, ErrorHandler
 	);
 }
 
+std::string BytecodeToC::null_check_code(FnState& state, std::string_view expr) {
+	if (state.ir.has_value()) {
+		const ir::Instruction* ins = state.ir->find_instruction(state.ins.offset);
+		if (ins != nullptr && ins->is_redundant) {
+			return {};
+		}
+	}
+
+	return fmt::format(
+	    "\t\tif ({EXPR} == 0) {{ {ERR_NULL_HANDLER} }}\n",
+	    fmt::arg("EXPR", expr),
+	    fmt::arg("ERR_NULL_HANDLER", jump_to_error_handler_code(state, ErrorHandler::ERR_NULL))
+	);
+}
+
 // we don't ever need to save the fp back to the VM registers because the fp is constant within a function, and
 // initialized from the VM registers. it will be saved and reloaded as part of the call state or elsewhere by  the
 // AS engine, but that is distinct from the register save sequence.
 
-void BytecodeToC::emit_save_sp([[maybe_unused]] FnState& state) { emit("\t\tregs->sp = sp;\n"); }
-void BytecodeToC::emit_save_pc(FnState& state, bool next_pc) {
+bool BytecodeToC::uses_shadow_call_stack() const {
+	return m_config->experimental_shadow_call_stack && m_config->experimental_fast_script_call;
+}
+
+void BytecodeToC::emit_materialize_shadow_frames([[maybe_unused]] FnState& state) {
+	if (uses_shadow_call_stack()) {
+		emit("\t\tif (shadow) {{ asea_materialize_shadow_frames(_regs, shadow); }}\n");
+	}
+}
+
+void BytecodeToC::emit_suspend_ins(FnState& state) {
+	if (state.inline_info != nullptr) {
+		// let the regular call handle the suspend, see can_inline_script_function for why this is safe
+		emit("\t\tif (regs->do_suspend) {{ goto {}; }}\n", state.inline_info->deopt_label);
+		return;
+	}
+
+	// the line callback may inspect the context, so everything must be visible to it, like for a VM fallback
+	flush_stack_push_optimization(state);
 	emit(
-	    "\t\tregs->pc = base_pc + {INS_OFFSET};\n",
-	    fmt::arg("INS_OFFSET", state.ins.offset + (next_pc ? state.ins.size() : 0))
+	    "\t\tif (regs->do_suspend) {{\n"
+	    "\t\t\tregs->pc = base_pc + {INS_OFFSET};\n"
+	    "\t\t\tregs->sp = sp;\n"
+	    "{MATERIALIZE}"
+	    "{SPILL}"
+	    "\t\t\tif (asea_process_suspend(_regs)) {{\n"
+	    "\t\t\t\tregs->pc = base_pc + {NEXT_INS_OFFSET};\n"
+	    "\t\t\t\treturn;\n"
+	    "\t\t\t}}\n"
+	    "{RELOAD}"
+	    "\t\t}}\n",
+	    fmt::arg("INS_OFFSET", state.ins.offset),
+	    fmt::arg("NEXT_INS_OFFSET", state.ins.offset + state.ins.size()),
+	    fmt::arg(
+	        "MATERIALIZE",
+	        uses_shadow_call_stack() ? "\t\t\tif (shadow) { asea_materialize_shadow_frames(_regs, shadow); }\n" : ""
+	    ),
+	    fmt::arg("SPILL", promoted_variables_spill_code("\t\t\t")),
+	    fmt::arg("RELOAD", promoted_variables_reload_code("\t\t\t"))
 	);
 }
-void BytecodeToC::emit_primitive_cast_var_ins(FnState& state, VarType src, VarType dst) {
-	InsRef&    ins      = state.ins;
-	const bool in_place = ins.size() == 1;
 
-	if (src.size != dst.size && dst.size < 4) {
-		emit(
-		    "\t\t{DST_TYPE} value = {SRC};\n"
-		    "\t\tasea_var *dst = {DSTPTR};\n"
-		    "\t\tdst->as_asDWORD = 0;\n"
-		    "\t\tdst->as_{DST_TYPE} = value;\n",
-		    fmt::arg("DST_TYPE", dst.c),
-		    fmt::arg("DSTPTR", frame_ptr(ins.sword0())),
-		    fmt::arg("SRC", frame_var(in_place ? ins.sword0() : ins.sword1(), src))
-		);
+void BytecodeToC::emit_context_sync_before_system_call(FnState& state) {
+	// the callee may walk the call stack (e.g. for logging or profiling), which must be complete even when the hack is
+	// set. the shadow frames that were already pushed stay so, which makes this a single check for subsequent calls in
+	// the same frame.
+	if (uses_shadow_call_stack()) {
+		emit("\t\tif (shadow && !shadow->materialized) {{ asea_materialize_shadow_frames(_regs, shadow); }}\n");
+	}
+
+	if (m_config->hack_ignore_context_inspect) {
 		return;
 	}
-	emit_assign_ins(state, frame_var(ins.sword0(), dst), frame_var(in_place ? ins.sword0() : ins.sword1(), src));
+
+	// the registers themselves are saved by the call sequences
+	emit("{}", promoted_variables_spill_code("\t\t"));
 }
 
-std::string
-BytecodeToC::emit_global_lookup([[maybe_unused]] FnState& state, void* pointer, [[maybe_unused]] bool global_var_only) {
-	std::string                            fn_symbol;
-	asSMapNode<void*, asCGlobalProperty*>* var_cursor = nullptr;
-	if (m_script_engine->varAddressMap.MoveTo(&var_cursor, pointer)) {
-		asCGlobalProperty* property = m_script_engine->varAddressMap.GetValue(var_cursor);
-		angelsea_assert(property != nullptr);
+void BytecodeToC::emit_context_sync_after_system_call([[maybe_unused]] FnState& state) {
+	if (m_config->hack_ignore_context_inspect) {
+		return;
+	}
 
-		fn_symbol = fmt::format("{}_g{}", m_c_symbol_prefix, property->id);
+	// the callee may have modified variables through the context
+	emit("{}", promoted_variables_reload_code("\t\t"));
+}
 
-		if (m_on_map_extern_callback) {
-			m_on_map_extern_callback(
-			    fn_symbol.c_str(),
-			    ExternGlobalVariable{.ptr = pointer, .property = property},
-			    pointer
-			);
-		}
-	} else {
+void BytecodeToC::emit_system_call_status_check(FnState& state, SystemFunctionTraits traits) {
+	// script exceptions can be raised by the callee through the context, or by the runtime from a C++ exception
+	const bool may_suspend = !m_config->hack_ignore_suspend && !traits.no_context_access;
+	const bool may_raise   = !m_config->hack_ignore_exceptions && !(traits.no_context_access && traits.nothrow);
+	if (!may_suspend && !may_raise) {
+		return;
+	}
+
+	emit(
+	    "\t\tif (regs->do_suspend && asea_check_call_status(_regs)) {{\n"
+	    "\t\t\tregs->value = value_reg;\n"
+	    "\t\t\tregs->pc = base_pc + {NEXT_INS_OFFSET};\n"
+	    "\t\t\tgoto vm;\n"
+	    "\t\t}}\n",
+	    fmt::arg("NEXT_INS_OFFSET", state.ins.offset + state.ins.size())
+	);
+	state.error_handlers_mask |= std::uint64_t(ErrorHandler::VM_FALLBACK);
+}
+
+SystemFunctionTraits BytecodeToC::get_system_function_traits(int fn_idx) const {
+	const auto it = m_system_function_traits.find(fn_idx);
+	if (it == m_system_function_traits.end()) {
+		return {};
+	}
+
+	return it->second;
+}
+
+const SystemFunctionIntrinsic* BytecodeToC::get_system_function_intrinsic(int fn_idx) const {
+	const auto it = m_system_function_intrinsics.find(fn_idx);
+	if (it == m_system_function_intrinsics.end()) {
+		return nullptr;
+	}
+
+	// the intrinsic is evaluated with the arguments of a direct native call, which generic functions do not have
+	const asCScriptFunction& fn = *m_script_engine->scriptFunctions[fn_idx];
+	if (fn.sysFuncIntf == nullptr) {
+		return nullptr;
+	}
+
+	switch (fn.sysFuncIntf->callConv) {
+	case ICC_GENERIC_FUNC:
+	case ICC_GENERIC_FUNC_RETURNINMEM:
+	case ICC_GENERIC_METHOD:
+	case ICC_GENERIC_METHOD_RETURNINMEM: return nullptr;
+	default:                             return &it->second;
+	}
+}
+
+void BytecodeToC::emit_intrinsic_definitions(int fn_idx, const SystemFunctionIntrinsic& intrinsic) {
+	if (!m_module_state.emitted_intrinsics.emplace(fn_idx).second) {
+		return;
+	}
+
+	if (m_on_map_extern_callback) {
+		for (const auto& [name, address] : intrinsic.symbols) {
+			m_on_map_extern_callback(name.c_str(), ExternIntrinsicSymbol{fn_idx}, address);
+		}
+	}
+
+	emit_to(m_module_state.code_blocks.forward_declarations, "{}\n", intrinsic.definitions);
+}
+
+/// Replaces the `$0`, `$1`, etc. and `$this` placeholders of an intrinsic expression (see \ref
+/// SystemFunctionIntrinsic::expression) with `args` and `this_expr` respectively. Returns an empty string if the
+/// expression refers to something that does not exist.
+static std::string substitute_intrinsic_placeholders(
+    std::string_view                expression,
+    const std::vector<std::string>& args,
+    std::string_view                this_expr
+) {
+	std::string ret = "(";
+
+	for (std::size_t i = 0; i < expression.size(); ++i) {
+		if (expression[i] != '$') {
+			ret += expression[i];
+			continue;
+		}
+
+		const std::string_view rest = expression.substr(i + 1);
+		if (rest.starts_with("this")) {
+			if (this_expr.empty()) {
+				return {};
+			}
+			ret += fmt::format("({})", this_expr);
+			i += 4;
+			continue;
+		}
+
+		std::size_t digits = 0, arg_idx = 0;
+		while (digits < rest.size() && rest[digits] >= '0' && rest[digits] <= '9') {
+			arg_idx = arg_idx * 10 + std::size_t(rest[digits] - '0');
+			++digits;
+		}
+
+		if (digits == 0 || arg_idx >= args.size()) {
+			return {};
+		}
+		ret += fmt::format("({})", args[arg_idx]);
+		i += digits;
+	}
+
+	ret += ')';
+	return ret;
+}
+
+void BytecodeToC::emit_save_sp([[maybe_unused]] FnState& state) {
+	angelsea_assert(
+	    state.pending_push_dwords == 0 && state.pending_push_pwords == 0 && "virtual stack should have been flushed"
+	);
+	emit("\t\tregs->sp = sp;\n");
+}
+void BytecodeToC::emit_save_pc(FnState& state, bool next_pc) {
+	emit(
+	    "\t\tregs->pc = base_pc + {INS_OFFSET};\n",
+	    fmt::arg("INS_OFFSET", state.ins.offset + (next_pc ? state.ins.size() : 0))
+	);
+}
+void BytecodeToC::emit_primitive_cast_var_ins(FnState& state, const bcins::PrimitiveCast& cast) {
+	const VarType src = cast.src;
+	const VarType dst = cast.dst;
+
+	if (src.size != dst.size && dst.size < 4) {
+		emit(
+		    "\t\t{DST_TYPE} value = {SRC};\n"
+		    "\t\tasea_var *dst = {DSTPTR};\n"
+		    "\t\tdst->as_asDWORD = 0;\n"
+		    "\t\tdst->as_{DST_TYPE} = value;\n",
+		    fmt::arg("DST_TYPE", dst.c),
+		    fmt::arg("DSTPTR", frame_ptr(cast.dst_offset())),
+		    fmt::arg("SRC", frame_var(cast.src_offset(), src))
+		);
+		return;
+	}
+	emit_assign_ins(state, frame_var(cast.dst_offset(), dst), frame_var(cast.src_offset(), src));
+}
+
+std::string
+BytecodeToC::emit_global_lookup([[maybe_unused]] FnState& state, void* pointer, [[maybe_unused]] bool global_var_only) {
+	std::string                            fn_symbol;
+	asSMapNode<void*, asCGlobalProperty*>* var_cursor = nullptr;
+	if (m_script_engine->varAddressMap.MoveTo(&var_cursor, pointer)) {
+		asCGlobalProperty* property = m_script_engine->varAddressMap.GetValue(var_cursor);
+		angelsea_assert(property != nullptr);
+
+		fn_symbol = fmt::format("{}_g{}", m_c_symbol_prefix, property->id);
+
+		if (m_on_map_extern_callback) {
+			m_on_map_extern_callback(
+			    fn_symbol.c_str(),
+			    ExternGlobalVariable{.ptr = pointer, .property = property},
+			    pointer
+			);
+		}
+	} else {
 		// pointer to a string constant (of an arbitrary registered string type)
 
 		// TODO: deduplicate references to identical strings
@@ -1339,6 +1892,21 @@ std::string BytecodeToC::emit_type_info_lookup([[maybe_unused]] FnState& state,
 	return type_info_symbol;
 }
 
+std::string BytecodeToC::emit_script_function_lookup(FnState& state, int fn_idx) {
+	std::string fn_symbol = fmt::format("{}_scriptfn{}", m_c_symbol_prefix, fn_idx);
+
+	if (m_on_map_extern_callback) {
+		m_on_map_extern_callback(
+		    fn_symbol.c_str(),
+		    ExternScriptFunction{fn_idx},
+		    m_script_engine->scriptFunctions[fn_idx]
+		);
+	}
+
+	emit_forward_declaration(state, fn_symbol, "extern char {}[];\n", fn_symbol);
+	return fn_symbol;
+}
+
 bool BytecodeToC::is_complex_passed_by_value(const asCDataType& type) const {
 	if (!type.IsObject() || type.IsReference()) {
 		return false;
@@ -1354,6 +1922,83 @@ bool BytecodeToC::is_complex_passed_by_value(const asCDataType& type) const {
 	return (flags & (asOBJ_APP_CLASS_DESTRUCTOR | asOBJ_APP_CLASS_COPY_CONSTRUCTOR | asOBJ_APP_ARRAY)) != 0;
 }
 
+/// A member of a value type known from its registered properties, see \ref get_property_fields.
+struct PropertyField {
+	std::size_t      offset;
+	std::size_t      size;
+	std::string_view c_type;
+};
+
+/// Lists the members of `type` from its registered properties, sorted by offset, if they describe its whole layout:
+/// the members must not overlap and any byte they do not cover must be the padding that the C layout of these same
+/// members would insert. Otherwise, an unregistered member could change how the type is passed, and `false` is
+/// returned.
+static bool get_property_fields(const asCDataType& type, std::size_t size, std::vector<PropertyField>& fields) {
+	const asCObjectType* obj_type = CastToObjectType(type.GetTypeInfo());
+	if (obj_type == nullptr || obj_type->properties.GetLength() == 0) {
+		return false;
+	}
+
+	for (asUINT i = 0; i < obj_type->properties.GetLength(); ++i) {
+		const asCObjectProperty& prop      = *obj_type->properties[i];
+		const asCDataType&       prop_type = prop.type;
+		if (prop_type.IsReference() || prop.isCompositeIndirect || prop.compositeOffset != 0 || prop.byteOffset < 0) {
+			return false;
+		}
+
+		PropertyField field{.offset = std::size_t(prop.byteOffset), .size = 0, .c_type = {}};
+		if (prop_type.IsObjectHandle()) {
+			field.size   = sizeof(void*);
+			field.c_type = "void*";
+		} else if (prop_type.IsFloatType()) {
+			field.size   = 4;
+			field.c_type = "float";
+		} else if (prop_type.IsDoubleType()) {
+			field.size   = 8;
+			field.c_type = "double";
+		} else if (prop_type.IsIntegerType() || prop_type.IsUnsignedType() || prop_type.IsBooleanType()
+		           || prop_type.IsEnumType()) {
+			field.size = prop_type.GetSizeInMemoryBytes();
+			switch (field.size) {
+			case 1:  field.c_type = "asBYTE"; break;
+			case 2:  field.c_type = "asWORD"; break;
+			case 4:  field.c_type = "asDWORD"; break;
+			case 8:  field.c_type = "asQWORD"; break;
+			default: return false;
+			}
+		} else {
+			return false; // nested value types are not handled
+		}
+
+		fields.push_back(field);
+	}
+
+	std::ranges::sort(fields, {}, &PropertyField::offset);
+
+	// the same member may be registered under several names
+	const auto [first_duplicate, last_duplicate] = std::ranges::unique(fields, [](const auto& a, const auto& b) {
+		return a.offset == b.offset && a.size == b.size && a.c_type == b.c_type;
+	});
+	fields.erase(first_duplicate, last_duplicate);
+
+	// all of the C types we use are aligned to their size on the platforms MIR supports
+	const auto align_up = [](std::size_t offset, std::size_t alignment) {
+		return (offset + alignment - 1) / alignment * alignment;
+	};
+
+	std::size_t end       = 0;
+	std::size_t alignment = 1;
+	for (const PropertyField& field : fields) {
+		if (field.offset != align_up(end, field.size)) {
+			return false; // overlapping members, or a gap that is not padding
+		}
+		end       = field.offset + field.size;
+		alignment = std::max(alignment, field.size);
+	}
+
+	return align_up(end, alignment) == size;
+}
+
 std::string BytecodeToC::emit_dummy_struct_declaration(FnState& state, const asCDataType& type) {
 	if (type.GetTypeInfo() == nullptr) {
 		return {};
@@ -1363,37 +2008,89 @@ std::string BytecodeToC::emit_dummy_struct_declaration(FnState& state, const asC
 	const auto&       flags     = type_info.flags;
 	const std::size_t size      = type.GetSizeInMemoryBytes();
 
-	if (is_complex_passed_by_value(type)) {
+	const auto fail = [&](std::string_view reason) {
 		log(*m_config,
 		    *m_script_engine,
 		    LogSeverity::ASEA_PERF_HINT,
-		    "Type `{}` has non-trivial C++ ABI, which we currently don't emulate pass/return by value yet for. "
-		    "Native "
-		    "call will fall back to VM.",
-		    type_info.GetName());
-		return {};
+		    "Type `{}` has unsupported layout for pass/return-by-value ({}). Native call will fall back to VM.",
+		    type_info.GetName(),
+		    reason);
+		return std::string{};
+	};
+
+	// non-trivial types are never passed in registers, so callers pass them by pointer rather than via a dummy struct.
+	// should a caller get this wrong, falling back is still safer than a dummy with the wrong ABI
+	angelsea_assert(!is_complex_passed_by_value(type));
+	if (is_complex_passed_by_value(type)) {
+		return fail("non-trivial C++ ABI");
+	}
+
+	// How a small struct is passed only depends on its size and alignment and, on System V x86-64, on the class of
+	// each of its eightbytes: SSE if it only holds floating-point members, INTEGER otherwise. On AArch64, structs made
+	// of up to four members of the same floating-point type are passed in FP registers, one member per register.
+	// AngelScript does not tell us the actual members, but its type flags describe enough of them for the dummy to be
+	// classified the same way by the C compiler:
+	// - `asOBJ_APP_CLASS_ALLFLOATS` means every member is a float or a double. Without `asOBJ_APP_CLASS_ALIGN8` they
+	//   can only be floats, but with it they may be a mix of both;
+	// - `asOBJ_APP_CLASS_ALLINTS` means every member is an integer, with 8-byte alignment for `ALIGN8`;
+	// - without either, members of mixed kinds may share an eightbyte.
+	// In the ambiguous cases, the registered properties may still describe the whole layout, in which case the dummy
+	// declares the same members, and eightbytes get classified as they are for the actual type.
+	if ((flags & asOBJ_APP_ALIGN16) != 0) {
+		return fail("16-byte alignment");
 	}
 
+	const bool is_align8 = (flags & asOBJ_APP_CLASS_ALIGN8) != 0;
+
 	std::string gen_name = fmt::format("{}_abi{}", m_c_symbol_prefix, type_info.GetTypeId());
 	std::string decl     = "typedef struct { ";
 
+	// appends as many fields of `c_type` as fit in the rest of the struct
+	std::size_t offset = 0;
+
+	const auto fill_fields = [&](std::string_view c_type, std::size_t field_size) {
+		for (; offset + field_size <= size; offset += field_size) {
+			decl += fmt::format("{} _{}; ", c_type, offset);
+		}
+	};
+
+	const auto fill_property_fields = [&] {
+		std::vector<PropertyField> fields;
+		if (!get_property_fields(type, size, fields)) {
+			return false;
+		}
+
+		for (const PropertyField& field : fields) {
+			decl += fmt::format("{} _{}; ", field.c_type, field.offset);
+		}
+		offset = size;
+		return true;
+	};
+
 	if ((flags & (asOBJ_APP_CLASS_ALLFLOATS | asOBJ_APP_FLOAT)) != 0) {
-		// FIXME: how does this behave across ABIs with float/double
-		for (std::size_t i = 0; i < size; i += 4) {
-			decl += fmt::format("float _{}; ", i);
+		const bool is_primitive = (flags & asOBJ_APP_FLOAT) != 0;
+		if (!is_primitive && is_align8) {
+			if (!fill_property_fields()) {
+				return fail("floating-point members whose registered properties do not describe the layout");
+			}
+		} else {
+			const bool is_double = is_primitive && size == 8;
+			fill_fields(is_double ? "double" : "float", is_double ? 8 : 4);
+		}
+		if (offset != size) {
+			return fail("size is not a multiple of its floating-point members");
 		}
 	} else if ((flags & (asOBJ_APP_CLASS_ALLINTS | asOBJ_APP_PRIMITIVE)) != 0) {
-		// FIXME: same question as for floats (but iirc it just packs on system V)
-		for (std::size_t i = 0; i < size; i += 4) {
-			decl += fmt::format("asDWORD _{}; ", i);
+		// integer eightbytes are packed into the same register however they are split, but the alignment and exact
+		// size still matter when the struct is passed on the stack
+		if (is_align8) {
+			fill_fields("asQWORD", 8);
 		}
-	} else {
-		log(*m_config,
-		    *m_script_engine,
-		    LogSeverity::ASEA_PERF_HINT,
-		    "Type `{}` has unsupported layout for pass/return-by-value. Native call will fall back to VM.",
-		    type_info.GetName());
-		return {};
+		fill_fields("asDWORD", 4);
+		fill_fields("asWORD", 2);
+		fill_fields("asBYTE", 1);
+	} else if (!fill_property_fields()) {
+		return fail("members of mixed kinds whose registered properties do not describe the layout");
 	}
 
 	decl += fmt::format("}} {};\n", gen_name);
@@ -1401,110 +2098,993 @@ std::string BytecodeToC::emit_dummy_struct_declaration(FnState& state, const asC
 	return gen_name;
 }
 
+/// Properties of an instruction relevant to translating functions in restricted contexts (e.g. when inlining), where
+/// only simple instructions are supported. Anything that may call, touch the stack pointer or fall back is not
+/// considered simple.
+struct SimpleInstructionInfo {
+	bool is_simple;
+	/// May jump to an error handler
+	bool may_raise;
+	/// Writes to memory outside of the stack frame
+	bool has_side_effects;
+};
+
+static SimpleInstructionInfo get_simple_instruction_info(asEBCInstr opcode) {
+	switch (opcode) {
+	case asBC_LoadRObjR:
+	case asBC_LoadThisR:
+	case asBC_ChkNullV:
+	case asBC_DIVi:
+	case asBC_MODi:
+	case asBC_DIVu:
+	case asBC_MODu:
+	case asBC_DIVi64:
+	case asBC_MODi64:
+	case asBC_DIVu64:
+	case asBC_MODu64:
+	case asBC_DIVf:
+	case asBC_DIVd:
+	case asBC_MODf:
+	case asBC_MODd:
+	case asBC_POWi:
+	case asBC_POWu:
+	case asBC_POWf:
+	case asBC_POWd:
+	case asBC_POWdi:
+	case asBC_POWi64:
+	case asBC_POWu64:   return {.is_simple = true, .may_raise = true, .has_side_effects = false};
+
+	case asBC_WRTV1:
+	case asBC_WRTV2:
+	case asBC_WRTV4:
+	case asBC_WRTV8:
+	case asBC_CpyVtoG4:
+	case asBC_SetG4:
+	// these modify the value pointed to by the value register, e.g. a global variable or an object member
+	case asBC_INCi8:
+	case asBC_DECi8:
+	case asBC_INCi16:
+	case asBC_DECi16:
+	case asBC_INCi:
+	case asBC_DECi:
+	case asBC_INCi64:
+	case asBC_DECi64:
+	case asBC_INCf:
+	case asBC_DECf:
+	case asBC_INCd:
+	case asBC_DECd:     return {.is_simple = true, .may_raise = false, .has_side_effects = true};
+
+	case asBC_JitEntry:
+	case asBC_SetV1:
+	case asBC_SetV2:
+	case asBC_SetV4:
+	case asBC_SetV8:
+	case asBC_ClrVPtr:
+	case asBC_CpyVtoR4:
+	case asBC_CpyRtoV4:
+	case asBC_CpyVtoR8:
+	case asBC_CpyRtoV8:
+	case asBC_CpyVtoV4:
+	case asBC_CpyVtoV8:
+	case asBC_CpyGtoV4:
+	case asBC_LDV:
+	case asBC_LDG:
+	case asBC_LoadVObjR:
+	case asBC_RDR1:
+	case asBC_RDR2:
+	case asBC_RDR4:
+	case asBC_RDR8:
+	case asBC_JMP:
+	case asBC_JZ:
+	case asBC_JLowZ:
+	case asBC_JNZ:
+	case asBC_JLowNZ:
+	case asBC_JS:
+	case asBC_JNS:
+	case asBC_JP:
+	case asBC_JNP:
+	case asBC_TZ:
+	case asBC_TNZ:
+	case asBC_TS:
+	case asBC_TNS:
+	case asBC_TP:
+	case asBC_TNP:
+	case asBC_CMPi:
+	case asBC_CMPu:
+	case asBC_CMPd:
+	case asBC_CMPf:
+	case asBC_CMPi64:
+	case asBC_CMPu64:
+	case asBC_CmpPtr:
+	case asBC_CMPIi:
+	case asBC_CMPIu:
+	case asBC_CMPIf:
+	case asBC_IncVi:
+	case asBC_DecVi:
+	case asBC_NOT:
+	case asBC_NEGi:
+	case asBC_NEGi64:
+	case asBC_NEGf:
+	case asBC_NEGd:
+	case asBC_ADDi:
+	case asBC_SUBi:
+	case asBC_MULi:
+	case asBC_ADDi64:
+	case asBC_SUBi64:
+	case asBC_MULi64:
+	case asBC_ADDf:
+	case asBC_SUBf:
+	case asBC_MULf:
+	case asBC_ADDd:
+	case asBC_SUBd:
+	case asBC_MULd:
+	case asBC_BNOT64:
+	case asBC_BAND64:
+	case asBC_BXOR64:
+	case asBC_BOR64:
+	case asBC_BSLL64:
+	case asBC_BSRL64:
+	case asBC_BSRA64:
+	case asBC_BNOT:
+	case asBC_BAND:
+	case asBC_BXOR:
+	case asBC_BOR:
+	case asBC_BSLL:
+	case asBC_BSRL:
+	case asBC_BSRA:
+	case asBC_iTOf:
+	case asBC_fTOi:
+	case asBC_uTOf:
+	case asBC_fTOu:
+	case asBC_sbTOi:
+	case asBC_swTOi:
+	case asBC_ubTOi:
+	case asBC_uwTOi:
+	case asBC_iTOb:
+	case asBC_iTOw:
+	case asBC_i64TOi:
+	case asBC_uTOi64:
+	case asBC_iTOi64:
+	case asBC_fTOd:
+	case asBC_dTOf:
+	case asBC_fTOi64:
+	case asBC_dTOi64:
+	case asBC_fTOu64:
+	case asBC_dTOu64:
+	case asBC_i64TOf:
+	case asBC_u64TOf:
+	case asBC_i64TOd:
+	case asBC_u64TOd:
+	case asBC_dTOi:
+	case asBC_dTOu:
+	case asBC_iTOd:
+	case asBC_uTOd:
+	case asBC_ADDIi:
+	case asBC_SUBIi:
+	case asBC_MULIi:
+	case asBC_ADDIf:
+	case asBC_SUBIf:
+	case asBC_MULIf:    return {.is_simple = true, .may_raise = false, .has_side_effects = false};
+
+	default:            return {.is_simple = false, .may_raise = false, .has_side_effects = false};
+	}
+}
+
 void BytecodeToC::emit_direct_script_call_ins(FnState& state, std::variant<ScriptCallByIdx, ScriptCallByExpr> call) {
-	// TODO: figure out a way to inline callees. maybe we can find simple functions and trigger their generation in
-	// a way that ensures they will be compiled? or we can just bring them into our module??
+	// TODO: inline larger callees, e.g. by translating them as separate C functions within our module
 
-	bool will_emit_direct = m_config->experimental_fast_script_call && m_config->hack_ignore_suspend;
+	bool will_emit_direct = m_config->experimental_fast_script_call;
+
+	// if inlined or called through a typed entry, the regular call below only serves as a fallback, and
+	// fast_path_end_label must be emitted after it
+	std::string fast_path_end_label;
+	if (const auto* call_by_idx = std::get_if<ScriptCallByIdx>(&call); call_by_idx != nullptr) {
+		asCScriptFunction& callee = *m_script_engine->scriptFunctions[call_by_idx->fn_idx];
+		if (can_inline_script_function(state, callee)) {
+			fast_path_end_label = emit_inlined_script_call(state, callee);
+		} else if (can_use_typed_entry(callee)) {
+			fast_path_end_label = emit_typed_script_call(state, callee);
+			if (state.is_typed_entry) {
+				return;
+			}
+		}
+	}
+
+	angelsea_assert(!state.is_typed_entry && "typed entries should only ever perform typed calls");
 
 	std::string        fn_expr;
 	asCScriptFunction* reference_fn;       // reference fn, only its signature is checked
 	asCScriptFunction* known_fn = nullptr; // actual fn, null if unknown
 
-	if (const auto* call_by_idx = std::get_if<ScriptCallByIdx>(&call); call_by_idx != nullptr) {
-		std::string fn_raw_name = fmt::format("{}_scriptfn{}", m_c_symbol_prefix, call_by_idx->fn_idx);
-		fn_expr                 = fmt::format("(asCScriptFunction*)&{}", fn_raw_name);
-		known_fn = reference_fn = m_script_engine->scriptFunctions[call_by_idx->fn_idx];
+	if (const auto* call_by_idx = std::get_if<ScriptCallByIdx>(&call); call_by_idx != nullptr) {
+		fn_expr = fmt::format("(asCScriptFunction*)&{}", emit_script_function_lookup(state, call_by_idx->fn_idx));
+		known_fn = reference_fn = m_script_engine->scriptFunctions[call_by_idx->fn_idx];
+	} else if (auto* call_by_expr = std::get_if<ScriptCallByExpr>(&call); call_by_expr != nullptr) {
+		fn_expr      = call_by_expr->expr;
+		reference_fn = call_by_expr->fn_decl;
+	} else {
+		angelsea_assert(false);
+	}
+
+	if (will_emit_direct) {
+		const bool use_shadow = uses_shadow_call_stack();
+
+		// the callee may let a system function, the line callback or a debugger inspect our variables as those of a
+		// calling frame
+		if (!m_config->hack_ignore_context_inspect) {
+			emit("{}", promoted_variables_spill_code("\t\t"));
+		}
+
+		// the callee gets a tagged pointer to our shadow frame instead of the call stack frame, see translate_function
+		const std::string_view entry_label = use_shadow ? "(asPWORD)&shadow_frame | 1" : "1";
+
+		if (use_shadow) {
+			emit(
+			    "\t\tasea_shadow_frame shadow_frame;\n"
+			    "\t\tif (asea_prepare_script_stack_shadow{VARS}(_regs, {FN}, base_pc + {INS_OFFSET}, sp, fp, "
+			    "&shadow_frame, shadow) != 0) {{\n"
+			    "\t\t\tasea_materialize_shadow_frames(_regs, &shadow_frame);\n"
+			    "{SPILL}"
+			    "\t\t\treturn;\n"
+			    "\t\t}}\n",
+			    fmt::arg("SPILL", promoted_variables_spill_code("\t\t\t")),
+			    fmt::arg("VARS", known_fn != nullptr ? "" : "_and_vars"),
+			    fmt::arg("FN", fn_expr),
+			    fmt::arg("INS_OFFSET", state.ins.offset + state.ins.size())
+			);
+		}
+
+		if (known_fn != nullptr) {
+			if (!use_shadow) {
+				// on failure (e.g. a stack overflow), the exception was set and the VM stops
+				emit(
+				    "\t\tif (asea_prepare_script_stack(_regs, {FN}, base_pc + {INS_OFFSET}, sp, fp) != 0) {{\n"
+				    "{SPILL}"
+				    "\t\t\treturn;\n"
+				    "\t\t}}\n",
+				    fmt::arg("SPILL", promoted_variables_spill_code("\t\t\t")),
+				    fmt::arg("FN", fn_expr),
+				    fmt::arg("BYTECODE", m_module_state.fn_bytecode_ptr),
+				    fmt::arg("INS_OFFSET", state.ins.offset + state.ins.size())
+				);
+			}
+			bool emitted_fp_var = false;
+			// setup stack with our knowledge
+			for (asUINT n = known_fn->scriptData->variables.GetLength(); n-- > 0;) {
+				asSScriptVariable* var = known_fn->scriptData->variables[n];
+
+				// don't clear the function arguments
+				if (var->stackOffset <= 0) {
+					continue;
+				}
+
+				if (var->onHeap && (var->type.IsObject() || var->type.IsFuncdef())) {
+					if (!emitted_fp_var) {
+						emit("\t\tasDWORD* callee_fp = regs->fp;\n");
+						emitted_fp_var = true;
+					}
+
+					if (m_config->c.human_readable) {
+						emit("\t\t/* arg {} requires clearing @ stack pos {} */\n", n, -var->stackOffset);
+					}
+
+					emit("\t\t((asea_var*)(callee_fp + {}))->as_asPWORD = 0;\n", -var->stackOffset);
+				}
+			}
+		} else if (!use_shadow) {
+			// if the function is not known, do the above stack logic dynamically in runtime
+			emit(
+			    "\t\tif (asea_prepare_script_stack_and_vars(_regs, {FN}, base_pc + {INS_OFFSET}, sp, fp) != 0) {{\n"
+			    "{SPILL}"
+			    "\t\t\treturn;\n"
+			    "\t\t}}\n",
+			    fmt::arg("SPILL", promoted_variables_spill_code("\t\t\t")),
+			    fmt::arg("FN", fn_expr),
+			    fmt::arg("BYTECODE", m_module_state.fn_bytecode_ptr),
+			    fmt::arg("INS_OFFSET", state.ins.offset + state.ins.size())
+			);
+		}
+
+		if (known_fn == state.fn) {
+			if (m_config->c.human_readable) {
+				emit("\t\t/* recursive call */\n");
+			}
+			emit(
+			    "\t\t{SELF}(_regs, {ENTRY});\n",
+			    fmt::arg("SELF", m_module_state.fn_name),
+			    fmt::arg("ENTRY", entry_label)
+			);
+		} else {
+			// look up JITFunction to branch into directly. if it doesn't exist that's fine; we drop to the vm
+			emit(
+			    "\t\tvoid* script_data = *(void**)((char*)({FN}) + {OFF_SCRIPTFN_SCRIPTDATA});\n"
+			    "\t\tasea_jit_fn jit_fn = *(asea_jit_fn*)((char*)script_data + {OFF_SCRIPTDATA_JITFN});\n"
+			    "\t\tif (!jit_fn) {{\n"
+			    "{MATERIALIZE}"
+			    "{SPILL}"
+			    "\t\t\treturn;\n"
+			    "\t\t}}\n"
+			    "\t\tjit_fn(_regs, {ENTRY});\n",
+			    fmt::arg("FN", fn_expr),
+			    fmt::arg(
+			        "MATERIALIZE",
+			        use_shadow ? "\t\t\tasea_materialize_shadow_frames(_regs, &shadow_frame);\n" : ""
+			    ),
+			    fmt::arg("SPILL", promoted_variables_spill_code("\t\t\t")),
+			    fmt::arg("ENTRY", entry_label),
+			    fmt::arg("OFF_SCRIPTFN_SCRIPTDATA", DIRECT_VALUE_IF_POSSIBLE(asea_offset_scriptfn_scriptdata)),
+			    fmt::arg("OFF_SCRIPTDATA_JITFN", DIRECT_VALUE_IF_POSSIBLE(asea_offset_scriptdata_jitfunction))
+			);
+		}
+
+		// If the callee returned to us (i.e. its RET popped our frame back), we can resume right away, rather than
+		// returning to the VM just so that it can enter us again via the next JitEntry.
+		// Otherwise, the callee fell back to the VM somewhere (or raised an exception), and it is still the current
+		// function: the VM is responsible for executing it and returning to us later. In that case, the callee has
+		// already materialized our shadow frame.
+		emit(
+		    "\t\tif (regs->pc != base_pc + {RET_OFFSET} || regs->fp != (void*)fp) {{\n"
+		    "{SPILL}"
+		    "\t\t\treturn;\n"
+		    "\t\t}}\n"
+		    "\t\tsp = regs->sp;\n"
+		    "\t\tvalue_reg = regs->value;\n",
+		    fmt::arg("RET_OFFSET", state.ins.offset + state.ins.size()),
+		    fmt::arg("SPILL", promoted_variables_spill_code("\t\t\t"))
+		);
+
+		// variables may have been modified through the context while the callee ran
+		if (!m_config->hack_ignore_context_inspect) {
+			emit("{}", promoted_variables_reload_code("\t\t"));
+		}
+	} else {
+		// Call fallback: We initiate the call from JIT, and the rest of the JitEntry handler will branch into the
+		// correct instruction.
+		emit_save_sp(state);
+		emit_save_pc(state, true);
+		emit(
+		    "{SPILL}"
+		    "\t\tasea_call_script_function(_regs, {FN});\n"
+		    "\t\treturn;\n",
+		    fmt::arg("SPILL", promoted_variables_spill_code("\t\t")),
+		    fmt::arg("FN", fn_expr)
+		);
+	}
+
+	if (!fast_path_end_label.empty()) {
+		emit("\t\t{}:;\n", fast_path_end_label);
+	}
+}
+
+void BytecodeToC::emit_interface_call_ins(FnState& state, asCScriptFunction& interface_fn) {
+	const std::string cache_symbol = fmt::format("{}_ic{}", m_module_state.fn_name, state.ins.offset);
+	emit_forward_declaration(state, cache_symbol, "extern asea_method_cache {};\n", cache_symbol);
+	if (m_on_map_extern_callback) {
+		m_on_map_extern_callback(cache_symbol.c_str(), ExternMethodCache{}, nullptr);
+	}
+
+	// the VM raises the null pointer exception
+	emit(
+	    "\t\tasCScriptObject* v_obj = sp->as_ptr;\n"
+	    "\t\tif (v_obj == 0) {{\n"
+	);
+	emit_vm_fallback(state, "null interface call");
+	emit(
+	    "\t\t}}\n"
+	    "\t\tasCObjectType* v_obj_type = *(asCObjectType**)((char*)v_obj + {OFF_SCRIPTOBJ_OBJTYPE});\n"
+	    "\t\tasCScriptFunction* v_fn = 0;\n"
+	    "\t\tfor (int i = 0; i < {CACHE_SIZE}; ++i) {{\n"
+	    "\t\t\tasea_method_cache_entry* v_entry = {CACHE}.entries[i];\n"
+	    "\t\t\tif (v_entry != 0 && v_entry->type == v_obj_type) {{\n"
+	    "\t\t\t\tv_fn = v_entry->fn;\n"
+	    "\t\t\t\tbreak;\n"
+	    "\t\t\t}}\n"
+	    "\t\t}}\n"
+	    "\t\tif (v_fn == 0) {{\n"
+	    "\t\t\tv_fn = asea_resolve_interface_method(&{CACHE}, v_obj, (asCScriptFunction*)&{INTERFACE_FN});\n"
+	    "\t\t}}\n"
+	    "\t\tif (v_fn == 0) {{\n",
+	    fmt::arg("OFF_SCRIPTOBJ_OBJTYPE", DIRECT_VALUE_IF_POSSIBLE(asea_offset_scriptobj_objtype)),
+	    fmt::arg("CACHE_SIZE", asea_method_cache_size),
+	    fmt::arg("CACHE", cache_symbol),
+	    fmt::arg("INTERFACE_FN", emit_script_function_lookup(state, interface_fn.GetId()))
+	);
+	emit_vm_fallback(state, "object does not implement the interface");
+	emit("\t\t}}\n");
+
+	emit_direct_script_call_ins(state, ScriptCallByExpr{.fn_decl = &interface_fn, .expr = "v_fn"});
+}
+
+BytecodeToC::VirtualCallTarget BytecodeToC::devirtualize(asCScriptFunction& virtual_fn) const {
+	asCObjectType* type = virtual_fn.objectType;
+	if (type == nullptr || virtual_fn.vfTableIdx < 0
+	    || asUINT(virtual_fn.vfTableIdx) >= type->virtualFunctionTable.GetLength()) {
+		return {.fn = nullptr, .is_guaranteed = false};
+	}
+
+	asCScriptFunction* base_impl = type->virtualFunctionTable[virtual_fn.vfTableIdx];
+	if (base_impl == nullptr || base_impl->funcType != asFUNC_SCRIPT) {
+		return {.fn = nullptr, .is_guaranteed = false};
+	}
+
+	if (virtual_fn.IsFinal() || base_impl->IsFinal() || (type->flags & asOBJ_NOINHERIT) != 0) {
+		return {.fn = base_impl, .is_guaranteed = true};
+	}
+
+	// shared classes may be derived from by modules that are not even built yet, so we can only speculate
+	asIScriptModule* module = type->GetModule();
+	if ((type->flags & asOBJ_SHARED) != 0 || module == nullptr) {
+		return {.fn = base_impl, .is_guaranteed = false};
+	}
+
+	for (asUINT i = 0; i < module->GetObjectTypeCount(); ++i) {
+		auto* other = static_cast<asCObjectType*>(module->GetObjectTypeByIndex(i));
+		if (other != type && other->DerivesFrom(type)
+		    && other->virtualFunctionTable[virtual_fn.vfTableIdx] != base_impl) {
+			return {.fn = base_impl, .is_guaranteed = false};
+		}
+	}
+
+	return {.fn = base_impl, .is_guaranteed = true};
+}
+
+void BytecodeToC::emit_virtual_call_ins(FnState& state, asCScriptFunction& virtual_fn) {
+	const VirtualCallTarget target = devirtualize(virtual_fn);
+
+	// the VM raises the null pointer exception
+	emit(
+	    "\t\tasCScriptObject* v_obj = sp->as_ptr;\n"
+	    "\t\tif (v_obj == 0) {{\n"
+	);
+	emit_vm_fallback(state, "null virtual call");
+	emit("\t\t}}\n");
+
+	if (target.is_guaranteed) {
+		if (m_config->c.human_readable) {
+			emit("\t\t/* devirtualized call to {} */\n", target.fn->GetDeclaration(true, true));
+		}
+		emit_direct_script_call_ins(state, ScriptCallByIdx{target.fn->GetId()});
+		return;
+	}
+
+	emit(
+	    "\t\tasCObjectType* v_obj_type = *(asCObjectType**)((char*)v_obj + {OFF_SCRIPTOBJ_OBJTYPE});\n"
+	    "\t\tasea_array* v_vftable = (asea_array*)((char*)v_obj_type + {OFF_OBJTYPE_VFTABLE});\n"
+	    "\t\tasCScriptFunction* v_fn = ((asCScriptFunction**)(v_vftable->ptr))[{VTABLE_IDX}];\n",
+	    fmt::arg("OFF_SCRIPTOBJ_OBJTYPE", DIRECT_VALUE_IF_POSSIBLE(asea_offset_scriptobj_objtype)),
+	    fmt::arg("OFF_OBJTYPE_VFTABLE", DIRECT_VALUE_IF_POSSIBLE(asea_offset_objtype_vtable)),
+	    fmt::arg("VTABLE_IDX", virtual_fn.vfTableIdx)
+	);
+
+	if (target.fn == nullptr) {
+		emit_direct_script_call_ins(state, ScriptCallByExpr{.fn_decl = &virtual_fn, .expr = "v_fn"});
+		return;
+	}
+
+	// comparing the resolved method rather than the object type also covers subclasses that do not override it
+	emit(
+	    "\t\tif (v_fn == (asCScriptFunction*)&{FN}) {{\n",
+	    fmt::arg("FN", emit_script_function_lookup(state, target.fn->GetId()))
+	);
+	emit_direct_script_call_ins(state, ScriptCallByIdx{target.fn->GetId()});
+	emit("\t\t}} else {{\n");
+	emit_direct_script_call_ins(state, ScriptCallByExpr{.fn_decl = &virtual_fn, .expr = "v_fn"});
+	emit("\t\t}}\n");
+}
+
+void BytecodeToC::emit_dynamic_call(FnState& state, std::string_view fn_expr) {
+	// unbound functions and unusual kinds of functions are left to the VM, which raises the appropriate exception
+	emit(
+	    "\t\tvoid* delegate_obj;\n"
+	    "\t\tasCScriptFunction* callee = asea_resolve_function_handle({FN}, &delegate_obj);\n"
+	    "\t\tif (callee == 0) {{\n",
+	    fmt::arg("FN", fn_expr)
+	);
+	emit_vm_fallback(state, "unbound function or unsupported function kind");
+	emit(
+	    "\t\t}}\n"
+	    "\t\tif (delegate_obj != 0) {{\n"
+	    "\t\t\tsp = (asea_var*)((char*)sp - sizeof(asPWORD));\n"
+	    "\t\t\tsp->as_ptr = delegate_obj;\n"
+	    "\t\t}}\n"
+	    "\t\tif (*(int*)((char*)callee + {OFF_SCRIPTFN_FUNCTYPE}) == {FUNC_SYSTEM}) {{\n",
+	    fmt::arg("OFF_SCRIPTFN_FUNCTYPE", DIRECT_VALUE_IF_POSSIBLE(asea_offset_scriptfn_functype)),
+	    fmt::arg("FUNC_SYSTEM", int(asFUNC_SYSTEM))
+	);
+
+	// the target is only known at runtime, so this cannot use a direct system call
+	emit_context_sync_before_system_call(state);
+	emit_save_sp(state);
+	emit_save_pc(state, true);
+	emit(
+	    "\t\tint callee_id = *(int*)((char*)callee + {OFF_SCRIPTFN_ID});\n"
+	    "\t\tsp = (asea_var*)((asDWORD*)sp + asea_call_system_function(_regs, callee_id));\n"
+	    "\t\tvalue_reg = regs->value;\n",
+	    fmt::arg("OFF_SCRIPTFN_ID", DIRECT_VALUE_IF_POSSIBLE(asea_offset_scriptfn_id))
+	);
+	emit_context_sync_after_system_call(state);
+	emit(
+	    "\t\tif (*(int*)((char*)regs->ctx + {OFF_STATUS}) != asEXECUTION_ACTIVE) {{ goto vm; }}\n",
+	    fmt::arg("OFF_STATUS", DIRECT_VALUE_IF_POSSIBLE(asea_offset_ctx_status))
+	);
+	state.error_handlers_mask |= std::uint64_t(ErrorHandler::VM_FALLBACK);
+	emit_system_call_status_check(state, {});
+	emit("\t\t}} else {{\n");
+
+	emit_direct_script_call_ins(state, ScriptCallByExpr{.fn_decl = nullptr, .expr = "callee"});
+	emit("\t\t}}\n");
+}
+
+bool BytecodeToC::can_inline_script_function(FnState& state, asCScriptFunction& callee) const {
+	if (!m_config->experimental_script_inlining) {
+		return false;
+	}
+
+	// the inlined body never contains calls, so checking against the caller is enough to avoid recursion
+	if (&callee == state.fn || state.inline_info != nullptr || state.is_typed_entry) {
+		return false;
+	}
+
+	if (!can_bypass_script_function(callee)) {
+		return false;
+	}
+
+	if (callee.funcType != asFUNC_SCRIPT || callee.scriptData == nullptr || callee.DoesReturnOnStack()) {
+		return false;
+	}
+
+	// the callee would be responsible for freeing those, which we don't handle
+	for (std::size_t i = 0; i < callee.parameterTypes.GetLength(); ++i) {
+		const auto& param = callee.parameterTypes[i];
+		if ((param.IsObject() || param.IsFuncdef()) && !param.IsReference()) {
+			return false;
+		}
+	}
+
+	// Errors are handled by jumping to the regular call, which executes the callee from the start. That is only valid
+	// if no side effect visible to the caller happened before the error, so we only allow instructions that may raise
+	// errors to appear before any side effect. Without backward jumps, instructions execute in bytecode order, which
+	// makes that check trivial.
+	// Writes to the frame are not side effects, because the inlined frame and arguments are copies.
+	std::size_t instruction_count = 0;
+	bool        had_side_effect   = false;
+	int         arg_space         = -1;
+
+	for (InsRef ins : get_bytecode(callee)) {
+		++instruction_count;
+		if (instruction_count > m_config->script_inlining_max_instructions) {
+			return false;
+		}
+
+		if (is_instruction_blacklisted(ins.opcode()) || ins.opcode() == m_config->debug.fallback_after_instruction) {
+			return false;
+		}
+
+		if (auto jmp = bcins::try_as<bcins::Jump>(ins); jmp.has_value() && jmp->target_offset() <= int(ins.offset)) {
+			return false;
+		}
+
+		if (ins.opcode() == asBC_SUSPEND) {
+			// a pending suspend is left to the regular call, so it must happen before any side effect too
+			if (!m_config->hack_ignore_suspend && had_side_effect) {
+				return false;
+			}
+			continue;
+		}
+
+		if (ins.opcode() == asBC_RET) {
+			if (arg_space != -1 && arg_space != int(ins.word0())) {
+				return false;
+			}
+			arg_space = ins.word0();
+			continue;
+		}
+
+		const auto info = get_simple_instruction_info(ins.opcode());
+		if (!info.is_simple || (info.may_raise && had_side_effect)) {
+			return false;
+		}
+		had_side_effect = had_side_effect || info.has_side_effects;
+	}
+
+	// functions always end with a RET, but be defensive
+	return arg_space != -1;
+}
+
+bool BytecodeToC::can_bypass_script_function(asCScriptFunction& callee) const {
+	if (!m_fn_config_callback) {
+		return true;
+	}
+
+	// functions with JIT disabled must run in the VM, and functions being dumped should run the code that is dumped
+	const FnConfig callee_config = m_fn_config_callback(callee);
+	return !callee_config.disable_jit && !callee_config.dump_c;
+}
+
+/// Type used to pass a parameter to a typed entry point. Parameters are passed as the raw stack slot, so types that are
+/// smaller than a dword are passed as a dword.
+static VarType get_typed_entry_param_type(const asCDataType& type) {
+	using namespace var_types;
+	if (type.IsFloatType()) {
+		return f32;
+	}
+	if (type.IsDoubleType()) {
+		return f64;
+	}
+	return type.GetSizeOnStackDWords() == 2 ? u64 : u32;
+}
+
+bool BytecodeToC::can_use_typed_entry(asCScriptFunction& fn) const {
+	if (!m_config->experimental_typed_script_call) {
+		return false;
+	}
+
+	// an exception raised by a nested call leaves all typed calls at once, so it must not be caught within them
+	if (fn.funcType != asFUNC_SCRIPT || fn.scriptData == nullptr || fn.objectType != nullptr || fn.DoesReturnOnStack()
+	    || fn.scriptData->tryCatchInfo.GetLength() != 0) {
+		return false;
+	}
+
+	const auto is_primitive_value = [](const asCDataType& type) {
+		return type.IsPrimitive() && !type.IsReference() && !type.IsObjectHandle();
+	};
+
+	if (!is_primitive_value(fn.returnType) && fn.returnType.GetTokenType() != ttVoid) {
+		return false;
+	}
+
+	for (std::size_t i = 0; i < fn.parameterTypes.GetLength(); ++i) {
+		if (!is_primitive_value(fn.parameterTypes[i])) {
+			return false;
+		}
+	}
+
+	if (!can_bypass_script_function(fn)) {
+		return false;
+	}
+
+	// unlike inlining, there is no way to recover from errors as there is no VM frame, so reject anything that may
+	// raise. calls are only supported for self-recursion, which is where this matters the most.
+	std::size_t instruction_count = 0;
+	for (InsRef ins : get_bytecode(fn)) {
+		++instruction_count;
+		if (instruction_count > m_config->typed_script_call_max_instructions) {
+			return false;
+		}
+
+		if (is_instruction_blacklisted(ins.opcode()) || ins.opcode() == m_config->debug.fallback_after_instruction) {
+			return false;
+		}
+
+		switch (ins.opcode()) {
+		case asBC_SUSPEND: {
+			if (!m_config->hack_ignore_suspend) {
+				return false;
+			}
+			continue;
+		}
+
+		case asBC_CALL: {
+			if (m_script_engine->scriptFunctions[ins.int0()] != &fn) {
+				return false;
+			}
+			continue;
+		}
+
+		case asBC_PshC4:
+		case asBC_PshV4:
+		case asBC_PshC8:
+		case asBC_PshV8:
+		case asBC_RET:   continue;
+
+		default:         break;
+		}
+
+		const auto info = get_simple_instruction_info(ins.opcode());
+		if (!info.is_simple || info.may_raise) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+std::string BytecodeToC::emit_typed_entry(FnState& state, asCScriptFunction& fn) {
+	if (auto it = m_module_state.typed_entries.find(&fn); it != m_module_state.typed_entries.end()) {
+		return it->second;
+	}
+
+	const std::string symbol = fmt::format("{}_mod{}_typed{}", m_c_symbol_prefix, m_module_idx, fn.GetId());
+
+	// register before translating, so that recursive calls refer to the same entry point
+	m_module_state.typed_entries.emplace(&fn, symbol);
+
+	std::string params;
+	for (std::size_t i = 0; i < fn.parameterTypes.GetLength(); ++i) {
+		params += fmt::format(", {} arg{}", get_typed_entry_param_type(fn.parameterTypes[i]).c, i);
+	}
+
+	// the body is translated as a separate function into the forward declarations, which go before the function code
+	// of the module. the typed entry might get emitted while we are translating another function, so we translate it
+	// to a separate buffer. any declaration it requires will be emitted to the forward declarations before it.
+	std::string outer_function_code = std::exchange(m_module_state.code_blocks.function_code, {});
+
+	// variables of the outer function are promoted independently of the typed entry, which always uses its frame
+	auto outer_promoted_variables = std::exchange(m_module_state.promoted_variables, {});
+
+	FnState typed_state{
+	    .fn                       = &fn,
+	    .ins                      = {},
+	    .has_any_late_jit_entries = false,
+	    .switch_map               = {},
+	    .branch_targets           = {},
+	    .stack_push_infos         = {},
+	    .fn_to_stack_push         = {},
+	    .overriden_instructions   = {},
+	    .ir                       = {},
+	    .emitted_symbols          = std::move(state.emitted_symbols),
+	    .has_direct_generic_call  = false,
+	    .error_handlers_mask      = 0,
+	    .label_prefix             = "bc",
+	    .inline_info              = nullptr,
+	    .is_typed_entry           = true,
+	    .pending_push_dwords      = 0,
+	    .pending_push_pwords      = 0,
+	};
+
+	// past the maximum depth, the function is called regularly, which needs the script function
+	const std::string fn_symbol = emit_script_function_lookup(typed_state, fn.GetId());
+
+	if (m_config->c.human_readable) {
+		emit("/* typed entry for {} */\n", fn.GetDeclaration(true, true, true));
+	}
+
+	// the frame pointer points to the first argument, with local variables below it, and space for pushes below that.
+	const int arg_space   = fn.GetSpaceNeededForArguments();
+	const int stack_space = fn.scriptData->stackNeeded;
+	emit(
+	    "asQWORD {NAME}(asea_vm_registers *regs, asea_typed_call *call, int depth{PARAMS}) {{\n"
+	    "\tasDWORD frame[{FRAME_SIZE}];\n"
+	    "\tasea_var *const fp = (asea_var*)(frame + {STACK_SPACE});\n"
+	    "\tasea_var* sp = (asea_var*)((asDWORD*)fp - {VAR_SPACE});\n"
+	    "\tasQWORD value_reg = 0;\n"
+	    "\tint cond_reg;\n",
+	    fmt::arg("NAME", symbol),
+	    fmt::arg("PARAMS", params),
+	    fmt::arg("FRAME_SIZE", std::max(stack_space + arg_space, 1)),
+	    fmt::arg("STACK_SPACE", stack_space),
+	    fmt::arg("VAR_SPACE", fn.scriptData->variableSpace)
+	);
+
+	int arg_offset = 0;
+	for (std::size_t i = 0; i < fn.parameterTypes.GetLength(); ++i) {
+		const auto& param = fn.parameterTypes[i];
+		emit("\t{} = arg{};\n", frame_var(-arg_offset, get_typed_entry_param_type(param)), i);
+		arg_offset += param.GetSizeOnStackDWords();
+	}
+
+	// the arguments are laid out in the frame like on the script stack
+	emit(
+	    "\tif (depth <= 0) {{\n"
+	    "\t\treturn asea_call_script_nested((asSVMRegisters*)regs, call, (asCScriptFunction*){FN}, (asDWORD*)fp);\n"
+	    "\t}}\n",
+	    fmt::arg("FN", fn_symbol)
+	);
+
+	// JIT entries are not entry points for typed entries, so only jumps are relevant
+	for (InsRef ins : get_bytecode(fn)) {
+		if (auto jmp = bcins::try_as<bcins::Jump>(ins); jmp.has_value()) {
+			typed_state.branch_targets.emplace(jmp->target_offset());
+		}
+	}
+	discover_peephole(typed_state);
+
+	[[maybe_unused]] const std::size_t fallback_count = m_module_state.fallback_count;
+	for (InsRef ins : get_bytecode(fn)) {
+		typed_state.ins = ins;
+		translate_instruction(typed_state);
+	}
+	angelsea_assert(m_module_state.fallback_count == fallback_count && "can_use_typed_entry allowed a fallback");
+	angelsea_assert(typed_state.error_handlers_mask == 0 && "can_use_typed_entry allowed an error");
+
+	state.emitted_symbols             = std::move(typed_state.emitted_symbols);
+	m_module_state.promoted_variables = std::move(outer_promoted_variables);
+
+	emit("}}\n\n");
+
+	std::string typed_entry_code
+	    = std::exchange(m_module_state.code_blocks.function_code, std::move(outer_function_code));
+	m_module_state.code_blocks.forward_declarations += typed_entry_code;
+
+	return symbol;
+}
+
+std::string BytecodeToC::emit_typed_script_call(FnState& state, asCScriptFunction& callee) {
+	std::string args;
+	std::string param_types;
+	int         arg_offset = 0;
+	for (std::size_t i = 0; i < callee.parameterTypes.GetLength(); ++i) {
+		const auto&   param = callee.parameterTypes[i];
+		const VarType type  = get_typed_entry_param_type(param);
+		args += fmt::format(", {}", stack_var(arg_offset, type));
+		param_types += fmt::format(", {}", type.c);
+		arg_offset += param.GetSizeOnStackDWords();
+	}
+
+	if (m_config->c.human_readable) {
+		emit("\t\t/* typed call to {} */\n", callee.GetDeclaration(true, true, true));
+	}
+
+	if (state.is_typed_entry) {
+		// typed entries only call themselves, see can_use_typed_entry. on failure, the exception was raised already
+		emit(
+		    "\t\tvalue_reg = {FN}(regs, call, depth - 1{ARGS});\n"
+		    "\t\tif (call->failed) {{\n"
+		    "\t\t\treturn 0;\n"
+		    "\t\t}}\n"
+		    "\t\tsp = (asea_var*)((asDWORD*)sp + {ARG_SPACE});\n",
+		    fmt::arg("FN", emit_typed_entry(state, callee)),
+		    fmt::arg("ARGS", args),
+		    fmt::arg("ARG_SPACE", arg_offset)
+		);
+		return {};
+	}
+
+	// the typed entry point of another function is only emitted in its own module, which may not be compiled yet. in
+	// that case, the regular call is performed instead.
+	std::string callee_expr;
+	std::string slot_symbol;
+	if (&callee == state.fn) {
+		callee_expr = emit_typed_entry(state, callee);
+	} else {
+		slot_symbol = fmt::format("{}_typedslot{}", m_c_symbol_prefix, callee.GetId());
+		if (m_on_map_extern_callback) {
+			m_on_map_extern_callback(slot_symbol.c_str(), ExternTypedEntry{.fn = &callee}, nullptr);
+		}
+		emit_forward_declaration(state, slot_symbol, "extern void *{};\n", slot_symbol);
+
+		callee_expr = fmt::format(
+		    "((asQWORD (*)(asea_vm_registers*, asea_typed_call*, int{}))({}))",
+		    param_types,
+		    slot_symbol
+		);
+	}
+
+	const std::size_t typed_call_idx = m_module_state.typed_call_idx;
+	++m_module_state.typed_call_idx;
+
+	// past the maximum depth, the innermost typed call performs a regular call, which raises a stack overflow if the
+	// limit of the engine was reached
+	const std::string end_label = fmt::format("typed{}_end", typed_call_idx);
+	emit(
+	    "\t\t{OPEN}\n"
+	    "\t\tasea_typed_call typed{IDX} = {{{SHADOW}, base_pc + {NEXT_INS_OFFSET}, (asDWORD*)sp, 0}};\n"
+	    "\t\tvalue_reg = {FN}(regs, &typed{IDX}, asea_remaining_call_depth(_regs, {SHADOW}, {MAX_DEPTH}){ARGS});\n"
+	    "\t\tif (typed{IDX}.failed) {{\n"
+	    "\t\t\t{FAIL}\n"
+	    "\t\t}}\n"
+	    "\t\tsp = (asea_var*)((asDWORD*)sp + {ARG_SPACE});\n"
+	    "\t\tgoto {END};\n"
+	    "\t\t}}\n",
+	    fmt::arg("OPEN", slot_symbol.empty() ? std::string{"{"} : fmt::format("if ({} != 0) {{", slot_symbol)),
+	    fmt::arg("IDX", typed_call_idx),
+	    fmt::arg("SHADOW", uses_shadow_call_stack() ? "shadow" : "0"),
+	    fmt::arg("NEXT_INS_OFFSET", state.ins.offset + state.ins.size()),
+	    fmt::arg("FN", callee_expr),
+	    fmt::arg("MAX_DEPTH", m_config->typed_script_call_max_depth),
+	    fmt::arg("ARGS", args),
+	    fmt::arg("FAIL", jump_to_error_handler_code(state, ErrorHandler::VM_FALLBACK)),
+	    fmt::arg("ARG_SPACE", arg_offset),
+	    fmt::arg("END", end_label)
+	);
+
+	return end_label;
+}
+
+std::string BytecodeToC::emit_inlined_script_call(FnState& state, asCScriptFunction& callee) {
+	const std::size_t inline_idx = m_module_state.inline_idx;
+	++m_module_state.inline_idx;
+
+	InlineInfo info{
+	    .deopt_label  = fmt::format("inl{}_deopt", inline_idx),
+	    .return_label = fmt::format("inl{}_ret", inline_idx),
+	};
 
-		if (m_on_map_extern_callback) {
-			m_on_map_extern_callback(fn_raw_name.c_str(), ExternScriptFunction{call_by_idx->fn_idx}, known_fn);
+	// arg_space is the same for all RETs, as checked in can_inline_script_function
+	int arg_space = 0;
+	for (InsRef ins : get_bytecode(callee)) {
+		if (ins.opcode() == asBC_RET) {
+			arg_space = ins.word0();
+			break;
 		}
-
-		emit_forward_declaration(state, fn_raw_name, "extern char {}[];\n", fn_raw_name);
-	} else if (auto* call_by_expr = std::get_if<ScriptCallByExpr>(&call); call_by_expr != nullptr) {
-		fn_expr      = call_by_expr->expr;
-		reference_fn = call_by_expr->fn_decl;
-	} else {
-		angelsea_assert(false);
 	}
+	const int var_space = callee.scriptData->variableSpace;
 
-	if (will_emit_direct) {
-		if (known_fn != nullptr) {
-			emit(
-			    "\t\tasea_prepare_script_stack(_regs, {FN}, base_pc + {INS_OFFSET}, sp, fp);\n",
-			    fmt::arg("FN", fn_expr),
-			    fmt::arg("BYTECODE", m_module_state.fn_bytecode_ptr),
-			    fmt::arg("INS_OFFSET", state.ins.offset + state.ins.size())
-			);
-			bool emitted_fp_var = false;
-			// setup stack with our knowledge
-			for (asUINT n = known_fn->scriptData->variables.GetLength(); n-- > 0;) {
-				asSScriptVariable* var = known_fn->scriptData->variables[n];
-
-				// don't clear the function arguments
-				if (var->stackOffset <= 0) {
-					continue;
-				}
+	if (m_config->c.human_readable) {
+		emit("\t\t/* inlined call to {} */\n", callee.GetDeclaration(true, true, true));
+	}
 
-				if (var->onHeap && (var->type.IsObject() || var->type.IsFuncdef())) {
-					if (!emitted_fp_var) {
-						emit("\t\tasDWORD* callee_fp = regs->fp;\n");
-						emitted_fp_var = true;
-					}
+	// the callee frame pointer points to the first argument, with local variables below it. we shadow fp so that
+	// instructions can be translated as usual.
+	emit(
+	    "\t\t{{\n"
+	    "\t\tasDWORD inl{IDX}_frame[{FRAME_SIZE}];\n"
+	    "\t\tmemcpy(inl{IDX}_frame + {VAR_SPACE}, sp, {ARG_SPACE} * sizeof(asDWORD));\n"
+	    "\t\tasea_var *const fp = (asea_var*)(inl{IDX}_frame + {VAR_SPACE});\n",
+	    fmt::arg("IDX", inline_idx),
+	    fmt::arg("FRAME_SIZE", std::max(var_space + arg_space, 1)),
+	    fmt::arg("VAR_SPACE", var_space),
+	    fmt::arg("ARG_SPACE", arg_space)
+	);
 
-					if (m_config->c.human_readable) {
-						emit("\t\t/* arg {} requires clearing @ stack pos {} */\n", n, -var->stackOffset);
-					}
+	// the callee frame is not promoted, and the promoted variables of the caller are not reachable from the callee
+	auto outer_promoted_variables = std::exchange(m_module_state.promoted_variables, {});
+
+	FnState callee_state{
+	    .fn                       = &callee,
+	    .ins                      = {},
+	    .has_any_late_jit_entries = false,
+	    .switch_map               = {},
+	    .branch_targets           = {},
+	    .stack_push_infos         = {},
+	    .fn_to_stack_push         = {},
+	    .overriden_instructions   = {},
+	    .ir                       = {},
+	    .emitted_symbols          = std::move(state.emitted_symbols),
+	    .has_direct_generic_call  = false,
+	    .error_handlers_mask      = 0,
+	    .label_prefix             = fmt::format("inl{}_bc", inline_idx),
+	    .inline_info              = &info,
+	    .is_typed_entry           = false,
+	    .pending_push_dwords      = 0,
+	    .pending_push_pwords      = 0,
+	};
 
-					emit("\t\t((asea_var*)(callee_fp + {}))->as_asPWORD = 0;\n", -var->stackOffset);
-				}
-			}
-		} else {
-			// if the function is not known, do the above stack logic dynamically in runtime
-			emit(
-			    "\t\tasea_prepare_script_stack_and_vars(_regs, {FN}, base_pc + {INS_OFFSET}, sp, fp);\n",
-			    fmt::arg("FN", fn_expr),
-			    fmt::arg("BYTECODE", m_module_state.fn_bytecode_ptr),
-			    fmt::arg("INS_OFFSET", state.ins.offset + state.ins.size())
-			);
+	// JIT entries are not entry points within inlined code, so only jumps are relevant
+	for (InsRef ins : get_bytecode(callee)) {
+		if (auto jmp = bcins::try_as<bcins::Jump>(ins); jmp.has_value()) {
+			callee_state.branch_targets.emplace(jmp->target_offset());
 		}
+	}
+	discover_peephole(callee_state);
 
-		if (known_fn == state.fn) {
-			if (m_config->c.human_readable) {
-				emit("\t\t/* recursive call */\n");
-			}
-			emit(
-			    "\t\t{SELF}(_regs, 1);\n"
-			    "\t\treturn;\n",
-			    fmt::arg("SELF", m_module_state.fn_name)
-			);
-		} else {
-			// look up JITFunction to branch into directly. if it doesn't exist that's fine; in both case we drop to
-			// the vm right after
-			emit(
-			    "\t\tvoid* script_data = *(void**)((char*)({FN}) + {OFF_SCRIPTFN_SCRIPTDATA});\n"
-			    "\t\tasea_jit_fn jit_fn = *(asea_jit_fn*)((char*)script_data + {OFF_SCRIPTDATA_JITFN});\n"
-			    "\t\tif (jit_fn) {{ jit_fn(_regs, 1); return; }}\n"
-			    "\t\treturn;\n",
-			    fmt::arg("FN", fn_expr),
-			    fmt::arg("OFF_SCRIPTFN_SCRIPTDATA", DIRECT_VALUE_IF_POSSIBLE(asea_offset_scriptfn_scriptdata)),
-			    fmt::arg("OFF_SCRIPTDATA_JITFN", DIRECT_VALUE_IF_POSSIBLE(asea_offset_scriptdata_jitfunction))
-			);
-		}
-	} else {
-		// Call fallback: We initiate the call from JIT, and the rest of the JitEntry handler will branch into the
-		// correct instruction.
-		emit_save_sp(state);
-		emit_save_pc(state, true);
-		emit(
-		    "\t\tasea_call_script_function(_regs, {FN});\n"
-		    "\t\treturn;\n",
-		    fmt::arg("FN", fn_expr)
-		);
+	[[maybe_unused]] const std::size_t fallback_count = m_module_state.fallback_count;
+	for (InsRef ins : get_bytecode(callee)) {
+		callee_state.ins = ins;
+		translate_instruction(callee_state);
 	}
+	angelsea_assert(
+	    m_module_state.fallback_count == fallback_count && "can_inline_script_function allowed a fallback"
+	);
+
+	state.emitted_symbols             = std::move(callee_state.emitted_symbols);
+	m_module_state.promoted_variables = std::move(outer_promoted_variables);
+
+	const std::string end_label = fmt::format("inl{}_end", inline_idx);
+	emit(
+	    "\t\t}}\n"
+	    "\t\t{RET}:\n"
+	    "\t\tsp = (asea_var*)((asDWORD*)sp + {ARG_SPACE});\n"
+	    "\t\tgoto {END};\n"
+	    "\t\t{DEOPT}:\n",
+	    fmt::arg("RET", info.return_label),
+	    fmt::arg("ARG_SPACE", arg_space),
+	    fmt::arg("END", end_label),
+	    fmt::arg("DEOPT", info.deopt_label)
+	);
+
+	return end_label;
 }
 
 void BytecodeToC::emit_system_call(FnState& state, SystemCall call) {
+	call.traits    = get_system_function_traits(call.fn_idx);
+	call.intrinsic = get_system_function_intrinsic(call.fn_idx);
+	if (call.intrinsic != nullptr) {
+		// the intrinsic is evaluated in JIT code, so it can neither throw nor use the context
+		call.traits.nothrow           = true;
+		call.traits.no_context_access = true;
+	}
+
 	if (m_config->c.human_readable) {
 		emit(
 		    "\t\t/* Attempt direct system call for `{}` */\n",
@@ -1518,7 +3098,29 @@ void BytecodeToC::emit_system_call(FnState& state, SystemCall call) {
 			return;
 		}
 
-		const auto result = emit_direct_system_call(state, call, abi);
+		// may be modified for this ABI only
+		SystemCall abi_call = call;
+
+		if (!abi_call.is_internal_call && !can_skip_system_call_state_sync(abi_call.traits)) {
+			emit_context_sync_before_system_call(state);
+		}
+
+		auto result = emit_direct_system_call(state, abi_call, abi);
+		if (!result.ok && abi_call.intrinsic != nullptr) {
+			// nothing was emitted yet, so retry as a regular call, which does not benefit from the implied traits
+			if (m_config->c.human_readable) {
+				emit("\t\t/* Intrinsic not used: {} */\n", result.fail_reason);
+			}
+
+			abi_call.intrinsic = nullptr;
+			abi_call.traits    = get_system_function_traits(abi_call.fn_idx);
+			if (!abi_call.is_internal_call && !can_skip_system_call_state_sync(abi_call.traits)) {
+				emit_context_sync_before_system_call(state);
+			}
+
+			result = emit_direct_system_call(state, abi_call, abi);
+		}
+
 		if (!result.ok) {
 			// fallback approach to ensure the call always succeeds even if we cannot emit a direct call
 			if (m_config->c.human_readable) {
@@ -1546,8 +3148,6 @@ void BytecodeToC::emit_system_call(FnState& state, SystemCall call) {
 				    "\t\tvalue_reg = regs->value;\n",
 				    fmt::arg("FN", call.fn_idx)
 				);
-
-				// FIXME: doprocessuspend check wrt setting *script* exceptions correctness
 			} else {
 				// TODO: assert for method
 				emit_save_sp(state);
@@ -1555,6 +3155,13 @@ void BytecodeToC::emit_system_call(FnState& state, SystemCall call) {
 				emit("\t\tasea_call_object_method(_regs, {}, {});\n", call.object_pointer_override, call.fn_idx);
 			}
 		}
+
+		if (!call.is_internal_call) {
+			if (!can_skip_system_call_state_sync(abi_call.traits)) {
+				emit_context_sync_after_system_call(state);
+			}
+			emit_system_call_status_check(state, abi_call.traits);
+		}
 	};
 
 	// TODO: move this logic in its own function
@@ -1576,14 +3183,6 @@ void BytecodeToC::emit_system_call(FnState& state, SystemCall call) {
 }
 
 BytecodeToC::SystemCallEmitResult BytecodeToC::emit_direct_system_call(FnState& state, SystemCall call, AbiMask abi) {
-	if (!m_config->hack_ignore_exceptions) {
-		return {.ok = false, .fail_reason = "Direct system call failed: hack_ignore_exceptions == false"};
-	}
-
-	if (!m_config->hack_ignore_suspend) {
-		return {.ok = false, .fail_reason = "Direct system call failed: hack_ignore_suspend == false"};
-	}
-
 	const std::string           fn_callable_symbol = fmt::format("{}_sysfnptr{}", m_c_symbol_prefix, call.fn_idx);
 	const std::string           fn_desc_symbol     = fmt::format("{}_sysfn{}", m_c_symbol_prefix, call.fn_idx);
 	asCScriptFunction&          script_fn          = *m_script_engine->scriptFunctions[call.fn_idx];
@@ -1606,6 +3205,56 @@ BytecodeToC::SystemCallEmitResult BytecodeToC::emit_direct_system_call(FnState&
 	return emit_direct_system_call_native(state, call, script_fn, fn_desc_symbol, fn_callable_symbol, abi);
 }
 
+/// Number of DWORDs that an argument of type `type` takes on the AngelScript stack when calling a system function.
+static int get_system_argument_dwords(const asCDataType& type) {
+	if (type.GetTokenType() == ttQuestion) {
+		return AS_PTR_SIZE + 1; // reference followed by the type ID
+	}
+	if (type.IsReference() || type.IsObjectHandle() || !type.IsPrimitive()) {
+		return AS_PTR_SIZE;
+	}
+	return type.GetSizeOnStackDWords();
+}
+
+std::optional<asUINT> BytecodeToC::get_variadic_argument_count(
+    FnState&                 state,
+    const asCScriptFunction& fn,
+    std::size_t              hidden_pushes
+) const {
+	// the arguments of a call are pushed right before it, without anything in between
+	std::vector<std::size_t> pushes;
+	for (InsRef ins : get_bytecode(*state.fn)) {
+		if (ins.offset == state.ins.offset) {
+			break;
+		}
+
+		if (state.branch_targets.contains(ins.offset) || !bcins::is_specific_ins<bcins::StackPush>(ins)) {
+			pushes.clear();
+		}
+		if (bcins::is_specific_ins<bcins::StackPush>(ins)) {
+			pushes.push_back(ins.offset);
+		}
+	}
+
+	// the last push is at the top of the stack: skip over the hidden pointers and the fixed parameters
+	std::size_t pushes_before_count = hidden_pushes;
+	for (asUINT i = 0; i + 1 < fn.parameterTypes.GetLength(); ++i) {
+		pushes_before_count += fn.parameterTypes[i].GetTokenType() == ttQuestion ? 2 : 1;
+	}
+
+	if (pushes_before_count >= pushes.size()) {
+		return std::nullopt;
+	}
+
+	const std::size_t count_push_offset = pushes[pushes.size() - 1 - pushes_before_count];
+	const InsRef      count_push        = *get_bytecode(*state.fn).begin().advanced_by_dwords(count_push_offset);
+	if (count_push.opcode() != asBC_PshC4) {
+		return std::nullopt;
+	}
+
+	return count_push.dword0();
+}
+
 struct VirtualStack {
 	std::int64_t dword_offset = 0, pword_offset = 0;
 	std::size_t  real_stack_offset = 0;
@@ -1636,33 +3285,92 @@ BytecodeToC::SystemCallEmitResult BytecodeToC::emit_direct_system_call_native(
 	// adding an unordered map that tracks *yet another* thing and i fear that if i keep going clang will ultimately
 	// gain consciousness just enough for it to remove itself from my drive
 
-	if (!m_config->experimental_direct_native_call) {
+	// intrinsics only reuse the argument handling and never call the function
+	if (!m_config->experimental_direct_native_call && call.intrinsic == nullptr) {
 		return {.ok = false, .fail_reason = "Direct native call failed: experimental_direct_native_call == false"};
 	}
 
 	asSSystemFunctionInterface& sys_fn = *fn.sysFuncIntf;
 
-	if (sys_fn.isCompositeIndirect) {
-		return {.ok = false, .fail_reason = "Direct native call failed: Cannot handle compositeIndirect yet"};
+	// the generated code has no unwind tables, so an exception must not leave a callee that is called from it. calls
+	// to functions that may throw go through a C++ trampoline instead, which only handles some signatures
+	const bool is_guarded = !m_config->hack_ignore_exceptions && !call.traits.nothrow && call.intrinsic == nullptr;
+
+	// For the thiscall conventions, `obj` is the C++ `this`. It is the script object unless the method is called on
+	// the auxiliary object, either as a global function (THISCALL_ASGLOBAL) or as a method of the script object
+	// (THISCALL_OBJLAST/OBJFIRST), in which case the script object is passed as `second_obj` instead.
+	// For the cdecl conventions, `obj` is the script object, passed as a regular argument.
+	const bool has_second_obj        = sys_fn.callConv >= ICC_THISCALL_OBJLAST;
+	const bool is_auxiliary_this     = sys_fn.callConv >= ICC_THISCALL && sys_fn.auxiliary != nullptr;
+	const bool has_composite         = sys_fn.compositeOffset != 0 || sys_fn.isCompositeIndirect;
+	const bool takes_obj_from_stack  = sys_fn.callConv >= ICC_THISCALL && (!is_auxiliary_this || has_second_obj);
+	const bool is_script_object_this = takes_obj_from_stack && !has_second_obj;
+
+	if (has_second_obj && sys_fn.auxiliary == nullptr) {
+		return {.ok = false, .fail_reason = "Direct native call failed: Missing auxiliary object for OBJLAST/OBJFIRST"};
+	}
+
+	if (has_composite && !is_script_object_this) {
+		return {.ok = false, .fail_reason = "Direct native call failed: Composite member of a non-script object"};
 	}
 
-	if (sys_fn.auxiliary != nullptr || sys_fn.callConv >= ICC_THISCALL_OBJLAST) {
-		return {.ok = false, .fail_reason = "Direct native call failed: Cannot make sense of auxiliary functions yet"};
+	if (sys_fn.baseOffset > 0 && abi == AbiMask::GENERIC) {
+		return {.ok = false, .fail_reason = "baseOffset (from multiple inheritance) is not supported on this ABI."};
 	}
 
-	if (fn.returnType.IsFuncdef() && !fn.returnType.IsReference()) {
-		return {.ok = false, .fail_reason = "Direct native call failed: Need to add tests for funcdef return"};
+	// the native function is declared with a C variadic argument list after the count, and the number of arguments
+	// of the call site gives its signature. the variadic arguments come in the same layout as regular parameters
+	// would, e.g. as a reference and type ID pair for each `?` argument
+	std::optional<asUINT> variadic_count;
+	if (fn.IsVariadic()) {
+		const asCDataType& variadic_type = fn.parameterTypes[fn.parameterTypes.GetLength() - 1];
+
+		if (call.intrinsic != nullptr) {
+			return {.ok = false, .fail_reason = "Intrinsic failed: Variadic functions are not supported"};
+		}
+
+		if (sys_fn.callConv == ICC_CDECL_OBJLAST || sys_fn.callConv == ICC_THISCALL_OBJLAST
+		    || sys_fn.callConv == ICC_VIRTUAL_THISCALL_OBJLAST) {
+			return {.ok = false, .fail_reason = "Direct native call failed: Variadic function with object last"};
+		}
+
+		// other types would be subject to default argument promotions
+		if (variadic_type.GetTokenType() != ttQuestion && !variadic_type.IsReference()
+		    && !variadic_type.IsObjectHandle()) {
+			return {.ok = false, .fail_reason = "Direct native call failed: Variadic parameter passed by value"};
+		}
+
+		if (sys_fn.cleanArgs.GetLength() > 0 || sys_fn.hasAutoHandles) {
+			return {.ok = false, .fail_reason = "Direct native call failed: Variadic function with argument cleanup"};
+		}
+
+		const bool        returns_on_stack = is_complex_passed_by_value(fn.returnType) || fn.DoesReturnOnStack();
+		const std::size_t hidden_pushes
+		    = std::size_t(takes_obj_from_stack && call.object_pointer_override.empty()) + std::size_t(returns_on_stack);
+		variadic_count = get_variadic_argument_count(state, fn, hidden_pushes);
+		if (!variadic_count.has_value()) {
+			return {.ok = false, .fail_reason = "Direct native call failed: Unknown variadic argument count"};
+		}
 	}
 
-	// TODO: don't use it since upstream AS has a TODO to remove it
+	// like the VM, release auto handle parameters and add a reference to auto handle returns after the call
+	// TODO: don't use paramAutoHandles since upstream AS has a TODO to remove it
+	std::vector<int> param_auto_handle_releases(fn.parameterTypes.GetLength(), 0);
 	for (std::size_t i = 0; i < sys_fn.paramAutoHandles.GetLength(); ++i) {
 		if (sys_fn.paramAutoHandles[i]) {
-			return {.ok = false, .fail_reason = "Direct native call failed: Cannot handle auto handles in params yet"};
+			param_auto_handle_releases[i] = get_auto_handle_behaviour(fn.parameterTypes[i], false);
+			if (param_auto_handle_releases[i] == 0) {
+				return {.ok = false, .fail_reason = "Direct native call failed: No release behaviour for auto handle"};
+			}
 		}
 	}
 
+	int return_auto_handle_addref = 0;
 	if (sys_fn.returnAutoHandle) {
-		return {.ok = false, .fail_reason = "Direct native call failed: Cannot handle auto handles in return yet"};
+		return_auto_handle_addref = get_auto_handle_behaviour(fn.returnType, true);
+		if (return_auto_handle_addref == 0) {
+			return {.ok = false, .fail_reason = "Direct native call failed: No addref behaviour for auto handle"};
+		}
 	}
 
 	std::deque<std::string> struct_decls; // for pointer stability as we refer to the strings
@@ -1699,6 +3407,10 @@ BytecodeToC::SystemCallEmitResult BytecodeToC::emit_direct_system_call_native(
 
 	VarType return_type = {"void", {}, 0};
 
+	if (call.intrinsic != nullptr && is_complex_passed_by_value(fn.returnType)) {
+		return {.ok = false, .fail_reason = "Intrinsic failed: Complex return types are not supported"};
+	}
+
 	if (!is_complex_passed_by_value(fn.returnType)) {
 		return_type = get_var_type(fn.returnType);
 
@@ -1714,8 +3426,12 @@ BytecodeToC::SystemCallEmitResult BytecodeToC::emit_direct_system_call_native(
 	case ICC_CDECL_OBJFIRST:
 	case ICC_CDECL_OBJLAST:
 	case ICC_VIRTUAL_THISCALL:
-	case ICC_THISCALL:         break;
-	default:                   return {.ok = false, .fail_reason = "Unsupported calling convention"};
+	case ICC_THISCALL:
+	case ICC_THISCALL_OBJLAST:
+	case ICC_THISCALL_OBJFIRST:
+	case ICC_VIRTUAL_THISCALL_OBJLAST:
+	case ICC_VIRTUAL_THISCALL_OBJFIRST: break;
+	default:                            return {.ok = false, .fail_reason = "Unsupported calling convention"};
 	}
 
 	// gather arguments to build C signature (and early fail on unsupported types)
@@ -1812,12 +3528,16 @@ BytecodeToC::SystemCallEmitResult BytecodeToC::emit_direct_system_call_native(
 	};
 	const auto push_stack_argument = [&](VarType type) { push_abi_argument(type, virtual_stack_pop_expr(type)); };
 
-	const bool is_thiscall_objfirst = sys_fn.callConv == ICC_THISCALL || sys_fn.callConv == ICC_VIRTUAL_THISCALL
-	    /*|| sys_fn.callConv == ICC_VIRTUAL_THISCALL_OBJFIRST*/;
+	const bool is_thiscall_objfirst
+	    = sys_fn.callConv == ICC_THISCALL || sys_fn.callConv == ICC_VIRTUAL_THISCALL || has_second_obj;
 	const bool is_cdecl_objfirst = sys_fn.callConv == ICC_CDECL_OBJFIRST;
+	const bool is_second_objfirst
+	    = sys_fn.callConv == ICC_THISCALL_OBJFIRST || sys_fn.callConv == ICC_VIRTUAL_THISCALL_OBJFIRST;
+	const bool is_second_objlast
+	    = sys_fn.callConv == ICC_THISCALL_OBJLAST || sys_fn.callConv == ICC_VIRTUAL_THISCALL_OBJLAST;
 
-	if (sys_fn.callConv >= ICC_THISCALL) {
-		// always load `this` from the first position in the stack
+	if (takes_obj_from_stack) {
+		// always load the script object from the first position in the stack
 		if (call.object_pointer_override.empty()) {
 			obj_expr = virtual_stack_pop_expr(var_types::void_ptr);
 			virtual_stack.take_pwords(1);
@@ -1837,10 +3557,11 @@ BytecodeToC::SystemCallEmitResult BytecodeToC::emit_direct_system_call_native(
 	}
 
 	// Handle complex return logic depending on active C++ ABI.
-	// For the C++ thiscall ABI, gcc always puts the return pointer as the first ABI parameter.
+	// On the Itanium C++ ABI (used by gcc and clang on x86-64), non-trivially copyable types are returned through a
+	// hidden pointer to caller-allocated memory, which is always the first ABI parameter, even before `this`.
 	// MSVC puts it after the object parameter.
 	// CDECL_OBJFIRST is always after the return pointer since this is at application level.
-	if (abi == AbiMask::LINUX_GCC_X86_64 || abi == AbiMask::WINDOWS_MINGW_X86_64) {
+	if (abi == AbiMask::LINUX_GCC_X86_64 || abi == AbiMask::MACOS_X86_64 || abi == AbiMask::WINDOWS_MINGW_X86_64) {
 		if (is_complex_passed_by_value(fn.returnType)) {
 			push_abi_argument(var_types::void_ptr, "ret_ptr");
 		}
@@ -1870,13 +3591,18 @@ BytecodeToC::SystemCallEmitResult BytecodeToC::emit_direct_system_call_native(
 		push_abi_argument(var_types::void_ptr, "obj");
 	}
 
-	for (std::size_t i = 0; i < fn.parameterTypes.GetLength(); ++i) {
-		const auto& param_type = fn.parameterTypes[i];
-
-		stack_offset_to_arg_id.emplace(virtual_stack.real_stack_offset, args.size());
+	if (is_second_objfirst) {
+		push_abi_argument(var_types::void_ptr, "second_obj");
+	}
 
+	const auto push_parameter = [&](const asCDataType& param_type) {
 		if (param_type.GetTokenType() == ttQuestion) {
-			return {.ok = false, .fail_reason = "Direct native call failed: Cannot handle variable arguments yet"};
+			// variable type: the application receives the reference, followed by the type ID that is pushed right
+			// after it on the stack
+			push_stack_argument(var_types::void_ptr);
+			virtual_stack.take_pwords(1);
+			push_stack_argument(var_types::s32);
+			virtual_stack.take_dwords(1);
 		} else if (param_type.IsReference() || param_type.IsObjectHandle()) {
 			push_stack_argument(var_types::void_ptr);
 			virtual_stack.take_pwords(1);
@@ -1884,6 +3610,8 @@ BytecodeToC::SystemCallEmitResult BytecodeToC::emit_direct_system_call_native(
 			push_stack_argument(get_var_type(param_type));
 			virtual_stack.take_dwords(param_type.GetSizeOnStackDWords());
 		} else if (is_complex_passed_by_value(param_type)) {
+			// non-trivially copyable types are passed by invisible reference to a temporary owned by the caller. the
+			// VM already made a copy for us on the heap, which gets destroyed with the other arguments after the call
 			push_stack_argument(var_types::void_ptr);
 			virtual_stack.take_pwords(1);
 		} else {
@@ -1901,13 +3629,69 @@ BytecodeToC::SystemCallEmitResult BytecodeToC::emit_direct_system_call_native(
 			to_emit_after_call += fmt::format("\t\tasea_free({});\n", arg_ptr);
 			virtual_stack.take_pwords(1);
 		}
+	};
+
+	const std::size_t        fixed_param_count = fn.parameterTypes.GetLength() - (variadic_count.has_value() ? 1 : 0);
+	std::vector<std::size_t> param_arg_ids(fixed_param_count);
+
+	for (std::size_t i = 0; i < fixed_param_count; ++i) {
+		stack_offset_to_arg_id.emplace(virtual_stack.real_stack_offset, args.size());
+		param_arg_ids[i] = args.size();
+		push_parameter(fn.parameterTypes[i]);
+	}
+
+	std::size_t variadic_arg_begin = args.size();
+	if (variadic_count.has_value()) {
+		push_stack_argument(var_types::u32);
+		virtual_stack.take_dwords(1);
+
+		variadic_arg_begin = args.size();
+		for (asUINT i = 0; i < *variadic_count; ++i) {
+			push_parameter(fn.parameterTypes[fixed_param_count]);
+		}
 	}
 
 	if (sys_fn.callConv == ICC_CDECL_OBJLAST) {
 		push_abi_argument(var_types::void_ptr, "obj");
 	}
 
-	if (abi == AbiMask::MACOS_AARCH64) {
+	if (is_second_objlast) {
+		push_abi_argument(var_types::void_ptr, "second_obj");
+	}
+
+	// the trampoline passes every argument as an `asQWORD` in a general purpose register
+	std::string_view guarded_call_fn;
+	std::string      guarded_return_cast;
+	if (is_guarded) {
+		const auto is_integer_class = [](const VarType& type) {
+			return type == var_types::void_ptr || type == var_types::u32 || type == var_types::s32
+			    || type == var_types::u64 || type == var_types::pword;
+		};
+
+		if (variadic_count.has_value() || args.size() > asea_native_guarded_max_args
+		    || !std::ranges::all_of(args, is_integer_class, &std::pair<VarType, std::string>::first)) {
+			return {.ok = false, .fail_reason = "Direct native call failed: Signature cannot be guarded"};
+		}
+
+		guarded_call_fn = "asea_call_native_guarded";
+		if (return_type == var_types::f32) {
+			guarded_call_fn = "asea_call_native_guarded_f32";
+		} else if (return_type == var_types::f64) {
+			guarded_call_fn = "asea_call_native_guarded_f64";
+		} else if (return_type == var_types::void_ptr) {
+			guarded_return_cast = "(void*)(asPWORD)";
+		} else if (is_integer_class(return_type)) {
+			// like the VM, only keep the bytes of the return type
+			const int return_size = fn.returnType.GetSizeInMemoryBytes();
+			guarded_return_cast   = return_size == 1 ? "(asBYTE)"
+			                      : return_size == 2 ? "(asWORD)"
+			                                         : fmt::format("({})", return_type.c);
+		} else if (return_type.c != "void") {
+			return {.ok = false, .fail_reason = "Direct native call failed: Return type cannot be guarded"};
+		}
+	}
+
+	if (abi == AbiMask::MACOS_AARCH64 && call.intrinsic == nullptr) {
 		if (max_regs_used > 8) {
 			// this function *might* have passed arguments on the stack (the heuristic is conservative). this is known
 			// problematic on MIR with macOS aarch64 due to argument alignment differences. aarch64 macOS allows denser
@@ -1922,6 +3706,22 @@ BytecodeToC::SystemCallEmitResult BytecodeToC::emit_direct_system_call_native(
 		}
 	}
 
+	std::string intrinsic_expression;
+	if (call.intrinsic != nullptr) {
+		std::vector<std::string> param_exprs(param_arg_ids.size());
+		for (std::size_t i = 0; i < param_exprs.size(); ++i) {
+			param_exprs[i] = args[param_arg_ids[i]].second;
+		}
+
+		// `$this` is the script object the method is called on, even when the C++ `this` is the auxiliary object
+		const std::string_view script_obj_expr = !takes_obj_from_stack ? "" : (has_second_obj ? "second_obj" : "obj");
+		intrinsic_expression
+		    = substitute_intrinsic_placeholders(call.intrinsic->expression, param_exprs, script_obj_expr);
+		if (intrinsic_expression.empty()) {
+			return {.ok = false, .fail_reason = "Intrinsic failed: Expression refers to a nonexistent argument"};
+		}
+	}
+
 	// can start emit()s from this point on
 
 	emit("{}", to_emit_before_call);
@@ -1943,16 +3743,44 @@ BytecodeToC::SystemCallEmitResult BytecodeToC::emit_direct_system_call_native(
 		}
 	}
 
-	if (sys_fn.callConv >= ICC_THISCALL) {
+	if (takes_obj_from_stack) {
+		const std::string_view script_obj_var = has_second_obj ? "second_obj" : "obj";
 		if (call.object_pointer_override.empty()) {
 			emit(
-			    "\t\tvoid *obj = {OBJ_EXPR};\n"
-			    "\t\tif (obj == 0) {{ {ERR_NULL_HANDLER} }}\n",
+			    "\t\tvoid *{VAR} = {OBJ_EXPR};\n"
+			    "\t\tif ({VAR} == 0) {{ {ERR_NULL_HANDLER} }}\n",
+			    fmt::arg("VAR", script_obj_var),
 			    fmt::arg("ERR_NULL_HANDLER", jump_to_error_handler_code(state, ErrorHandler::ERR_NULL)),
 			    fmt::arg("OBJ_EXPR", obj_expr)
 			);
 		} else {
-			emit("\t\tvoid *obj = {};\n", call.object_pointer_override);
+			emit("\t\tvoid *{} = {};\n", script_obj_var, call.object_pointer_override);
+		}
+	}
+
+	if (is_auxiliary_this) {
+		const std::string auxiliary_symbol = fmt::format("{}_sysfnaux{}", m_c_symbol_prefix, call.fn_idx);
+		if (m_on_map_extern_callback) {
+			m_on_map_extern_callback(
+			    auxiliary_symbol.c_str(),
+			    ExternSystemFunctionAuxiliary{call.fn_idx},
+			    sys_fn.auxiliary
+			);
+		}
+		emit_forward_declaration(state, auxiliary_symbol, "extern char {}[];\n", auxiliary_symbol);
+		emit("\t\tvoid *obj = (void*){};\n", auxiliary_symbol);
+	}
+
+	// methods of a member of the script object, registered with a composite offset, like the VM does before applying
+	// the base offset of the method
+	if (has_composite) {
+		emit("\t\tobj = (char*)obj + {};\n", sys_fn.compositeOffset);
+		if (sys_fn.isCompositeIndirect) {
+			emit(
+			    "\t\tobj = *(void**)obj;\n"
+			    "\t\tif (obj == 0) {{ {ERR_NULL_HANDLER} }}\n",
+			    fmt::arg("ERR_NULL_HANDLER", jump_to_error_handler_code(state, ErrorHandler::ERR_NULL))
+			);
 		}
 	}
 
@@ -1971,12 +3799,13 @@ BytecodeToC::SystemCallEmitResult BytecodeToC::emit_direct_system_call_native(
 			break;
 		}
 		case AbiMask::GENERIC:
-		default:
-			return {.ok = false, .fail_reason = "baseOffset (from multiple inheritance) is not supported on this ABI."};
+		default:               angelsea_assert(false && "rejected before emitting"); break;
 		}
 	}
 
-	if (!m_config->hack_ignore_context_inspect) {
+	if (can_skip_system_call_state_sync(call.traits)) {
+		// the callee can neither observe the registers nor cause a nested script call
+	} else if (!m_config->hack_ignore_context_inspect) {
 		emit_save_sp(state);
 		emit_save_pc(state, true);
 	} else {
@@ -1987,13 +3816,18 @@ BytecodeToC::SystemCallEmitResult BytecodeToC::emit_direct_system_call_native(
 
 	std::string final_callable_name;
 
-	std::vector<std::string> formatted_arg_types(args.size());
+	std::vector<std::string> formatted_arg_types(variadic_arg_begin);
 	for (std::size_t i = 0; i < formatted_arg_types.size(); ++i) {
 		formatted_arg_types[i] = args[i].first.c;
 	}
+	if (variadic_count.has_value()) {
+		formatted_arg_types.emplace_back("...");
+	}
 
-	if (sys_fn.callConv == ICC_VIRTUAL_THISCALL || sys_fn.callConv == ICC_VIRTUAL_THISCALL_OBJFIRST
-	    || sys_fn.callConv == ICC_VIRTUAL_THISCALL_OBJLAST) {
+	if (call.intrinsic != nullptr) {
+		emit_intrinsic_definitions(call.fn_idx, *call.intrinsic);
+	} else if (sys_fn.callConv == ICC_VIRTUAL_THISCALL || sys_fn.callConv == ICC_VIRTUAL_THISCALL_OBJFIRST
+	           || sys_fn.callConv == ICC_VIRTUAL_THISCALL_OBJLAST) {
 		// dereference pointer via the vtable. this is janky! we are in C, so we essentially have to emulate the C++
 		// ABI here. TODO: option to disable virtual calls specifically?
 
@@ -2045,15 +3879,41 @@ BytecodeToC::SystemCallEmitResult BytecodeToC::emit_direct_system_call_native(
 
 	// perform the actual call. the expression to perform the call is always the same but the surrounding call to
 	// figure out where to store the return value differs.
-	std::string call_expression = fmt::format("{FN}(", fmt::arg("FN", final_callable_name));
-	for (auto it = args.begin(); it != args.end(); ++it) {
-		const auto& expr = it->second;
-		call_expression += fmt::format("\n\t\t\t{}", expr);
-		if (std::next(it) != args.end()) {
-			call_expression += ',';
+	std::string call_expression;
+	if (call.intrinsic != nullptr) {
+		call_expression = std::move(intrinsic_expression);
+	} else if (is_guarded) {
+		// caught exceptions are raised on the context, which emit_system_call_status_check then handles
+		if (!args.empty()) {
+			emit("\t\tasQWORD guarded_args[{}];\n", args.size());
+		}
+		for (std::size_t i = 0; i < args.size(); ++i) {
+			emit(
+			    "\t\tguarded_args[{IDX}] = (asQWORD){CAST}({EXPR});\n",
+			    fmt::arg("IDX", i),
+			    fmt::arg("CAST", args[i].first == var_types::void_ptr ? "(asPWORD)" : ""),
+			    fmt::arg("EXPR", args[i].second)
+			);
+		}
+		call_expression = fmt::format(
+		    "{CAST}{GUARD}(_regs, (void*){FN}, {ARGS}, {ARG_COUNT})",
+		    fmt::arg("CAST", guarded_return_cast),
+		    fmt::arg("GUARD", guarded_call_fn),
+		    fmt::arg("FN", final_callable_name),
+		    fmt::arg("ARGS", args.empty() ? "0" : "guarded_args"),
+		    fmt::arg("ARG_COUNT", args.size())
+		);
+	} else {
+		call_expression = fmt::format("{FN}(", fmt::arg("FN", final_callable_name));
+		for (auto it = args.begin(); it != args.end(); ++it) {
+			const auto& expr = it->second;
+			call_expression += fmt::format("\n\t\t\t{}", expr);
+			if (std::next(it) != args.end()) {
+				call_expression += ',';
+			}
 		}
+		call_expression += ')';
 	}
-	call_expression += ')';
 
 	if (!return_target_override.empty()) {
 		emit(
@@ -2064,8 +3924,9 @@ BytecodeToC::SystemCallEmitResult BytecodeToC::emit_direct_system_call_native(
 	} else if (fn.returnType.IsObjectHandle() && !fn.returnType.IsReference()) {
 		// FIXME: set objectType
 		emit("\t\tregs->obj = {};\n", call_expression);
-		// TODO: auto handles
-		angelsea_assert(!sys_fn.returnAutoHandle);
+		if (return_auto_handle_addref != 0) {
+			emit_auto_handle_call(state, "regs->obj", return_auto_handle_addref);
+		}
 	} else if ((fn.returnType.IsObject() || fn.returnType.IsFuncdef()) && !fn.returnType.IsReference()) {
 		if (return_type.c == "void*") {
 			emit("\t\tvalue_reg = (asPWORD){};\n", call_expression);
@@ -2096,6 +3957,12 @@ BytecodeToC::SystemCallEmitResult BytecodeToC::emit_direct_system_call_native(
 
 	emit("{}", to_emit_after_call);
 
+	for (std::size_t i = 0; i < param_auto_handle_releases.size(); ++i) {
+		if (param_auto_handle_releases[i] != 0) {
+			emit_auto_handle_call(state, args[param_arg_ids[i]].second, param_auto_handle_releases[i]);
+		}
+	}
+
 	// TODO: move this out and reuse for generic convention. also suspiciously similar to asBC_FREE in shape, any
 	// reuse possible?
 	if (sys_fn.cleanArgs.GetLength() > 0) {
@@ -2108,7 +3975,7 @@ BytecodeToC::SystemCallEmitResult BytecodeToC::emit_direct_system_call_native(
 			clean_base_offset += AS_PTR_SIZE;
 		}
 
-		if (sys_fn.callConv >= ICC_THISCALL && sys_fn.auxiliary == nullptr) {
+		if (takes_obj_from_stack) {
 			clean_base_offset += AS_PTR_SIZE;
 		}
 
@@ -2177,19 +4044,39 @@ BytecodeToC::SystemCallEmitResult BytecodeToC::emit_direct_system_call_generic(
 
 	const internalCallConv icc = sys_fn.callConv;
 
-	if (!call.is_internal_call) {
-		if (fn.IsVariadic()) {
-			// TODO: variadics are a bit annoying to support; certainly viable but they're so rare that other than
-			// full AOT i don't see the point to support them
-			return {.ok = false, .fail_reason = "Direct generic call failed: Variadics not supported yet"};
+	// the callee reads the variadic arguments from the stack by itself, but we have to pop them
+	int pop_size = sys_fn.paramSize;
+	if (!call.is_internal_call && fn.IsVariadic()) {
+		const bool        takes_obj_from_stack = icc == ICC_GENERIC_METHOD && call.object_pointer_override.empty();
+		const std::size_t hidden_pushes
+		    = std::size_t(takes_obj_from_stack) + std::size_t(fn.DoesReturnOnStack());
+
+		const std::optional<asUINT> variadic_count = get_variadic_argument_count(state, fn, hidden_pushes);
+		if (!variadic_count.has_value()) {
+			return {.ok = false, .fail_reason = "Direct generic call failed: Unknown variadic argument count"};
+		}
+
+		const asUINT fixed_param_count = fn.parameterTypes.GetLength() - 1;
+		pop_size                       = 1; // the count
+		for (asUINT i = 0; i < fixed_param_count; ++i) {
+			pop_size += get_system_argument_dwords(fn.parameterTypes[i]);
 		}
+		pop_size += int(*variadic_count) * get_system_argument_dwords(fn.parameterTypes[fixed_param_count]);
+	}
 
-		if (sys_fn.returnAutoHandle && m_script_engine->ep.genericCallMode == 1) {
-			return {.ok = false, .fail_reason = "Direct generic call failed: Auto handles not supported yet"};
+	// auto handle parameters are released through cleanArgs, but returns need a reference to be added, unless the
+	// engine uses the old generic call mode that ignores auto handles
+	int return_auto_handle_addref = 0;
+	if (!call.is_internal_call && sys_fn.returnAutoHandle && m_script_engine->ep.genericCallMode == 1) {
+		return_auto_handle_addref = get_auto_handle_behaviour(fn.returnType, true);
+		if (return_auto_handle_addref == 0) {
+			return {.ok = false, .fail_reason = "Direct generic call failed: No addref behaviour for auto handle"};
 		}
 	}
 
-	if (!m_config->hack_ignore_context_inspect) {
+	if (can_skip_system_call_state_sync(call.traits)) {
+		// the callee can neither observe the registers nor cause a nested script call
+	} else if (!m_config->hack_ignore_context_inspect) {
 		emit_save_sp(state);
 		emit_save_pc(state, true);
 	} else {
@@ -2204,7 +4091,7 @@ BytecodeToC::SystemCallEmitResult BytecodeToC::emit_direct_system_call_generic(
 	emit(
 	    "\t\tasDWORD* args = &sp->as_asDWORD;\n"
 	    "\t\tint pop_size = {INIT_POP_SIZE};\n",
-	    fmt::arg("INIT_POP_SIZE", sys_fn.paramSize)
+	    fmt::arg("INIT_POP_SIZE", pop_size)
 	);
 
 	// TODO: check which of those could skip initialization if there are cases where the asCGeneric methods will
@@ -2229,6 +4116,12 @@ BytecodeToC::SystemCallEmitResult BytecodeToC::emit_direct_system_call_generic(
 		}
 	}
 
+	// only initialize the members of `g` that the callee or the code after the call may read. the stack pointer is
+	// only used to read arguments and the return location, and each return register is only read for its return type
+	const bool uses_object_register
+	    = (fn.returnType.IsObject() || fn.returnType.IsFuncdef()) && !fn.returnType.IsReference();
+	const bool uses_value_register = !uses_object_register && fn.returnType.GetTokenType() != ttVoid;
+
 	if (!call.is_internal_call) {
 		if (fn.DoesReturnOnStack()) {
 			emit(
@@ -2236,7 +4129,9 @@ BytecodeToC::SystemCallEmitResult BytecodeToC::emit_direct_system_call_generic(
 			    "\t\targs += sizeof(asPWORD) / 4;\n"
 			);
 		}
-		emit("\t\tg.stackPointer = args;\n"); // TODO: don't write if the stack never needs to be accessed
+		if (fn.parameterTypes.GetLength() > 0 || fn.DoesReturnOnStack()) {
+			emit("\t\tg.stackPointer = args;\n");
+		}
 	}
 
 	emit(
@@ -2247,22 +4142,25 @@ BytecodeToC::SystemCallEmitResult BytecodeToC::emit_direct_system_call_generic(
 	    fmt::arg("FNCALLABLE", fn_callable_symbol)
 	);
 
-	if (!m_config->hack_generic_assume_callee_correctness) {
-		emit(
-		    "\t\tg.objectRegister = 0;\n"
-		    "\t\tg.returnVal = 0;\n"
-		);
+	if (!m_config->hack_generic_assume_callee_correctness && !call.is_internal_call) {
+		if (uses_object_register) {
+			emit("\t\tg.objectRegister = 0;\n");
+		} else if (uses_value_register) {
+			emit("\t\tg.returnVal = 0;\n");
+		}
 	}
 
-	emit("\t\t{FNCALLABLE}(&g);\n", fmt::arg("FNCALLABLE", fn_callable_symbol));
+	if (m_config->hack_ignore_exceptions || call.traits.nothrow) {
+		emit("\t\t{FNCALLABLE}(&g);\n", fmt::arg("FNCALLABLE", fn_callable_symbol));
+	} else {
+		// caught exceptions are raised on the context, which emit_system_call_status_check then handles
+		emit("\t\tasea_call_generic_guarded(_regs, {FNCALLABLE}, &g);\n", fmt::arg("FNCALLABLE", fn_callable_symbol));
+	}
 
 	if (!call.is_internal_call) {
 		// TODO: we can probably statically tell which regs need to be written to and which don't
 		emit("\t\tsp = (asea_var*)((asDWORD*)sp + pop_size);\n");
 
-		bool uses_object_register
-		    = (fn.returnType.IsObject() || fn.returnType.IsFuncdef()) && !fn.returnType.IsReference();
-
 		if (uses_object_register) {
 			asITypeInfo* ret_type_info = fn.returnType.GetTypeInfo();
 			angelsea_assert(ret_type_info != nullptr);
@@ -2273,7 +4171,12 @@ BytecodeToC::SystemCallEmitResult BytecodeToC::emit_direct_system_call_generic(
 			    "\t\tregs->obj_type = (asITypeInfo*){RETTYPEINFO};\n",
 			    fmt::arg("RETTYPEINFO", ret_type_info_expr)
 			);
-		} else {
+
+			// must happen before cleaning the arguments, which may hold the last other reference to the object
+			if (return_auto_handle_addref != 0) {
+				emit_auto_handle_call(state, "regs->obj", return_auto_handle_addref);
+			}
+		} else if (uses_value_register) {
 			emit("\t\tvalue_reg = g.returnVal;\n");
 		}
 
@@ -2287,12 +4190,42 @@ BytecodeToC::SystemCallEmitResult BytecodeToC::emit_direct_system_call_generic(
 	return {.ok = true, .fail_reason = {}};
 }
 
+int BytecodeToC::get_auto_handle_behaviour(const asCDataType& type, bool is_addref) {
+	if (!type.IsObjectHandle() || type.IsFuncdef() || type.GetTypeInfo() == nullptr) {
+		return 0;
+	}
+
+	const asCObjectType* obj_type = CastToObjectType(type.GetTypeInfo());
+	if (obj_type == nullptr) {
+		return 0;
+	}
+
+	return is_addref ? obj_type->beh.addref : obj_type->beh.release;
+}
+
+void BytecodeToC::emit_auto_handle_call(FnState& state, std::string_view handle_expr, int behaviour_fn_idx) {
+	emit(
+	    "\t\t{{\n"
+	    "\t\tvoid* auto_handle = {};\n"
+	    "\t\tif (auto_handle) {{\n",
+	    handle_expr
+	);
+	emit_system_call(
+	    state,
+	    {.fn_idx = behaviour_fn_idx, .object_pointer_override = "auto_handle", .is_internal_call = true}
+	);
+	emit(
+	    "\t\t}}\n"
+	    "\t\t}}\n"
+	);
+}
+
 void BytecodeToC::emit_stack_push_ins(FnState& state, const bcins::StackPush& push) {
 	const VarType type = make_local_from_operand(state, "v", push.value);
 	if (state.stack_push_infos.contains(state.ins.offset)) {
 		emit("\t\tpush_tmp{ID} = v;\n", fmt::arg("ID", state.ins.offset));
 	} else {
-		emit_stack_push(state, "v", type);
+		emit_virtual_stack_push(state, "v", type);
 	}
 }
 
@@ -2331,6 +4264,35 @@ void BytecodeToC::emit_stack_push(FnState& state, std::string_view expr, VarType
 	emit("\t\tsp->as_{TYPE} = {EXPR};\n", fmt::arg("TYPE", type.var_accessor), fmt::arg("EXPR", expr));
 }
 
+void BytecodeToC::emit_virtual_stack_push(FnState& state, std::string_view expr, VarType type) {
+	if (type == var_types::pword || type == var_types::void_ptr) {
+		++state.pending_push_pwords;
+	} else {
+		angelsea_assert(type.size % 4 == 0);
+		state.pending_push_dwords += int(type.size / 4);
+	}
+
+	emit(
+	    "\t\t((asea_var*)((asDWORD*)sp - {OFFSET}))->as_{TYPE} = {EXPR};\n",
+	    fmt::arg("OFFSET", pending_push_offset(state.pending_push_dwords, state.pending_push_pwords)),
+	    fmt::arg("TYPE", type.var_accessor),
+	    fmt::arg("EXPR", expr)
+	);
+}
+
+void BytecodeToC::emit_flush_virtual_stack(FnState& state) {
+	if (state.pending_push_dwords == 0 && state.pending_push_pwords == 0) {
+		return;
+	}
+
+	emit(
+	    "\tsp = (asea_var*)((asDWORD*)sp - {OFFSET});\n",
+	    fmt::arg("OFFSET", pending_push_offset(state.pending_push_dwords, state.pending_push_pwords))
+	);
+	state.pending_push_dwords = 0;
+	state.pending_push_pwords = 0;
+}
+
 void BytecodeToC::emit_cond_branch(FnState& state, std::string_view expr, std::size_t target_offset) {
 	if (m_config->c.use_builtin_expect) {
 		emit(
@@ -2342,8 +4304,9 @@ void BytecodeToC::emit_cond_branch(FnState& state, std::string_view expr, std::s
 		emit("\t\tif ({TEST}) {{\n", fmt::arg("TEST", expr));
 	}
 	emit(
-	    "\t\t\tgoto bc{BRANCH_TARGET};\n"
+	    "\t\t\tgoto {PREFIX}{BRANCH_TARGET};\n"
 	    "\t\t}}\n",
+	    fmt::arg("PREFIX", state.label_prefix),
 	    fmt::arg("BRANCH_TARGET", target_offset)
 	);
 }
@@ -2455,11 +4418,29 @@ void BytecodeToC::emit_divmod_var_unsigned_ins(FnState& state, std::string_view
 	);
 }
 
+void BytecodeToC::emit_pow_var_ins(FnState& state) {
+	InsRef&       ins = state.ins;
+	const PowInfo pow = get_pow_info(ins.opcode());
+	emit(
+	    "\t\tint overflow;\n"
+	    "\t\t{DST} = {FN}({LHS}, {RHS}, &overflow);\n"
+	    "\t\tif (overflow) {{ {ERR_POW_OVERFLOW_HANDLER} }}\n",
+	    fmt::arg("ERR_POW_OVERFLOW_HANDLER", jump_to_error_handler_code(state, ErrorHandler::ERR_POW_OVERFLOW)),
+	    fmt::arg("FN", pow.runtime_function),
+	    fmt::arg("DST", frame_var(ins.sword0(), pow.type)),
+	    fmt::arg("LHS", frame_var(ins.sword1(), pow.type)),
+	    fmt::arg("RHS", frame_var(ins.sword2(), pow.exponent_type))
+	);
+}
+
 std::string BytecodeToC::frame_ptr(std::string_view expr) {
 	return fmt::format("((asea_var*)((asDWORD*)fp - {}))", expr);
 }
 
 std::string BytecodeToC::frame_ptr(int offset) {
+	angelsea_assert(
+	    !m_module_state.promoted_variables.contains(offset) && "promoted variables must never have their address taken"
+	);
 	if (offset == 0) {
 		return "fp";
 	}
@@ -2471,12 +4452,59 @@ std::string BytecodeToC::frame_var(std::string_view expr, VarType type) {
 }
 
 std::string BytecodeToC::frame_var(int offset, VarType type) {
+	if (const auto it = m_module_state.promoted_variables.find(offset);
+	    it != m_module_state.promoted_variables.end()) {
+		// integral types of a different signedness are fine, as C conversions between them preserve the bits
+		angelsea_assert(
+		    it->second.size == type.size && is_floating_point(it->second) == is_floating_point(type)
+		    && "promoted variable accessed with an incompatible type"
+		);
+		return promoted_variable_name(offset);
+	}
 	if (offset == 0) {
 		return fmt::format("fp->as_{}", type.c);
 	}
 	return frame_var(std::to_string(offset), type);
 }
 
+std::string BytecodeToC::frame_var_bits([[maybe_unused]] FnState& state, int offset, VarType type) {
+	const auto it = m_module_state.promoted_variables.find(offset);
+	if (it == m_module_state.promoted_variables.end() || is_floating_point(it->second) == is_floating_point(type)) {
+		return frame_var(offset, type);
+	}
+
+	// a cast would convert the value, so reinterpret it through a union instead
+	const std::string name = promoted_variable_name(offset);
+	emit(
+	    "\t\t{UNION} {NAME}_rbits;\n"
+	    "\t\t{NAME}_rbits.{MEMBER} = {NAME};\n",
+	    fmt::arg("UNION", type.size == 8 ? "asea_i2f64" : "asea_i2f"),
+	    fmt::arg("NAME", name),
+	    fmt::arg("MEMBER", is_floating_point(it->second) ? "f" : "i")
+	);
+	return fmt::format("{}_rbits.{}", name, is_floating_point(type) ? "f" : "i");
+}
+
+void BytecodeToC::emit_frame_var_bits_store(FnState& state, int offset, VarType type, std::string_view expr) {
+	const auto it = m_module_state.promoted_variables.find(offset);
+	if (it == m_module_state.promoted_variables.end() || is_floating_point(it->second) == is_floating_point(type)) {
+		emit_assign_ins(state, frame_var(offset, type), expr);
+		return;
+	}
+
+	const std::string name = promoted_variable_name(offset);
+	emit(
+	    "\t\t{UNION} {NAME}_wbits;\n"
+	    "\t\t{NAME}_wbits.{SRC_MEMBER} = {EXPR};\n"
+	    "\t\t{NAME} = {NAME}_wbits.{DST_MEMBER};\n",
+	    fmt::arg("UNION", type.size == 8 ? "asea_i2f64" : "asea_i2f"),
+	    fmt::arg("NAME", name),
+	    fmt::arg("EXPR", expr),
+	    fmt::arg("SRC_MEMBER", is_floating_point(type) ? "f" : "i"),
+	    fmt::arg("DST_MEMBER", is_floating_point(it->second) ? "f" : "i")
+	);
+}
+
 std::string BytecodeToC::stack_var(int offset, VarType type) {
 	return fmt::format("((asea_var*)((asDWORD*)sp + {}))->as_{}", fmt::to_string(offset), type.c);
 }
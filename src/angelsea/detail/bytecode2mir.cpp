@@ -0,0 +1,630 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+#include <angelsea/detail/bytecode2mir.hpp>
+#include <angelsea/detail/bytecodeinstruction.hpp>
+#include <angelsea/detail/bytecodetools.hpp>
+#include <angelsea/detail/debug.hpp>
+#include <angelsea/detail/frameanalysis.hpp>
+#include <angelsea/detail/runtime.hpp>
+#include <angelsea/detail/util.hpp>
+#include <algorithm>
+#include <as_scriptfunction.h>
+#include <cstddef>
+#include <cstdint>
+#include <fmt/format.h>
+#include <map>
+#include <unordered_map>
+#include <variant>
+
+namespace angelsea::detail {
+
+namespace {
+
+MIR_type_t mir_memory_type(VarType type) {
+	using namespace var_types;
+
+	if (type == s32) {
+		return MIR_T_I32;
+	}
+	if (type == u32) {
+		return MIR_T_U32;
+	}
+	if (type == s64 || type == u64) {
+		return MIR_T_I64;
+	}
+	if (type == f32) {
+		return MIR_T_F;
+	}
+	if (type == f64) {
+		return MIR_T_D;
+	}
+
+	angelsea_assert(false && "unsupported type for the MIR backend");
+	return MIR_T_UNDEF;
+}
+
+/// Frame variable held in a register rather than in the stack frame, see find_promotable_variables.
+struct PromotedVariable {
+	VarType type;
+
+	/// Register holding the variable. 32-bit integers are held in 64-bit registers, where only the low 32 bits are
+	/// meaningful.
+	MIR_reg_t reg;
+};
+
+/// State of the translation of a single function. Registers are named after their equivalent in the generated C of
+/// BytecodeToC, where there is one.
+struct FunctionTranslation {
+	MIR_context_t ctx;
+	MIR_item_t    func;
+
+	MIR_reg_t regs, entry_label, fp, value_reg, shadow;
+
+	/// Temporaries, which never hold a value across instructions.
+	MIR_reg_t i0, i1, i2, i3, f0, f1, d0, d1;
+
+	/// Label of every instruction, by bytecode offset.
+	std::unordered_map<std::size_t, MIR_label_t> labels;
+
+	/// Promoted variables, by stack frame offset. The stack frame is never observed while the translated code runs, so
+	/// they only need to be loaded on entry, and the stack frame is dead once we return.
+	std::map<int, PromotedVariable> promoted;
+
+	void append(MIR_insn_t insn) const { MIR_append_insn(ctx, func, insn); }
+
+	template<class... Ops> void insn(MIR_insn_code_t code, Ops... ops) const {
+		append(MIR_new_insn(ctx, code, ops...));
+	}
+
+	MIR_op_t reg(MIR_reg_t r) const { return MIR_new_reg_op(ctx, r); }
+	MIR_op_t imm(std::int64_t v) const { return MIR_new_int_op(ctx, v); }
+	MIR_op_t label(std::size_t offset) const { return MIR_new_label_op(ctx, labels.at(offset)); }
+
+	/// Memory operand for the frame variable at `offset`, equivalent to BytecodeToC::frame_var.
+	MIR_op_t frame_var(int offset, VarType type) const {
+		return MIR_new_mem_op(ctx, mir_memory_type(type), -MIR_disp_t(offset) * MIR_disp_t(sizeof(asDWORD)), fp, 0, 1);
+	}
+
+	/// Memory operand for a field of the VM registers.
+	MIR_op_t vm_register(std::size_t field_offset, MIR_type_t type) const {
+		return MIR_new_mem_op(ctx, type, MIR_disp_t(field_offset), regs, 0, 1);
+	}
+
+	/// Memory operand for a field of the script context held in `context`.
+	MIR_op_t context_field(MIR_reg_t context, asPWORD field_offset, MIR_type_t type) const {
+		return MIR_new_mem_op(ctx, type, MIR_disp_t(field_offset), context, 0, 1);
+	}
+
+	/// Memory operand for the element `field` of a call stack frame located at `disp` bytes from `base`, plus `index`
+	/// pointer-sized elements if `index` is non-zero.
+	MIR_op_t call_state(MIR_reg_t base, MIR_reg_t index, MIR_disp_t disp, int field) const {
+		const auto pword_size = MIR_disp_t(sizeof(asPWORD));
+		return MIR_new_mem_op(ctx, MIR_T_I64, disp + (field * pword_size), base, index, index != 0 ? pword_size : 1);
+	}
+
+	/// Temporary register that can hold a value of `type`, numbered `idx` (0 or 1).
+	MIR_reg_t temporary(VarType type, int idx) const {
+		if (type == var_types::f32) {
+			return idx == 0 ? f0 : f1;
+		}
+		if (type == var_types::f64) {
+			return idx == 0 ? d0 : d1;
+		}
+		return idx == 0 ? i0 : i1;
+	}
+
+	/// Move instruction suitable for values of `type`.
+	static MIR_insn_code_t mov(VarType type) {
+		if (type == var_types::f32) {
+			return MIR_FMOV;
+		}
+		if (type == var_types::f64) {
+			return MIR_DMOV;
+		}
+		return MIR_MOV;
+	}
+
+	/// Loads the frame variable at `offset` as a `type` into the temporary numbered `idx`. 32-bit integers are sign or
+	/// zero-extended to 64-bit depending on the signedness of `type`.
+	MIR_op_t load(int offset, VarType type, int idx) const {
+		const MIR_reg_t r  = temporary(type, idx);
+		const auto      it = promoted.find(offset);
+
+		if (it == promoted.end()) {
+			insn(mov(type), reg(r), frame_var(offset, type));
+		} else if (is_floating_point(it->second.type) != is_floating_point(type)) {
+			// only the bits are reinterpreted, so go through the stack frame, which nothing else reads
+			insn(mov(it->second.type), frame_var(offset, it->second.type), reg(it->second.reg));
+			insn(mov(type), reg(r), frame_var(offset, type));
+		} else if (type == var_types::s32 || type == var_types::u32) {
+			insn(type == var_types::s32 ? MIR_EXT32 : MIR_UEXT32, reg(r), reg(it->second.reg));
+		} else {
+			insn(mov(type), reg(r), reg(it->second.reg));
+		}
+
+		return reg(r);
+	}
+
+	/// Stores `value`, a `type`, to the frame variable at `offset`.
+	void store(int offset, VarType type, MIR_op_t value) const {
+		const auto it = promoted.find(offset);
+
+		if (it == promoted.end()) {
+			insn(mov(type), frame_var(offset, type), value);
+		} else if (is_floating_point(it->second.type) != is_floating_point(type)) {
+			insn(mov(type), frame_var(offset, type), value);
+			insn(mov(it->second.type), reg(it->second.reg), frame_var(offset, it->second.type));
+		} else {
+			insn(mov(type), reg(it->second.reg), value);
+		}
+	}
+
+	MIR_op_t load_operand(const auto& operand, VarType type, int idx) const {
+		using namespace operands;
+
+		const MIR_reg_t r = temporary(type, idx);
+		std::visit(
+		    overloaded{
+		        [&](const FrameVariable& var) { load(var.idx, type, idx); },
+		        [&](const Immediate<float>& v) { insn(MIR_FMOV, reg(r), MIR_new_float_op(ctx, v.value)); },
+		        [&](const auto& v) {
+			        if constexpr (requires { v.value; }) {
+				        insn(MIR_MOV, reg(r), imm(std::int64_t(v.value)));
+			        } else {
+				        angelsea_assert(false && "unsupported operand for the MIR backend");
+			        }
+		        }
+		    },
+		    operand
+		);
+		return reg(r);
+	}
+
+	void binop_var_var(MIR_insn_code_t code, InsRef ins, VarType type) const {
+		const MIR_op_t lhs = load(ins.sword1(), type, 0);
+		const MIR_op_t rhs = load(ins.sword2(), type, 1);
+		insn(code, lhs, lhs, rhs);
+		store(ins.sword0(), type, lhs);
+	}
+
+	void binop_var_imm(MIR_insn_code_t code, InsRef ins, VarType type, MIR_op_t rhs) const {
+		const MIR_op_t lhs = load(ins.sword1(), type, 0);
+		insn(code, lhs, lhs, rhs);
+		store(ins.sword0(), type, lhs);
+	}
+
+	void unop_var_inplace(MIR_insn_code_t code, InsRef ins, VarType type) const {
+		const MIR_op_t var = load(ins.sword0(), type, 0);
+		insn(code, var, var);
+		store(ins.sword0(), type, var);
+	}
+
+	/// Equivalent to `value_reg = (lhs > rhs) - (lhs < rhs)`, see BytecodeToC::emit_compare.
+	void compare(const bcins::Compare& cmp) const {
+		using namespace var_types;
+
+		const VarType  type = cmp.lhs.type;
+		const MIR_op_t lhs  = load(cmp.lhs.idx, type, 0);
+		const MIR_op_t rhs  = load_operand(cmp.rhs, type, 1);
+
+		MIR_insn_code_t gt = MIR_GT, lt = MIR_LT;
+		if (type == u64) {
+			gt = MIR_UGT, lt = MIR_ULT;
+		} else if (type == f32) {
+			gt = MIR_FGT, lt = MIR_FLT;
+		} else if (type == f64) {
+			gt = MIR_DGT, lt = MIR_DLT;
+		}
+
+		// 32-bit operands were sign or zero-extended to 64-bit by the load, so 64-bit comparisons are correct
+		insn(gt, reg(i2), lhs, rhs);
+		insn(lt, reg(value_reg), lhs, rhs);
+		insn(MIR_SUB, reg(value_reg), reg(i2), reg(value_reg));
+	}
+
+	/// Restores the state of the caller from the call stack frame designated as in \ref call_state, popping `pop`
+	/// dwords of arguments, then returns from the function. `context` must hold the script context.
+	void return_to_caller(MIR_reg_t context, MIR_reg_t base, MIR_reg_t index, MIR_disp_t disp, int pop) const {
+		insn(MIR_MOV, reg(i3), call_state(base, index, disp, 0));
+		insn(MIR_MOV, vm_register(offsetof(asSVMRegisters, stackFramePointer), MIR_T_P), reg(i3));
+		insn(MIR_MOV, reg(i3), call_state(base, index, disp, 1));
+		insn(MIR_MOV, context_field(context, asea_offset_ctx_currentfn, MIR_T_P), reg(i3));
+		insn(MIR_MOV, reg(i3), call_state(base, index, disp, 2));
+		insn(MIR_MOV, vm_register(offsetof(asSVMRegisters, programPointer), MIR_T_P), reg(i3));
+		insn(MIR_MOV, reg(i3), call_state(base, index, disp, 3));
+		insn(MIR_ADD, reg(i3), reg(i3), imm(std::int64_t(pop) * std::int64_t(sizeof(asDWORD))));
+		insn(MIR_MOV, vm_register(offsetof(asSVMRegisters, stackPointer), MIR_T_P), reg(i3));
+		insn(MIR_MOV, reg(i3), call_state(base, index, disp, 4));
+		insn(MIR_MOV, context_field(context, asea_offset_ctx_stackindex, MIR_T_U32), reg(i3));
+		append(MIR_new_ret_insn(ctx, 0));
+	}
+
+	/// Equivalent to `value_reg = ((asINT32)value_reg {op} 0) ? 1 : 0`, see BytecodeToC::emit_test_ins.
+	void test(MIR_insn_code_t code) const {
+		insn(MIR_EXT32, reg(i0), reg(value_reg));
+		insn(code, reg(value_reg), reg(i0), imm(0));
+	}
+};
+
+/// Returns to the caller without going through the VM, which is equivalent to the asBC_RET translation of BytecodeToC.
+void translate_script_return(const FunctionTranslation& t, int pop, bool uses_shadow_call_stack) {
+	t.insn(MIR_MOV, t.reg(t.i0), t.vm_register(offsetof(asSVMRegisters, ctx), MIR_T_P));
+
+	if (uses_shadow_call_stack) {
+		// we were called by JIT code that did not push its state to the call stack
+		MIR_label_t no_shadow = MIR_new_label(t.ctx);
+		t.insn(MIR_BEQ, MIR_new_label_op(t.ctx, no_shadow), t.reg(t.shadow), t.imm(0));
+		t.insn(
+		    MIR_MOV,
+		    t.reg(t.i3),
+		    MIR_new_mem_op(t.ctx, MIR_T_I64, offsetof(asea_shadow_frame, materialized), t.shadow, 0, 1)
+		);
+		t.insn(MIR_BNE, MIR_new_label_op(t.ctx, no_shadow), t.reg(t.i3), t.imm(0));
+		t.return_to_caller(t.i0, t.shadow, 0, offsetof(asea_shadow_frame, state), pop);
+		t.append(no_shadow);
+	}
+
+	// the call stack is an asCArray, which starts with its data pointer followed by its length
+	const auto callstack_ptr = MIR_disp_t(asea_offset_ctx_callstack);
+	const auto callstack_len = MIR_disp_t(asea_offset_ctx_callstack + sizeof(void*));
+
+	// returning from the function the VM was entered with finishes the execution
+	MIR_label_t finished = MIR_new_label(t.ctx);
+	t.insn(MIR_MOV, t.reg(t.i1), MIR_new_mem_op(t.ctx, MIR_T_U32, callstack_len, t.i0, 0, 1));
+	t.insn(MIR_BEQ, MIR_new_label_op(t.ctx, finished), t.reg(t.i1), t.imm(0));
+	t.insn(MIR_SUB, t.reg(t.i1), t.reg(t.i1), t.imm(CALLSTACK_FRAME_SIZE));
+	t.insn(MIR_MOV, t.reg(t.i2), MIR_new_mem_op(t.ctx, MIR_T_P, callstack_ptr, t.i0, 0, 1));
+	t.insn(MIR_MOV, t.reg(t.i3), t.call_state(t.i2, t.i1, 0, 0));
+	t.insn(MIR_BEQ, MIR_new_label_op(t.ctx, finished), t.reg(t.i3), t.imm(0));
+	t.insn(MIR_MOV, MIR_new_mem_op(t.ctx, MIR_T_U32, callstack_len, t.i0, 0, 1), t.reg(t.i1));
+	t.return_to_caller(t.i0, t.i2, t.i1, 0, pop);
+
+	t.append(finished);
+	t.insn(MIR_MOV, t.context_field(t.i0, asea_offset_ctx_status, MIR_T_I32), t.imm(asEXECUTION_FINISHED));
+	t.append(MIR_new_ret_insn(t.ctx, 0));
+}
+
+} // namespace
+
+BytecodeToMir::BytecodeToMir(const JitConfig& config) : m_config(&config) {}
+
+bool BytecodeToMir::can_translate(asIScriptFunction& fn) const {
+	if (fn.GetFuncType() != asFUNC_SCRIPT) {
+		return false;
+	}
+
+	for (InsRef ins : get_bytecode(fn)) {
+		if (auto cmp = bcins::try_as<bcins::Compare>(ins); cmp.has_value()) {
+			if (ins.opcode() == asBC_CmpPtr) {
+				return false;
+			}
+			continue;
+		}
+
+		switch (ins.opcode()) {
+		case asBC_JitEntry:
+		case asBC_RET:
+		case asBC_SetV1:
+		case asBC_SetV2:
+		case asBC_SetV4:
+		case asBC_SetV8:
+		case asBC_CpyVtoV4:
+		case asBC_CpyVtoV8:
+		case asBC_CpyVtoR4:
+		case asBC_CpyVtoR8:
+		case asBC_CpyRtoV4:
+		case asBC_CpyRtoV8:
+		case asBC_IncVi:
+		case asBC_DecVi:
+		case asBC_NEGi:
+		case asBC_NEGi64:
+		case asBC_NEGf:
+		case asBC_NEGd:
+		case asBC_ADDi:
+		case asBC_SUBi:
+		case asBC_MULi:
+		case asBC_ADDi64:
+		case asBC_SUBi64:
+		case asBC_MULi64:
+		case asBC_ADDf:
+		case asBC_SUBf:
+		case asBC_MULf:
+		case asBC_ADDd:
+		case asBC_SUBd:
+		case asBC_MULd:
+		case asBC_BAND:
+		case asBC_BOR:
+		case asBC_BXOR:
+		case asBC_BAND64:
+		case asBC_BOR64:
+		case asBC_BXOR64:
+		case asBC_ADDIi:
+		case asBC_SUBIi:
+		case asBC_MULIi:
+		case asBC_ADDIf:
+		case asBC_SUBIf:
+		case asBC_MULIf:
+		case asBC_TZ:
+		case asBC_TNZ:
+		case asBC_TS:
+		case asBC_TNS:
+		case asBC_TP:
+		case asBC_TNP:
+		case asBC_JMP:
+		case asBC_JZ:
+		case asBC_JNZ:
+		case asBC_JLowZ:
+		case asBC_JLowNZ:
+		case asBC_JS:
+		case asBC_JNS:
+		case asBC_JP:
+		case asBC_JNP:      break;
+		case asBC_SUSPEND:
+			if (!m_config->hack_ignore_suspend) {
+				return false;
+			}
+			break;
+		default: return false;
+		}
+	}
+
+	return true;
+}
+
+void BytecodeToMir::configure_jit_entries(asIScriptFunction& fn) const {
+	// the translated code is cheap to enter anywhere, so keep every entry point
+	asPWORD jit_entry_id = 1;
+	for (InsRef ins : get_bytecode(fn)) {
+		if (ins.opcode() == asBC_JitEntry) {
+			ins.pword0() = jit_entry_id;
+			++jit_entry_id;
+		}
+	}
+}
+
+std::string BytecodeToMir::translate_function(MIR_context_t ctx, asIScriptFunction& fn, bool uses_shadow_call_stack) {
+	using namespace var_types;
+
+	const std::string name = fmt::format("asea_mir_fn{}", m_function_idx);
+	++m_function_idx;
+
+	auto&          script_fn = static_cast<asCScriptFunction&>(fn);
+	asDWORD* const base_pc   = script_fn.scriptData->byteCode.AddressOf();
+
+	MIR_new_module(ctx, name.c_str());
+
+	// imports must be declared before the function. the JIT entry signature is `void(asSVMRegisters *regs, asPWORD
+	// jitArg)`, see BytecodeToC::translate_function
+	MIR_item_t materialize_proto = MIR_new_proto(
+	    ctx,
+	    "asea_materialize_shadow_frames_proto",
+	    0,
+	    nullptr,
+	    2,
+	    MIR_T_P,
+	    "vm_registers",
+	    MIR_T_P,
+	    "frame"
+	);
+	MIR_item_t materialize_import = MIR_new_import(ctx, "asea_materialize_shadow_frames");
+	MIR_item_t func = MIR_new_func(ctx, name.c_str(), 0, nullptr, 2, MIR_T_P, "_regs", MIR_T_I64, "entryLabel");
+
+	FunctionTranslation t{
+	    .ctx         = ctx,
+	    .func        = func,
+	    .regs        = MIR_reg(ctx, "_regs", func->u.func),
+	    .entry_label = MIR_reg(ctx, "entryLabel", func->u.func),
+	    .fp          = MIR_new_func_reg(ctx, func->u.func, MIR_T_I64, "fp"),
+	    .value_reg   = MIR_new_func_reg(ctx, func->u.func, MIR_T_I64, "value_reg"),
+	    .shadow      = MIR_new_func_reg(ctx, func->u.func, MIR_T_I64, "shadow"),
+	    .i0          = MIR_new_func_reg(ctx, func->u.func, MIR_T_I64, "i0"),
+	    .i1          = MIR_new_func_reg(ctx, func->u.func, MIR_T_I64, "i1"),
+	    .i2          = MIR_new_func_reg(ctx, func->u.func, MIR_T_I64, "i2"),
+	    .i3          = MIR_new_func_reg(ctx, func->u.func, MIR_T_I64, "i3"),
+	    .f0          = MIR_new_func_reg(ctx, func->u.func, MIR_T_F, "f0"),
+	    .f1          = MIR_new_func_reg(ctx, func->u.func, MIR_T_F, "f1"),
+	    .d0          = MIR_new_func_reg(ctx, func->u.func, MIR_T_D, "d0"),
+	    .d1          = MIR_new_func_reg(ctx, func->u.func, MIR_T_D, "d1"),
+	    .labels      = {},
+	    .promoted    = {},
+	};
+
+	if (m_config->experimental_promote_frame_variables) {
+		for (const auto& [offset, type] : find_promotable_variables(fn)) {
+			// named after the C locals of BytecodeToC
+			const std::string var_name = offset > 0 ? fmt::format("var{}", offset) : fmt::format("var_arg{}", -offset);
+			const MIR_type_t  reg_type = is_floating_point(type) ? mir_memory_type(type) : MIR_T_I64;
+			t.promoted.emplace(
+			    offset,
+			    PromotedVariable{
+			        .type = type,
+			        .reg  = MIR_new_func_reg(ctx, func->u.func, reg_type, var_name.c_str()),
+			    }
+			);
+		}
+	}
+
+	asPWORD max_entry_label = 1;
+	for (InsRef ins : get_bytecode(fn)) {
+		t.labels.emplace(ins.offset, MIR_new_label(ctx));
+		if (ins.opcode() == asBC_JitEntry) {
+			max_entry_label = std::max(max_entry_label, ins.pword0());
+		}
+	}
+
+	t.insn(MIR_MOV, t.reg(t.fp), t.vm_register(offsetof(asSVMRegisters, stackFramePointer), MIR_T_P));
+	t.insn(MIR_MOV, t.reg(t.value_reg), t.vm_register(offsetof(asSVMRegisters, valueRegister), MIR_T_I64));
+	t.insn(MIR_MOV, t.reg(t.shadow), t.imm(0));
+
+	// promoted variables are loaded regardless of the entry point, like in BytecodeToC::emit_promoted_variables_load
+	for (const auto& [offset, var] : t.promoted) {
+		t.insn(FunctionTranslation::mov(var.type), t.reg(var.reg), t.frame_var(offset, var.type));
+	}
+
+	if (uses_shadow_call_stack) {
+		// direct JIT calls pass a tagged pointer to the shadow frame of the caller instead of a regular entry label
+		MIR_label_t dispatch = MIR_new_label(ctx);
+		t.insn(MIR_UBLE, MIR_new_label_op(ctx, dispatch), t.reg(t.entry_label), t.imm(std::int64_t(max_entry_label)));
+		t.insn(MIR_AND, t.reg(t.shadow), t.reg(t.entry_label), t.imm(~std::int64_t(1)));
+		t.insn(MIR_MOV, t.reg(t.entry_label), t.imm(1));
+		t.append(dispatch);
+	}
+
+	for (InsRef ins : get_bytecode(fn)) {
+		if (ins.opcode() == asBC_JitEntry && ins.pword0() > 1) {
+			t.insn(MIR_BEQ, t.label(ins.offset), t.reg(t.entry_label), t.imm(std::int64_t(ins.pword0())));
+		}
+	}
+
+	for (InsRef ins : get_bytecode(fn)) {
+		t.append(t.labels.at(ins.offset));
+
+		if (auto cmp = bcins::try_as<bcins::Compare>(ins); cmp.has_value()) {
+			t.compare(*cmp);
+			continue;
+		}
+
+		switch (ins.opcode()) {
+		case asBC_JitEntry:
+		case asBC_SUSPEND:  break;
+
+		case asBC_SetV1:
+		case asBC_SetV2:
+		case asBC_SetV4:    t.store(ins.sword0(), u32, t.imm(ins.dword0())); break;
+		case asBC_SetV8:    t.store(ins.sword0(), u64, t.imm(std::int64_t(ins.qword0()))); break;
+
+		case asBC_CpyVtoV4: t.store(ins.sword0(), u32, t.load(ins.sword1(), u32, 0)); break;
+		case asBC_CpyVtoV8: t.store(ins.sword0(), u64, t.load(ins.sword1(), u64, 0)); break;
+		case asBC_CpyVtoR4: t.insn(MIR_MOV, t.reg(t.value_reg), t.load(ins.sword0(), u32, 0)); break;
+		case asBC_CpyVtoR8: t.insn(MIR_MOV, t.reg(t.value_reg), t.load(ins.sword0(), u64, 0)); break;
+		case asBC_CpyRtoV4: t.store(ins.sword0(), u32, t.reg(t.value_reg)); break;
+		case asBC_CpyRtoV8: t.store(ins.sword0(), u64, t.reg(t.value_reg)); break;
+
+		case asBC_IncVi: {
+			const MIR_op_t var = t.load(ins.sword0(), u32, 0);
+			t.insn(MIR_ADDS, var, var, t.imm(1));
+			t.store(ins.sword0(), u32, var);
+			break;
+		}
+		case asBC_DecVi: {
+			const MIR_op_t var = t.load(ins.sword0(), u32, 0);
+			t.insn(MIR_SUBS, var, var, t.imm(1));
+			t.store(ins.sword0(), u32, var);
+			break;
+		}
+
+		case asBC_NEGi:   t.unop_var_inplace(MIR_NEGS, ins, s32); break;
+		case asBC_NEGi64: t.unop_var_inplace(MIR_NEG, ins, s64); break;
+		case asBC_NEGf:   t.unop_var_inplace(MIR_FNEG, ins, f32); break;
+		case asBC_NEGd:   t.unop_var_inplace(MIR_DNEG, ins, f64); break;
+
+		case asBC_ADDi:   t.binop_var_var(MIR_ADDS, ins, s32); break;
+		case asBC_SUBi:   t.binop_var_var(MIR_SUBS, ins, s32); break;
+		case asBC_MULi:   t.binop_var_var(MIR_MULS, ins, s32); break;
+		case asBC_ADDi64: t.binop_var_var(MIR_ADD, ins, s64); break;
+		case asBC_SUBi64: t.binop_var_var(MIR_SUB, ins, s64); break;
+		case asBC_MULi64: t.binop_var_var(MIR_MUL, ins, s64); break;
+		case asBC_ADDf:   t.binop_var_var(MIR_FADD, ins, f32); break;
+		case asBC_SUBf:   t.binop_var_var(MIR_FSUB, ins, f32); break;
+		case asBC_MULf:   t.binop_var_var(MIR_FMUL, ins, f32); break;
+		case asBC_ADDd:   t.binop_var_var(MIR_DADD, ins, f64); break;
+		case asBC_SUBd:   t.binop_var_var(MIR_DSUB, ins, f64); break;
+		case asBC_MULd:   t.binop_var_var(MIR_DMUL, ins, f64); break;
+		case asBC_BAND:   t.binop_var_var(MIR_ANDS, ins, u32); break;
+		case asBC_BOR:    t.binop_var_var(MIR_ORS, ins, u32); break;
+		case asBC_BXOR:   t.binop_var_var(MIR_XORS, ins, u32); break;
+		case asBC_BAND64: t.binop_var_var(MIR_AND, ins, u64); break;
+		case asBC_BOR64:  t.binop_var_var(MIR_OR, ins, u64); break;
+		case asBC_BXOR64: t.binop_var_var(MIR_XOR, ins, u64); break;
+
+		case asBC_ADDIi:  t.binop_var_imm(MIR_ADDS, ins, s32, t.imm(ins.int0(1))); break;
+		case asBC_SUBIi:  t.binop_var_imm(MIR_SUBS, ins, s32, t.imm(ins.int0(1))); break;
+		case asBC_MULIi:  t.binop_var_imm(MIR_MULS, ins, s32, t.imm(ins.int0(1))); break;
+		case asBC_ADDIf:  t.binop_var_imm(MIR_FADD, ins, f32, MIR_new_float_op(ctx, ins.float0(1))); break;
+		case asBC_SUBIf:  t.binop_var_imm(MIR_FSUB, ins, f32, MIR_new_float_op(ctx, ins.float0(1))); break;
+		case asBC_MULIf:  t.binop_var_imm(MIR_FMUL, ins, f32, MIR_new_float_op(ctx, ins.float0(1))); break;
+
+		case asBC_TZ:     t.test(MIR_EQ); break;
+		case asBC_TNZ:    t.test(MIR_NE); break;
+		case asBC_TS:     t.test(MIR_LT); break;
+		case asBC_TNS:    t.test(MIR_GE); break;
+		case asBC_TP:     t.test(MIR_GT); break;
+		case asBC_TNP:    t.test(MIR_LE); break;
+
+		case asBC_JMP:    t.insn(MIR_JMP, t.label(std::size_t(bcins::Jump{ins}.target_offset()))); break;
+		case asBC_JZ:
+		case asBC_JNZ:
+		case asBC_JS:
+		case asBC_JNS:
+		case asBC_JP:
+		case asBC_JNP:    {
+			MIR_insn_code_t branch = MIR_BEQ;
+			switch (ins.opcode()) {
+			case asBC_JNZ: branch = MIR_BNE; break;
+			case asBC_JS:  branch = MIR_BLT; break;
+			case asBC_JNS: branch = MIR_BGE; break;
+			case asBC_JP:  branch = MIR_BGT; break;
+			case asBC_JNP: branch = MIR_BLE; break;
+			default:       break;
+			}
+			t.insn(MIR_EXT32, t.reg(t.i0), t.reg(t.value_reg));
+			t.insn(branch, t.label(std::size_t(bcins::Jump{ins}.target_offset())), t.reg(t.i0), t.imm(0));
+			break;
+		}
+		case asBC_JLowZ:
+		case asBC_JLowNZ: {
+			t.insn(MIR_UEXT8, t.reg(t.i0), t.reg(t.value_reg));
+			t.insn(
+			    ins.opcode() == asBC_JLowZ ? MIR_BEQ : MIR_BNE,
+			    t.label(std::size_t(bcins::Jump{ins}.target_offset())),
+			    t.reg(t.i0),
+			    t.imm(0)
+			);
+			break;
+		}
+
+		case asBC_RET: {
+			t.insn(MIR_MOV, t.vm_register(offsetof(asSVMRegisters, valueRegister), MIR_T_I64), t.reg(t.value_reg));
+
+			if (m_config->experimental_fast_script_return) {
+				translate_script_return(t, ins.word0(), uses_shadow_call_stack);
+				break;
+			}
+
+			// let the VM pop the call stack. the stack pointer was never modified, so it does not need to be saved.
+			t.insn(
+			    MIR_MOV,
+			    t.vm_register(offsetof(asSVMRegisters, programPointer), MIR_T_P),
+			    t.imm(std::int64_t(reinterpret_cast<std::intptr_t>(base_pc + ins.offset)))
+			);
+			if (uses_shadow_call_stack) {
+				MIR_label_t no_shadow = MIR_new_label(ctx);
+				t.insn(MIR_BEQ, MIR_new_label_op(ctx, no_shadow), t.reg(t.shadow), t.imm(0));
+				t.append(MIR_new_call_insn(
+				    ctx,
+				    4,
+				    MIR_new_ref_op(ctx, materialize_proto),
+				    MIR_new_ref_op(ctx, materialize_import),
+				    t.reg(t.regs),
+				    t.reg(t.shadow)
+				));
+				t.append(no_shadow);
+			}
+			t.append(MIR_new_ret_insn(ctx, 0));
+			break;
+		}
+
+		default: angelsea_assert(false && "instruction should have been rejected by can_translate");
+		}
+	}
+
+	// unreachable in valid bytecode, which always ends with a return
+	t.append(MIR_new_ret_insn(ctx, 0));
+
+	MIR_finish_func(ctx);
+	MIR_finish_module(ctx);
+
+	return name;
+}
+
+} // namespace angelsea::detail
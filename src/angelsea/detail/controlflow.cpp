@@ -0,0 +1,84 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+#include <angelsea/detail/bytecodeinstruction.hpp>
+#include <angelsea/detail/bytecodetools.hpp>
+#include <angelsea/detail/controlflow.hpp>
+#include <angelsea/detail/debug.hpp>
+#include <set>
+
+namespace angelsea::detail {
+
+ControlFlowGraph build_control_flow_graph(
+    asIScriptFunction&                                                 fn,
+    const std::unordered_map<std::size_t, std::vector<std::size_t>>& switch_map
+) {
+	auto              bytecode      = get_bytecode(fn);
+	const std::size_t bytecode_size = bytecode.span().size();
+
+	// offsets of every instruction starting a basic block
+	std::set<std::size_t> leaders{0};
+	for (InsRef ins : bytecode) {
+		const std::size_t next = ins.offset + ins.size();
+
+		if (ins.opcode() == asBC_JitEntry && ins.pword0() != 0) {
+			leaders.insert(ins.offset);
+		} else if (auto jmp = bcins::try_as<bcins::Jump>(ins); jmp.has_value()) {
+			leaders.insert(std::size_t(jmp->target_offset()));
+			leaders.insert(next);
+		} else if (ins.opcode() == asBC_JMPP) {
+			leaders.insert(switch_map.at(ins.offset).begin(), switch_map.at(ins.offset).end());
+			leaders.insert(next);
+		} else if (ins.opcode() == asBC_RET) {
+			leaders.insert(next);
+		}
+	}
+	leaders.erase(bytecode_size);
+
+	ControlFlowGraph cfg;
+
+	for (InsRef ins : bytecode) {
+		if (leaders.contains(ins.offset)) {
+			cfg.blocks.emplace(
+			    ins.offset,
+			    BasicBlock{
+			        .begin          = ins.offset,
+			        .end            = ins.offset,
+			        .is_entry_point = ins.offset == 0 || (ins.opcode() == asBC_JitEntry && ins.pword0() != 0),
+			        .successors     = {},
+			        .predecessors   = {},
+			    }
+			);
+		}
+
+		BasicBlock& block = std::prev(cfg.blocks.end())->second;
+		block.end         = ins.offset + ins.size();
+
+		if (block.end != bytecode_size && !leaders.contains(block.end)) {
+			continue;
+		}
+
+		// this is the last instruction of the block
+		if (auto jmp = bcins::try_as<bcins::Jump>(ins); jmp.has_value()) {
+			block.successors.push_back(std::size_t(jmp->target_offset()));
+			if (ins.opcode() != asBC_JMP) {
+				block.successors.push_back(block.end);
+			}
+		} else if (ins.opcode() == asBC_JMPP) {
+			const auto& targets = switch_map.at(ins.offset);
+			block.successors.assign(targets.begin(), targets.end());
+		} else if (ins.opcode() != asBC_RET && block.end != bytecode_size) {
+			block.successors.push_back(block.end);
+		}
+	}
+
+	for (auto& [offset, block] : cfg.blocks) {
+		for (const std::size_t successor : block.successors) {
+			angelsea_assert(cfg.blocks.contains(successor));
+			cfg.blocks.at(successor).predecessors.push_back(offset);
+		}
+	}
+
+	return cfg;
+}
+
+} // namespace angelsea::detail
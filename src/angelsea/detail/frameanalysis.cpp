@@ -0,0 +1,310 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+#include <angelsea/detail/bytecodeinstruction.hpp>
+#include <angelsea/detail/bytecodetools.hpp>
+#include <angelsea/detail/debug.hpp>
+#include <angelsea/detail/frameanalysis.hpp>
+#include <as_scriptfunction.h>
+#include <cstdint>
+#include <optional>
+#include <set>
+#include <utility>
+
+namespace angelsea::detail {
+
+PowInfo get_pow_info(asEBCInstr opcode) {
+	using namespace var_types;
+
+	switch (opcode) {
+	case asBC_POWi:   return {.type = s32, .exponent_type = s32, .runtime_function = "asea_powi"};
+	case asBC_POWu:   return {.type = u32, .exponent_type = u32, .runtime_function = "asea_powu"};
+	case asBC_POWi64: return {.type = s64, .exponent_type = s64, .runtime_function = "asea_powi64"};
+	case asBC_POWu64: return {.type = u64, .exponent_type = u64, .runtime_function = "asea_powu64"};
+	case asBC_POWf:   return {.type = f32, .exponent_type = f32, .runtime_function = "asea_powf"};
+	case asBC_POWd:   return {.type = f64, .exponent_type = f64, .runtime_function = "asea_powd"};
+	case asBC_POWdi:  return {.type = f64, .exponent_type = s32, .runtime_function = "asea_powdi"};
+	default:          angelsea_assert(false && "not a pow instruction"); return {};
+	}
+}
+
+std::map<int, VarType> find_promotable_variables(asIScriptFunction& fn) {
+	using namespace var_types;
+
+	std::map<int, VarType> promoted;
+
+	/// How an instruction accesses a variable, which restricts the type that the variable can be promoted to.
+	enum class Access : std::uint8_t {
+		/// Only the raw bits are copied around (see frame_var_bits), so any type of the same size works.
+		BITS,
+		/// The result does not depend on the signedness of integral types, but integers and floats do not mix.
+		SAME_CLASS,
+		/// The variable must be of this exact type.
+		EXACT,
+	};
+
+	struct Slot {
+		std::vector<std::pair<VarType, Access>> accesses;
+		/// Whether any instruction accesses the variable in a way we do not know about, e.g. by taking its address.
+		bool unsupported = false;
+	};
+
+	std::map<int, Slot> slots;
+
+	const auto access = [&](int offset, VarType type, Access kind) {
+		slots[offset].accesses.emplace_back(type, kind);
+	};
+	const auto arith_access = [&](int offset, VarType type) {
+		access(offset, type, is_floating_point(type) ? Access::EXACT : Access::SAME_CLASS);
+	};
+	const auto arith_access_all = [&](InsRef ins, VarType type) {
+		for (const short offset : get_variable_operands(ins)) {
+			arith_access(offset, type);
+		}
+	};
+
+	for (InsRef ins : get_bytecode(fn)) {
+		if (const auto cast = bcins::try_as<bcins::PrimitiveCast>(ins); cast.has_value()) {
+			if (cast->src.size != cast->dst.size && cast->dst.size < 4) {
+				// written through a pointer, see emit_primitive_cast_var_ins
+				slots[cast->dst_offset()].unsupported = true;
+				arith_access(cast->src_offset(), cast->src);
+			} else if (!is_floating_point(cast->src) && !is_floating_point(cast->dst)
+			           && cast->src.size == cast->dst.size) {
+				arith_access(cast->src_offset(), cast->src);
+				arith_access(cast->dst_offset(), cast->dst);
+			} else {
+				// sign or zero extension and conversions to and from floats depend on the exact type
+				access(cast->src_offset(), cast->src, Access::EXACT);
+				access(cast->dst_offset(), cast->dst, Access::EXACT);
+			}
+			continue;
+		}
+
+		switch (ins.opcode()) {
+		case asBC_SetV1:
+		case asBC_SetV2:
+		case asBC_SetV4:
+		case asBC_CpyVtoR4:
+		case asBC_CpyRtoV4:
+		case asBC_CpyVtoV4:
+		case asBC_WRTV4:
+		case asBC_RDR4:
+		case asBC_PshV4:
+			for (const short offset : get_variable_operands(ins)) {
+				access(offset, u32, Access::BITS);
+			}
+			break;
+
+		case asBC_SetV8:
+		case asBC_CpyVtoR8:
+		case asBC_CpyRtoV8:
+		case asBC_CpyVtoV8:
+		case asBC_WRTV8:
+		case asBC_RDR8:
+		case asBC_PshV8:
+			for (const short offset : get_variable_operands(ins)) {
+				access(offset, u64, Access::BITS);
+			}
+			break;
+
+		case asBC_IncVi:
+		case asBC_DecVi:
+		case asBC_BNOT:
+		case asBC_BAND:
+		case asBC_BOR:
+		case asBC_BXOR:
+		case asBC_BSLL:   arith_access_all(ins, u32); break;
+
+		case asBC_JMPP:
+		case asBC_NEGi:
+		case asBC_ADDi:
+		case asBC_SUBi:
+		case asBC_MULi:
+		case asBC_DIVi:
+		case asBC_MODi:
+		case asBC_DIVu:
+		case asBC_MODu:
+		case asBC_ADDIi:
+		case asBC_SUBIi:
+		case asBC_MULIi:  arith_access_all(ins, s32); break;
+
+		case asBC_NEGi64:
+		case asBC_ADDi64:
+		case asBC_SUBi64:
+		case asBC_MULi64:
+		case asBC_DIVi64:
+		case asBC_MODi64:
+		case asBC_DIVu64:
+		case asBC_MODu64:
+		case asBC_BNOT64:
+		case asBC_BAND64:
+		case asBC_BOR64:
+		case asBC_BXOR64: arith_access_all(ins, s64); break;
+
+		case asBC_NEGf:
+		case asBC_ADDf:
+		case asBC_SUBf:
+		case asBC_MULf:
+		case asBC_DIVf:
+		case asBC_MODf:
+		case asBC_ADDIf:
+		case asBC_SUBIf:
+		case asBC_MULIf:  arith_access_all(ins, f32); break;
+
+		case asBC_NEGd:
+		case asBC_ADDd:
+		case asBC_SUBd:
+		case asBC_MULd:
+		case asBC_DIVd:
+		case asBC_MODd:   arith_access_all(ins, f64); break;
+
+		// the exponentiation routines depend on the exact type of their operands
+		case asBC_POWi:
+		case asBC_POWu:
+		case asBC_POWi64:
+		case asBC_POWu64:
+		case asBC_POWf:
+		case asBC_POWd:
+		case asBC_POWdi:  {
+			const PowInfo pow = get_pow_info(ins.opcode());
+			access(ins.sword0(), pow.type, Access::EXACT);
+			access(ins.sword1(), pow.type, Access::EXACT);
+			access(ins.sword2(), pow.exponent_type, Access::EXACT);
+			break;
+		}
+
+		// the shift amount is always a dword, and right shifts depend on the signedness of the lhs
+		case asBC_BSLL64:
+			arith_access(ins.sword0(), u64);
+			arith_access(ins.sword1(), u64);
+			arith_access(ins.sword2(), u32);
+			break;
+		case asBC_BSRL:
+		case asBC_BSRA:
+		case asBC_BSRL64:
+		case asBC_BSRA64: {
+			const bool    is_64      = ins.opcode() == asBC_BSRL64 || ins.opcode() == asBC_BSRA64;
+			const bool    is_signed  = ins.opcode() == asBC_BSRA || ins.opcode() == asBC_BSRA64;
+			const VarType value_type = is_64 ? (is_signed ? s64 : u64) : (is_signed ? s32 : u32);
+			arith_access(ins.sword0(), value_type);
+			access(ins.sword1(), value_type, Access::EXACT);
+			arith_access(ins.sword2(), u32);
+			break;
+		}
+
+		case asBC_CMPi:
+		case asBC_CMPu:
+		case asBC_CMPi64:
+		case asBC_CMPu64:
+		case asBC_CMPf:
+		case asBC_CMPd:
+		case asBC_CMPIi:
+		case asBC_CMPIu:
+		case asBC_CMPIf:  {
+			const bcins::Compare compare{ins};
+			arith_access(compare.lhs.idx, compare.lhs.type);
+			if (const auto* rhs = std::get_if<operands::FrameVariable>(&compare.rhs); rhs != nullptr) {
+				arith_access(rhs->idx, rhs->type);
+			}
+			break;
+		}
+
+		default: {
+			for (const short offset : get_variable_operands(ins)) {
+				slots[offset].unsupported = true;
+			}
+			break;
+		}
+		}
+	}
+
+	const auto pick_type = [](const Slot& slot) -> std::optional<VarType> {
+		if (slot.unsupported || slot.accesses.empty()) {
+			return {};
+		}
+
+		const std::size_t size = slot.accesses.front().first.size;
+		if (size != 4 && size != 8) {
+			return {};
+		}
+
+		std::optional<VarType> exact_type, class_type;
+		for (const auto& [type, kind] : slot.accesses) {
+			if (type.size != size) {
+				return {};
+			}
+
+			if (kind == Access::BITS) {
+				continue;
+			}
+
+			if (class_type.has_value() && is_floating_point(*class_type) != is_floating_point(type)) {
+				return {};
+			}
+			class_type = class_type.value_or(type);
+
+			if (kind == Access::EXACT) {
+				if (exact_type.has_value() && *exact_type != type) {
+					return {};
+				}
+				exact_type = type;
+			}
+		}
+
+		return exact_type.value_or(class_type.value_or(size == 8 ? u64 : u32));
+	};
+
+	// track which slots cover every dword of the stack frame, so that we can reject any overlap. if we don't know the
+	// size of the accessed value, assume the worst.
+	std::map<int, std::set<int>> dword_users;
+
+	const auto cover = [&](int offset, int dwords) {
+		for (int i = 0; i < dwords; ++i) {
+			dword_users[offset - i].insert(offset);
+		}
+	};
+
+	std::set<int> memory_only;
+
+	auto& script_fn = static_cast<asCScriptFunction&>(fn);
+	if (script_fn.objectType != nullptr) {
+		memory_only.insert(0); // `this` pointer
+	}
+
+	for (asUINT i = 0; i < script_fn.scriptData->variables.GetLength(); ++i) {
+		const asSScriptVariable& var  = *script_fn.scriptData->variables[i];
+		const asCDataType&       type = var.type;
+
+		const bool is_value_on_stack = type.IsObject() && !type.IsObjectHandle() && !type.IsReference() && !var.onHeap;
+		cover(var.stackOffset, is_value_on_stack ? type.GetSizeInMemoryDWords() : type.GetSizeOnStackDWords());
+
+		if (!type.IsPrimitive() || type.IsReference()) {
+			memory_only.insert(var.stackOffset);
+		}
+	}
+
+	for (const auto& [offset, slot] : slots) {
+		const auto type = pick_type(slot);
+		cover(offset, type.has_value() ? int(type->size / 4) : 2);
+	}
+
+	for (const auto& [offset, slot] : slots) {
+		const auto type = pick_type(slot);
+		if (!type.has_value() || memory_only.contains(offset)) {
+			continue;
+		}
+
+		bool overlaps = false;
+		for (int i = 0; i < int(type->size / 4); ++i) {
+			overlaps = overlaps || dword_users[offset - i].size() > 1;
+		}
+
+		if (!overlaps) {
+			promoted.emplace(offset, *type);
+		}
+	}
+
+	return promoted;
+}
+
+} // namespace angelsea::detail
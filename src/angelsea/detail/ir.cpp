@@ -0,0 +1,782 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+#include <algorithm>
+#include <angelsea/detail/bytecodeinstruction.hpp>
+#include <angelsea/detail/bytecodetools.hpp>
+#include <angelsea/detail/controlflow.hpp>
+#include <angelsea/detail/debug.hpp>
+#include <angelsea/detail/frameanalysis.hpp>
+#include <angelsea/detail/ir.hpp>
+#include <numeric>
+#include <set>
+#include <utility>
+
+namespace angelsea::detail::ir {
+
+namespace {
+
+/// How an instruction that is modelled as arithmetic lays out its operands.
+enum class ArithmeticForm : std::uint8_t {
+	/// `sword0 = op sword0`
+	IN_PLACE,
+	/// `sword0 = sword0 op immediate`
+	IN_PLACE_IMMEDIATE,
+	/// `sword0 = sword1 op sword2`
+	VAR_VAR,
+	/// `sword0 = sword1 op immediate`
+	VAR_IMMEDIATE,
+};
+
+struct Arithmetic {
+	Opcode           opcode;
+	ArithmeticForm   form;
+	std::string_view c_operator;
+	VarType          type;
+	VarType          rhs_type;
+};
+
+/// How an instruction that is not modelled accesses its variable operands.
+enum class OperandAccess : std::uint8_t {
+	READ,
+	WRITE,
+	READ_WRITE,
+};
+
+} // namespace
+
+static std::optional<Arithmetic> get_arithmetic(asEBCInstr opcode) {
+	using namespace var_types;
+	using enum ArithmeticForm;
+
+	const auto unary = [](std::string_view op, VarType type) {
+		return Arithmetic{Opcode::UNARY, IN_PLACE, op, type, type};
+	};
+	const auto binary = [](std::string_view op, VarType type, VarType rhs_type) {
+		return Arithmetic{Opcode::BINARY, VAR_VAR, op, type, rhs_type};
+	};
+	const auto binary_imm = [](std::string_view op, VarType type) {
+		return Arithmetic{Opcode::BINARY, VAR_IMMEDIATE, op, type, type};
+	};
+
+	switch (opcode) {
+	case asBC_NEGi:   return unary("-", s32);
+	case asBC_NEGi64: return unary("-", s64);
+	case asBC_NEGf:   return unary("-", f32);
+	case asBC_NEGd:   return unary("-", f64);
+	case asBC_BNOT:   return unary("~", u32);
+	case asBC_BNOT64: return unary("~", u64);
+
+	case asBC_IncVi:  return Arithmetic{Opcode::BINARY, IN_PLACE_IMMEDIATE, "+", u32, u32};
+	case asBC_DecVi:  return Arithmetic{Opcode::BINARY, IN_PLACE_IMMEDIATE, "-", u32, u32};
+
+	case asBC_ADDi:   return binary("+", s32, s32);
+	case asBC_SUBi:   return binary("-", s32, s32);
+	case asBC_MULi:   return binary("*", s32, s32);
+	case asBC_ADDi64: return binary("+", s64, s64);
+	case asBC_SUBi64: return binary("-", s64, s64);
+	case asBC_MULi64: return binary("*", s64, s64);
+	case asBC_ADDf:   return binary("+", f32, f32);
+	case asBC_SUBf:   return binary("-", f32, f32);
+	case asBC_MULf:   return binary("*", f32, f32);
+	case asBC_ADDd:   return binary("+", f64, f64);
+	case asBC_SUBd:   return binary("-", f64, f64);
+	case asBC_MULd:   return binary("*", f64, f64);
+
+	case asBC_BAND:   return binary("&", u32, u32);
+	case asBC_BOR:    return binary("|", u32, u32);
+	case asBC_BXOR:   return binary("^", u32, u32);
+	case asBC_BSLL:   return binary("<<", u32, u32);
+	case asBC_BSRL:   return binary(">>", u32, u32);
+	case asBC_BSRA:   return binary(">>", s32, u32);
+	case asBC_BAND64: return binary("&", u64, u64);
+	case asBC_BOR64:  return binary("|", u64, u64);
+	case asBC_BXOR64: return binary("^", u64, u64);
+	case asBC_BSLL64: return binary("<<", u64, u32);
+	case asBC_BSRL64: return binary(">>", u64, u32);
+	case asBC_BSRA64: return binary(">>", s64, u32);
+
+	case asBC_ADDIi:  return binary_imm("+", s32);
+	case asBC_SUBIi:  return binary_imm("-", s32);
+	case asBC_MULIi:  return binary_imm("*", s32);
+	case asBC_ADDIf:  return binary_imm("+", f32);
+	case asBC_SUBIf:  return binary_imm("-", f32);
+	case asBC_MULIf:  return binary_imm("*", f32);
+
+	default:          return {};
+	}
+}
+
+static OperandAccess get_operand_access(InsRef ins) {
+	if (bcins::is_specific_ins<bcins::Compare>(ins)) {
+		return OperandAccess::READ;
+	}
+
+	switch (ins.opcode()) {
+	case asBC_PshV4:
+	case asBC_PshV8:
+	case asBC_PshVPtr:
+	case asBC_PshListElmnt:
+	case asBC_CpyVtoR4:
+	case asBC_CpyVtoR8:
+	case asBC_CpyVtoG4:
+	case asBC_WRTV1:
+	case asBC_WRTV2:
+	case asBC_WRTV4:
+	case asBC_WRTV8:
+	case asBC_JMPP:
+	case asBC_ChkNullV:
+	case asBC_LoadRObjR: return OperandAccess::READ;
+
+	case asBC_SetV1:
+	case asBC_SetV2:
+	case asBC_SetV4:
+	case asBC_SetV8:
+	case asBC_CpyRtoV4:
+	case asBC_CpyRtoV8:
+	case asBC_CpyGtoV4:
+	case asBC_RDR1:
+	case asBC_RDR2:
+	case asBC_RDR4:
+	case asBC_RDR8:
+	case asBC_ClrVPtr:   return OperandAccess::WRITE;
+
+	default:             return OperandAccess::READ_WRITE;
+	}
+}
+
+/// Whether an instruction may leave JIT code or run other code, see \ref Instruction::is_barrier. Anything that we do
+/// not know about is assumed to.
+static bool is_barrier(InsRef ins) {
+	if (bcins::is_specific_ins<bcins::Jump>(ins) || bcins::is_specific_ins<bcins::Compare>(ins)
+	    || bcins::is_specific_ins<bcins::PrimitiveCast>(ins) || get_arithmetic(ins.opcode()).has_value()) {
+		return false;
+	}
+
+	switch (ins.opcode()) {
+	// the caller cannot observe the stack frame of its callee after it returned
+	case asBC_RET:
+	case asBC_JitEntry:
+	case asBC_JMPP:
+	case asBC_TZ:
+	case asBC_TNZ:
+	case asBC_TS:
+	case asBC_TNS:
+	case asBC_TP:
+	case asBC_TNP:
+	case asBC_PshC4:
+	case asBC_PshV4:
+	case asBC_PshC8:
+	case asBC_PshV8:
+	case asBC_PshNull:
+	case asBC_PshVPtr:
+	case asBC_PshRPtr:
+	case asBC_PopPtr:
+	case asBC_PopRPtr:
+	case asBC_SetV1:
+	case asBC_SetV2:
+	case asBC_SetV4:
+	case asBC_SetV8:
+	case asBC_ClrVPtr:
+	case asBC_CpyVtoV4:
+	case asBC_CpyVtoV8:
+	case asBC_CpyVtoR4:
+	case asBC_CpyVtoR8:
+	case asBC_CpyRtoV4:
+	case asBC_CpyRtoV8: return false;
+	default:            return true;
+	}
+}
+
+/// Mask of the bits of a value of `type` in \ref Value::constant.
+static std::uint64_t constant_mask(VarType type) { return type.size == 8 ? ~std::uint64_t(0) : 0xFFFF'FFFF; }
+
+/// Computes the result of integral arithmetic with constant operands, with the wrapping semantics of the VM. Floating
+/// point arithmetic is left to the C compiler.
+static std::optional<std::uint64_t> fold(const Instruction& ins, std::uint64_t lhs, std::uint64_t rhs) {
+	if (is_floating_point(ins.type)) {
+		return {};
+	}
+
+	std::uint64_t result;
+	if (ins.opcode == Opcode::UNARY) {
+		switch (ins.c_operator[0]) {
+		case '-': result = 0 - lhs; break;
+		case '~': result = ~lhs; break;
+		default:  return {};
+		}
+	} else {
+		// shifts are not folded, as shifting by the width of the type or more differs between C and the VM
+		switch (ins.c_operator.size() == 1 ? ins.c_operator[0] : '\0') {
+		case '+': result = lhs + rhs; break;
+		case '-': result = lhs - rhs; break;
+		case '*': result = lhs * rhs; break;
+		case '&': result = lhs & rhs; break;
+		case '|': result = lhs | rhs; break;
+		case '^': result = lhs ^ rhs; break;
+		default:  return {};
+		}
+	}
+
+	return result & constant_mask(ins.type);
+}
+
+Function build_function(
+    asIScriptFunction&                                                 script_fn,
+    const std::unordered_map<std::size_t, std::vector<std::size_t>>& switch_map,
+    std::span<const asEBCInstr>                                        opaque_opcodes
+) {
+	Function fn;
+	fn.cfg = build_control_flow_graph(script_fn, switch_map);
+
+	// variables whose address is taken may be modified by anything we call, so we never assume anything about them
+	std::set<int> escaping_variables, referenced_variables;
+	for (InsRef ins : get_bytecode(script_fn)) {
+		switch (ins.opcode()) {
+		case asBC_PSF:
+		case asBC_VAR:
+		case asBC_LDV:
+		case asBC_LoadVObjR: escaping_variables.insert(ins.sword0()); break;
+		case asBC_LoadThisR: referenced_variables.insert(0); break;
+		default:             break;
+		}
+
+		for (const short variable : get_variable_operands(ins)) {
+			referenced_variables.insert(variable);
+		}
+	}
+
+	const std::map<int, VarType> typed_variables = find_promotable_variables(script_fn);
+	for (const int variable : referenced_variables) {
+		if (escaping_variables.contains(variable)) {
+			continue;
+		}
+
+		const auto it = typed_variables.find(variable);
+		fn.variables.emplace(variable, it != typed_variables.end() ? std::optional{it->second} : std::nullopt);
+	}
+
+	const auto new_value = [&](int variable, ValueKind kind, std::size_t definition) {
+		fn.values.push_back(Value{
+		    .variable   = variable,
+		    .type       = fn.variables.at(variable),
+		    .kind       = kind,
+		    .definition = definition,
+		    .constant   = {},
+		    .is_live    = true,
+		});
+		return fn.values.size() - 1;
+	};
+
+	const auto is_typed = [&](int variable) {
+		const auto it = fn.variables.find(variable);
+		return it != fn.variables.end() && it->second.has_value();
+	};
+
+	// every variable gets a phi on entry of every block at first, and the trivial ones are removed afterwards
+	for (const auto& [offset, cfg_block] : fn.cfg.blocks) {
+		Block& block = fn.blocks[offset];
+		for (const auto& [variable, type] : fn.variables) {
+			const std::size_t phi_idx = fn.phis.size();
+			const ValueId     result  = new_value(variable, ValueKind::PHI, phi_idx);
+			fn.phis.push_back(Phi{.block = offset, .result = result, .incoming = {}});
+			block.phis.push_back(phi_idx);
+			block.entry_values.emplace(variable, result);
+		}
+	}
+
+	auto bytecode = get_bytecode(script_fn);
+	for (auto& [offset, block] : fn.blocks) {
+		const BasicBlock&      cfg_block = fn.cfg.blocks.at(offset);
+		std::map<int, ValueId> current   = block.entry_values;
+
+		const auto read = [&](Instruction& ins, int variable) {
+			if (const auto it = current.find(variable); it != current.end()) {
+				ins.operands.push_back(it->second);
+			}
+		};
+		const auto define = [&](Instruction& ins, int variable) {
+			const ValueId value = new_value(variable, ValueKind::DEFINITION, fn.instructions.size());
+			ins.result          = value;
+			current[variable]   = value;
+		};
+		const auto clobber = [&](Instruction& ins, int variable) {
+			if (!fn.variables.contains(variable)) {
+				return;
+			}
+			const ValueId value = new_value(variable, ValueKind::UNKNOWN, 0);
+			ins.clobbers.push_back(value);
+			current[variable] = value;
+		};
+		// we do not know the size of untyped variables, so writes to them may overlap their neighbours
+		const auto clobber_write = [&](Instruction& ins, int variable) {
+			clobber(ins, variable);
+			if (!is_typed(variable)) {
+				for (const int neighbour : {variable - 1, variable + 1}) {
+					if (!is_typed(neighbour)) {
+						clobber(ins, neighbour);
+					}
+				}
+			}
+		};
+
+		const auto build_modelled = [&](InsRef bc, Instruction& ins) -> bool {
+			using namespace var_types;
+
+			switch (bc.opcode()) {
+			case asBC_SetV1:
+			case asBC_SetV2:
+			case asBC_SetV4:
+			case asBC_SetV8:
+				if (!is_typed(bc.sword0())) {
+					return false;
+				}
+				ins.opcode    = Opcode::CONSTANT;
+				ins.type      = bc.opcode() == asBC_SetV8 ? u64 : u32;
+				ins.immediate = bc.opcode() == asBC_SetV8 ? bc.qword0() : bc.dword0();
+				define(ins, bc.sword0());
+				return true;
+
+			case asBC_CpyVtoV4:
+			case asBC_CpyVtoV8:
+				if (!is_typed(bc.sword0()) || !is_typed(bc.sword1())) {
+					return false;
+				}
+				ins.opcode = Opcode::COPY;
+				ins.type   = bc.opcode() == asBC_CpyVtoV8 ? u64 : u32;
+				read(ins, bc.sword1());
+				define(ins, bc.sword0());
+				return true;
+
+			default: break;
+			}
+
+			const auto arithmetic = get_arithmetic(bc.opcode());
+			if (!arithmetic.has_value()) {
+				return false;
+			}
+
+			const std::vector<short> variables = get_variable_operands(bc);
+			if (!std::ranges::all_of(variables, is_typed)) {
+				return false;
+			}
+
+			ins.opcode     = arithmetic->opcode;
+			ins.type       = arithmetic->type;
+			ins.rhs_type   = arithmetic->rhs_type;
+			ins.c_operator = arithmetic->c_operator;
+
+			switch (arithmetic->form) {
+			case ArithmeticForm::IN_PLACE: read(ins, bc.sword0()); break;
+			case ArithmeticForm::IN_PLACE_IMMEDIATE:
+				read(ins, bc.sword0());
+				ins.immediate = 1;
+				break;
+			case ArithmeticForm::VAR_VAR:
+				read(ins, bc.sword1());
+				read(ins, bc.sword2());
+				break;
+			case ArithmeticForm::VAR_IMMEDIATE:
+				read(ins, bc.sword1());
+				ins.immediate = bc.dword0(1);
+				break;
+			}
+
+			define(ins, bc.sword0());
+			return true;
+		};
+
+		const auto build = [&](InsRef bc) {
+			Instruction ins{
+			    .opcode       = Opcode::OPAQUE,
+			    .offset       = bc.offset,
+			    .type         = {},
+			    .rhs_type     = {},
+			    .c_operator   = {},
+			    .immediate    = 0,
+			    .operands     = {},
+			    .result       = {},
+			    .clobbers     = {},
+			    .is_barrier   = false,
+			    .is_redundant = false,
+			};
+
+			const bool is_opaque = std::ranges::find(opaque_opcodes, bc.opcode()) != opaque_opcodes.end();
+			if (!is_opaque && build_modelled(bc, ins)) {
+				return ins;
+			}
+
+			ins.is_barrier = is_opaque || is_barrier(bc);
+
+			const bool is_null_check
+			    = bc.opcode() == asBC_ChkNullV || bc.opcode() == asBC_LoadRObjR || bc.opcode() == asBC_LoadThisR;
+			const int checked_variable = bc.opcode() == asBC_LoadThisR ? 0 : bc.sword0();
+			if (!is_opaque && is_null_check && fn.variables.contains(checked_variable)) {
+				ins.opcode = Opcode::NULL_CHECK;
+				read(ins, checked_variable);
+			}
+
+			const std::vector<short> variables = get_variable_operands(bc);
+			const auto               cast      = bcins::try_as<bcins::PrimitiveCast>(bc);
+			const OperandAccess      access    = get_operand_access(bc);
+
+			if (cast.has_value()) {
+				read(ins, cast->src_offset());
+			} else if (access != OperandAccess::WRITE) {
+				for (const short variable : variables) {
+					read(ins, variable);
+				}
+			}
+
+			if (ins.is_barrier) {
+				for (const auto& [variable, value] : current) {
+					if (is_typed(variable)) {
+						ins.operands.push_back(value);
+					}
+				}
+			}
+
+			if (bc.opcode() == asBC_SUSPEND) {
+				// the line callback may modify any variable through the context
+				for (const auto& [variable, type] : fn.variables) {
+					clobber(ins, variable);
+				}
+				return ins;
+			}
+
+			if (cast.has_value()) {
+				clobber_write(ins, cast->dst_offset());
+			} else if (access != OperandAccess::READ) {
+				for (const short variable : variables) {
+					clobber_write(ins, variable);
+				}
+			}
+
+			// null checks may only leave by raising a script exception, after which the frame is never resumed
+			if (ins.is_barrier && ins.opcode != Opcode::NULL_CHECK) {
+				for (const auto& [variable, type] : fn.variables) {
+					if (type.has_value()) {
+						clobber(ins, variable);
+					}
+				}
+			}
+
+			return ins;
+		};
+
+		block.first_instruction = fn.instructions.size();
+		for (auto it = bytecode.begin().advanced_by_dwords(asDWORD(cfg_block.begin)); (*it).offset < cfg_block.end;
+		     ++it) {
+			fn.instruction_at_offset.emplace((*it).offset, fn.instructions.size());
+			fn.instructions.push_back(build(*it));
+		}
+		block.end_instruction = fn.instructions.size();
+		block.exit_values     = std::move(current);
+	}
+
+	for (Phi& phi : fn.phis) {
+		const BasicBlock& cfg_block = fn.cfg.blocks.at(phi.block);
+		const int         variable  = fn.values[phi.result].variable;
+		for (const std::size_t predecessor : cfg_block.predecessors) {
+			phi.incoming.push_back(fn.blocks.at(predecessor).exit_values.at(variable));
+		}
+		if (cfg_block.is_entry_point) {
+			phi.incoming.push_back(new_value(variable, ValueKind::UNKNOWN, 0));
+		}
+	}
+
+	// a phi is trivial if it only merges a single value (besides itself), in which case it is replaced by that value
+	std::vector<ValueId> replacement(fn.values.size());
+	std::iota(replacement.begin(), replacement.end(), ValueId(0));
+	const auto resolve = [&](ValueId value) {
+		while (replacement[value] != value) {
+			value = replacement[value];
+		}
+		return value;
+	};
+
+	std::vector<bool> is_removed(fn.phis.size(), false);
+	for (bool changed = true; changed;) {
+		changed = false;
+		for (std::size_t i = 0; i < fn.phis.size(); ++i) {
+			if (is_removed[i]) {
+				continue;
+			}
+
+			const Phi&             phi = fn.phis[i];
+			std::optional<ValueId> unique;
+			bool                   is_trivial = true;
+			for (const ValueId incoming : phi.incoming) {
+				const ValueId value = resolve(incoming);
+				if (value == phi.result || value == unique) {
+					continue;
+				}
+				if (unique.has_value()) {
+					is_trivial = false;
+					break;
+				}
+				unique = value;
+			}
+
+			if (is_trivial && unique.has_value()) {
+				replacement[phi.result] = *unique;
+				is_removed[i]           = true;
+				changed                 = true;
+			}
+		}
+	}
+
+	for (Instruction& ins : fn.instructions) {
+		for (ValueId& operand : ins.operands) {
+			operand = resolve(operand);
+		}
+	}
+	for (Phi& phi : fn.phis) {
+		for (ValueId& incoming : phi.incoming) {
+			incoming = resolve(incoming);
+		}
+	}
+	for (auto& [offset, block] : fn.blocks) {
+		std::erase_if(block.phis, [&](std::size_t phi) { return is_removed[phi]; });
+		for (auto* values : {&block.entry_values, &block.exit_values}) {
+			for (auto& [variable, value] : *values) {
+				value = resolve(value);
+			}
+		}
+	}
+
+	return fn;
+}
+
+void propagate_copies(Function& fn) {
+	for (auto& [offset, block] : fn.blocks) {
+		std::map<int, ValueId> current = block.entry_values;
+
+		// follows copies back to their source for as long as it is still held by its variable, and as long as it can be
+		// read as the same class of type
+		const auto find_source = [&](ValueId value) {
+			for (;;) {
+				const Value& copy = fn.values[value];
+				if (copy.kind != ValueKind::DEFINITION || fn.instructions[copy.definition].opcode != Opcode::COPY) {
+					return value;
+				}
+
+				const ValueId source_id = fn.instructions[copy.definition].operands[0];
+				const Value&  source    = fn.values[source_id];
+				if (current.at(source.variable) != source_id || source.type->size != copy.type->size
+				    || is_floating_point(*source.type) != is_floating_point(*copy.type)) {
+					return value;
+				}
+
+				value = source_id;
+			}
+		};
+
+		for (InstructionId id = block.first_instruction; id < block.end_instruction; ++id) {
+			Instruction& ins = fn.instructions[id];
+
+			if (ins.opcode == Opcode::COPY || ins.opcode == Opcode::UNARY || ins.opcode == Opcode::BINARY) {
+				for (ValueId& operand : ins.operands) {
+					operand = find_source(operand);
+				}
+			}
+
+			if (ins.result.has_value()) {
+				current[fn.values[*ins.result].variable] = *ins.result;
+			}
+			for (const ValueId clobber : ins.clobbers) {
+				current[fn.values[clobber].variable] = clobber;
+			}
+		}
+	}
+}
+
+void propagate_constants(Function& fn) {
+	// values start as undefined, meaning that they may still turn out to be any constant, which lets constants flow
+	// through loops
+	enum class State : std::uint8_t { UNDEFINED, CONSTANT, VARYING };
+	struct Lattice {
+		State         state = State::UNDEFINED;
+		std::uint64_t bits  = 0;
+
+		bool operator==(const Lattice&) const = default;
+	};
+
+	std::vector<Lattice> lattice(fn.values.size());
+	for (ValueId id = 0; id < fn.values.size(); ++id) {
+		if (fn.values[id].kind == ValueKind::UNKNOWN || !fn.values[id].type.has_value()) {
+			lattice[id].state = State::VARYING;
+		}
+	}
+
+	const auto meet = [](Lattice& into, const Lattice& from) {
+		if (into.state == State::UNDEFINED || from.state == State::VARYING) {
+			into = from;
+		} else if (from.state == State::CONSTANT && into.state == State::CONSTANT && into.bits != from.bits) {
+			into.state = State::VARYING;
+		}
+	};
+
+	for (bool changed = true; changed;) {
+		changed = false;
+
+		const auto update = [&](ValueId value, Lattice state) {
+			if (lattice[value] != state) {
+				lattice[value] = state;
+				changed        = true;
+			}
+		};
+
+		for (const auto& [offset, block] : fn.blocks) {
+			for (const std::size_t phi_idx : block.phis) {
+				const Phi& phi = fn.phis[phi_idx];
+				if (phi.incoming.empty()) {
+					update(phi.result, {State::VARYING});
+					continue;
+				}
+
+				Lattice state;
+				for (const ValueId incoming : phi.incoming) {
+					meet(state, lattice[incoming]);
+				}
+				update(phi.result, state);
+			}
+
+			for (InstructionId id = block.first_instruction; id < block.end_instruction; ++id) {
+				const Instruction& ins = fn.instructions[id];
+				if (!ins.result.has_value()) {
+					continue;
+				}
+
+				if (ins.opcode == Opcode::CONSTANT) {
+					update(*ins.result, {State::CONSTANT, ins.immediate & constant_mask(ins.type)});
+					continue;
+				}
+
+				// the result is varying if any operand is, and stays undefined until every operand is known
+				Lattice operands{State::CONSTANT};
+				for (const ValueId operand : ins.operands) {
+					const State state = lattice[operand].state;
+					if (state == State::VARYING || (state == State::UNDEFINED && operands.state == State::CONSTANT)) {
+						operands.state = state;
+					}
+				}
+
+				if (operands.state != State::CONSTANT) {
+					update(*ins.result, {operands.state});
+					continue;
+				}
+
+				const std::uint64_t lhs = lattice[ins.operands[0]].bits;
+				if (ins.opcode == Opcode::COPY) {
+					update(*ins.result, {State::CONSTANT, lhs & constant_mask(ins.type)});
+					continue;
+				}
+
+				const std::uint64_t rhs    = ins.operands.size() > 1 ? lattice[ins.operands[1]].bits : ins.immediate;
+				const auto          folded = fold(ins, lhs, rhs);
+				update(*ins.result, folded.has_value() ? Lattice{State::CONSTANT, *folded} : Lattice{State::VARYING});
+			}
+		}
+	}
+
+	for (ValueId id = 0; id < fn.values.size(); ++id) {
+		if (lattice[id].state == State::CONSTANT) {
+			fn.values[id].constant = lattice[id].bits;
+		}
+	}
+}
+
+void eliminate_dead_stores(Function& fn) {
+	std::vector<ValueId> worklist;
+
+	const auto mark_live = [&](ValueId id) {
+		if (!fn.values[id].is_live) {
+			fn.values[id].is_live = true;
+			worklist.push_back(id);
+		}
+	};
+
+	for (Value& value : fn.values) {
+		value.is_live = false;
+	}
+
+	// instructions that are translated as is read their operands from their variables
+	for (const Instruction& ins : fn.instructions) {
+		if (ins.opcode == Opcode::OPAQUE || ins.opcode == Opcode::NULL_CHECK) {
+			for (const ValueId operand : ins.operands) {
+				mark_live(operand);
+			}
+		}
+	}
+
+	while (!worklist.empty()) {
+		const Value& value = fn.values[worklist.back()];
+		worklist.pop_back();
+
+		if (value.kind == ValueKind::PHI) {
+			for (const ValueId incoming : fn.phis[value.definition].incoming) {
+				mark_live(incoming);
+			}
+		} else if (value.kind == ValueKind::DEFINITION && !value.constant.has_value()) {
+			for (const ValueId operand : fn.instructions[value.definition].operands) {
+				if (!fn.values[operand].constant.has_value()) {
+					mark_live(operand);
+				}
+			}
+		}
+	}
+}
+
+void eliminate_redundant_null_checks(Function& fn) {
+	// every value is held by its variable, so it is enough to track which variables hold a value that was checked
+	using NonNullVariables = std::set<int>;
+
+	// updates the variables known to be non-null after `ins`, and returns whether `ins` is a null check that is known
+	// to pass
+	const auto step = [&](const Instruction& ins, NonNullVariables& non_null) -> bool {
+		if (ins.result.has_value()) {
+			non_null.erase(fn.values[*ins.result].variable);
+		}
+		for (const ValueId clobber : ins.clobbers) {
+			non_null.erase(fn.values[clobber].variable);
+		}
+
+		if (ins.opcode != Opcode::NULL_CHECK) {
+			return false;
+		}
+
+		return !non_null.insert(fn.values[ins.operands[0]].variable).second;
+	};
+
+	const auto for_each_instruction = [&](const BasicBlock& cfg_block, auto&& func) {
+		const Block& block = fn.blocks.at(cfg_block.begin);
+		for (InstructionId id = block.first_instruction; id < block.end_instruction; ++id) {
+			func(fn.instructions[id]);
+		}
+	};
+
+	const auto block_entry_states = solve_forward_dataflow(
+	    fn.cfg,
+	    NonNullVariables{},
+	    [](NonNullVariables& into, const NonNullVariables& from) {
+		    std::erase_if(into, [&](int variable) { return !from.contains(variable); });
+	    },
+	    [&](const BasicBlock& cfg_block, NonNullVariables non_null) {
+		    for_each_instruction(cfg_block, [&](const Instruction& ins) { step(ins, non_null); });
+		    return non_null;
+	    }
+	);
+
+	for (const auto& [offset, entry_state] : block_entry_states) {
+		NonNullVariables non_null = entry_state;
+		for_each_instruction(fn.cfg.blocks.at(offset), [&](Instruction& ins) { ins.is_redundant = step(ins, non_null); });
+	}
+}
+
+void optimize(Function& fn) {
+	propagate_copies(fn);
+	propagate_constants(fn);
+	eliminate_dead_stores(fn);
+}
+
+} // namespace angelsea::detail::ir
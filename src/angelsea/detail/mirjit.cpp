@@ -10,10 +10,14 @@
 #include <angelsea/detail/mirjit.hpp>
 #include <angelsea/detail/runtime.hpp>
 #include <as_generic.h>
+#include <atomic>
 #include <bit>
+#include <chrono>
 #include <cmath>
+#include <fmt/format.h>
 #include <mir-gen.h>
 #include <mir.h>
+#include <optional>
 #include <string>
 #include <unordered_map>
 
@@ -29,16 +33,38 @@ static void bind_runtime(Mir& mir) {
 #define ASEA_BIND_MIR(name) MIR_load_external(mir, #name, std::bit_cast<void*>(&(name)))
 	ASEA_BIND_MIR(asea_call_script_function);
 	ASEA_BIND_MIR(asea_call_system_function);
+	ASEA_BIND_MIR(asea_call_generic_guarded);
+	ASEA_BIND_MIR(asea_call_native_guarded);
+	ASEA_BIND_MIR(asea_call_native_guarded_f32);
+	ASEA_BIND_MIR(asea_call_native_guarded_f64);
 	ASEA_BIND_MIR(asea_call_object_method);
 	ASEA_BIND_MIR(asea_prepare_script_stack);
 	ASEA_BIND_MIR(asea_prepare_script_stack_and_vars);
+	ASEA_BIND_MIR(asea_prepare_script_stack_shadow);
+	ASEA_BIND_MIR(asea_prepare_script_stack_shadow_and_vars);
+	ASEA_BIND_MIR(asea_materialize_shadow_frames);
+	ASEA_BIND_MIR(asea_remaining_call_depth);
+	ASEA_BIND_MIR(asea_call_script_nested);
 	ASEA_BIND_MIR(asea_debug_message);
 	ASEA_BIND_MIR(asea_debug_int);
 	ASEA_BIND_MIR(asea_set_internal_exception);
+	ASEA_BIND_MIR(asea_process_suspend);
+	ASEA_BIND_MIR(asea_check_call_status);
+	ASEA_BIND_MIR(asea_resolve_function_handle);
+	ASEA_BIND_MIR(asea_resolve_interface_method);
+	ASEA_BIND_MIR(asea_resolve_bound_function);
+	ASEA_BIND_MIR(asea_powi);
+	ASEA_BIND_MIR(asea_powu);
+	ASEA_BIND_MIR(asea_powi64);
+	ASEA_BIND_MIR(asea_powu64);
+	ASEA_BIND_MIR(asea_powf);
+	ASEA_BIND_MIR(asea_powd);
+	ASEA_BIND_MIR(asea_powdi);
 	ASEA_BIND_MIR(asea_clean_args);
 	ASEA_BIND_MIR(asea_cast);
 	ASEA_BIND_MIR(asea_alloc);
 	ASEA_BIND_MIR(asea_free);
+	ASEA_BIND_MIR(asea_destroy_list);
 	ASEA_BIND_MIR(asea_new_script_object);
 	MIR_load_external(mir, "memcpy", std::bit_cast<void*>(+[](void* dst, const void* src, std::size_t size) {
 		                  return std::memcpy(dst, src, size);
@@ -49,8 +75,34 @@ static void bind_runtime(Mir& mir) {
 #undef ASEA_BIND_MIR
 }
 
+/// Direct JIT calls pass an odd entry label to the callee rather than a pointer: either 1, or a tagged pointer to the
+/// caller's shadow frame. Since we are about to return to the VM, the shadow frames must be materialized.
+static bool handle_direct_jit_call(asSVMRegisters* regs, asPWORD raw) {
+	if ((raw & 1) == 0) {
+		return false;
+	}
+
+	if (raw != 1) {
+		asea_materialize_shadow_frames(regs, std::bit_cast<asea_shadow_frame*>(raw & ~asPWORD(1)));
+	}
+
+	return true;
+}
+
+/// Releases the type references held by the entries of `cache` and frees them.
+static void release_method_cache(asea_method_cache& cache) {
+	asea_method_cache_entry* entry = cache.allocated;
+	while (entry != nullptr) {
+		asea_method_cache_entry* next = entry->next_allocated;
+		entry->type->Release();
+		delete entry;
+		entry = next;
+	}
+	cache = {};
+}
+
 void jit_entry_function_counter(asSVMRegisters* regs, asPWORD lazy_fn_raw) {
-	if (lazy_fn_raw != 1) { // value 1 can be passed in direct JIT calls; ignore it
+	if (!handle_direct_jit_call(regs, lazy_fn_raw)) {
 		auto& lazy_fn = *std::bit_cast<LazyMirFunction*>(lazy_fn_raw);
 
 		if (lazy_fn.hits_before_compile == 0) {
@@ -67,7 +119,7 @@ void jit_entry_function_counter(asSVMRegisters* regs, asPWORD lazy_fn_raw) {
 }
 
 void jit_entry_await_async(asSVMRegisters* regs, asPWORD pending_fn_raw) {
-	if (pending_fn_raw != 1) { // value 1 can be passed in direct JIT calls; ignore it
+	if (!handle_direct_jit_call(regs, pending_fn_raw)) {
 		auto& lazy_fn = *std::bit_cast<AsyncMirFunction*>(pending_fn_raw);
 
 		if (lazy_fn.compiled.ready.load()) {
@@ -83,9 +135,11 @@ MirJit::MirJit(const JitConfig& config, asIScriptEngine& engine) :
     m_config(config),
     m_engine(&engine),
     m_c_generator{m_config, *m_engine},
+    m_mir_generator{m_config},
     m_ignore_unregister{nullptr},
     m_registered_engine_globals{false} {
 	bind_runtime(m_mir);
+	m_c_generator.set_fn_config_callback([this](asIScriptFunction& fn) { return get_fn_config(fn); });
 }
 
 MirJit::~MirJit() {
@@ -93,6 +147,12 @@ MirJit::~MirJit() {
 	while (m_terminating_threads > 0) {
 		m_termination_cv.wait(lk);
 	}
+
+	for (auto& [script_function, caches] : m_method_caches) {
+		for (auto& cache : caches) {
+			release_method_cache(*cache);
+		}
+	}
 }
 
 void MirJit::register_function(asIScriptFunction& script_function) {
@@ -118,7 +178,8 @@ void MirJit::register_function(asIScriptFunction& script_function) {
 	LazyMirFunction* lazy_fn = &lazy_mir_it->second;
 
 	if (!m_fn_config_manual_discovery && m_request_fn_config_callback) {
-		lazy_fn->fn_config = m_request_fn_config_callback(*lazy_fn->script_function);
+		lazy_fn->fn_config             = m_request_fn_config_callback(*lazy_fn->script_function);
+		m_fn_configs[&script_function] = *lazy_fn->fn_config;
 	}
 
 	if (!m_fn_config_manual_discovery && m_config.triggers.eager) {
@@ -135,6 +196,19 @@ void MirJit::unregister_function(asIScriptFunction& script_function) {
 	}
 
 	m_lazy_functions.erase(&script_function);
+	m_fn_configs.erase(&script_function);
+
+	// the JIT function will not be called again, so nothing can be reading the caches anymore
+	auto caches_it = m_method_caches.find(&script_function);
+	if (caches_it != m_method_caches.end()) {
+		for (auto& cache : caches_it->second) {
+			release_method_cache(*cache);
+		}
+		m_method_caches.erase(caches_it);
+	}
+
+	// callers referring to the slot hold a reference to the function, so none of them can run anymore either
+	m_typed_entry_slots.erase(&script_function);
 
 	auto async_it = m_async_codegen_functions.find(&script_function);
 	if (async_it != m_async_codegen_functions.end()) {
@@ -210,6 +284,13 @@ bool MirJit::translate_lazy_function(LazyMirFunction& fn) {
 		c_name = name;
 	});
 
+	std::string typed_entry_c_name;
+	m_c_generator.set_map_typed_entry_callback([&]([[maybe_unused]] asIScriptFunction& received_fn,
+	                                               const std::string&                  name) {
+		angelsea_assert(&received_fn == fn.script_function);
+		typed_entry_c_name = name;
+	});
+
 	asIScriptModule* script_module = fn.script_function->GetModule();
 
 	const char* name = script_module != nullptr ? script_module->GetName() : "<anon>";
@@ -224,33 +305,77 @@ bool MirJit::translate_lazy_function(LazyMirFunction& fn) {
 
 	asUINT bytecode_length;
 	fn.script_function->GetByteCode(&bytecode_length);
-	if (bytecode_length * sizeof(asDWORD) > m_config.max_bytecode_bytes) {
-		if (!fn_config.ignore_perf_warnings) {
+	const std::size_t max_bytecode_bytes = m_config.max_bytecode_bytes;
+	const bool exceeds_bytecode_size
+	    = max_bytecode_bytes != 0 && bytecode_length * sizeof(asDWORD) > max_bytecode_bytes;
+
+	const auto cost_estimate = m_c_generator.estimate_compile_cost(*fn.script_function);
+	if (exceeds_bytecode_size
+	    || (m_config.compile_cost.max_cost >= 0.0 && cost_estimate.cost > m_config.compile_cost.max_cost)) {
+		if (!fn_config.ignore_perf_warnings && exceeds_bytecode_size) {
+			log(m_config,
+			    *m_engine,
+			    *fn.script_function,
+			    LogSeverity::ASEA_WARNING,
+			    "Function not considered for JIT compilation because its bytecode is too large ({} > {} bytes)",
+			    bytecode_length * sizeof(asDWORD),
+			    max_bytecode_bytes);
+		} else if (!fn_config.ignore_perf_warnings) {
 			log(m_config,
 			    *m_engine,
 			    *fn.script_function,
 			    LogSeverity::ASEA_WARNING,
-			    "Function not considered for JIT compilation because it is too complex");
+			    "Function not considered for JIT compilation because it is too complex (estimated cost {:.0f} > "
+			    "{:.0f}; {} instructions, {} branch targets, {} switch cases, {} calls, {} allocations, {} variable "
+			    "slots)",
+			    cost_estimate.cost,
+			    m_config.compile_cost.max_cost,
+			    cost_estimate.instruction_count,
+			    cost_estimate.branch_target_count,
+			    cost_estimate.switch_case_count,
+			    cost_estimate.call_count,
+			    cost_estimate.allocation_count,
+			    cost_estimate.variable_count);
 		}
 		setup_jit_callback(*fn.script_function, nullptr, nullptr, true);
 		m_lazy_functions.erase(fn.script_function);
 		return false;
 	}
 
-	// TODO: b2c in thread as well
-	m_c_generator.prepare_new_context();
-	m_c_generator.set_map_extern_callback([&](const char*                                        c_name,
-	                                          [[maybe_unused]] const BytecodeToC::ExternMapping& mapping,
-	                                          void* raw_value) { deferred_bindings.emplace_back(c_name, raw_value); });
-	m_c_generator.translate_function(name, *fn.script_function, fn_config);
-
-	if (m_c_generator.get_fallback_count() > 0) {
-		log(config(),
-		    engine(),
-		    LogSeverity::ASEA_PERF_HINT,
-		    "Number of fallbacks for module \"{}\": {}",
-		    name,
-		    m_c_generator.get_fallback_count());
+	std::unique_ptr<Mir> direct_mir;
+	if (m_config.experimental_direct_mir && m_mir_generator.can_translate(*fn.script_function)) {
+		direct_mir = std::make_unique<Mir>();
+		m_mir_generator.configure_jit_entries(*fn.script_function);
+		c_name = m_mir_generator.translate_function(
+		    *direct_mir,
+		    *fn.script_function,
+		    m_c_generator.uses_shadow_call_stack()
+		);
+	} else {
+		// TODO: b2c in thread as well
+		m_c_generator.prepare_new_context();
+		m_c_generator.set_map_extern_callback(
+		    [&](const char* c_name, const BytecodeToC::ExternMapping& mapping, void* raw_value) {
+			    if (std::holds_alternative<BytecodeToC::ExternMethodCache>(mapping)) {
+				    raw_value = m_method_caches[fn.script_function]
+				                    .emplace_back(std::make_unique<asea_method_cache>())
+				                    .get();
+			    } else if (const auto* typed_entry = std::get_if<BytecodeToC::ExternTypedEntry>(&mapping)) {
+				    raw_value = get_typed_entry_slot(*typed_entry->fn);
+			    }
+			    deferred_bindings.emplace_back(c_name, raw_value);
+		    }
+		);
+		m_c_generator.translate_function(name, *fn.script_function, fn_config);
+
+		if (m_c_generator.get_fallback_count() > 0) {
+			log(config(),
+			    engine(),
+			    LogSeverity::ASEA_PERF_HINT,
+			    "Number of fallbacks for module \"{}\": {}",
+			    name,
+			    m_c_generator.get_fallback_count());
+		}
 	}
 
 	std::vector<std::pair<asPWORD*, asPWORD>> jit_entry_args;
@@ -263,20 +388,31 @@ bool MirJit::translate_lazy_function(LazyMirFunction& fn) {
 	auto [async_fn_it, success] = m_async_codegen_functions.try_emplace(
 	    fn.script_function,
 	    std::unique_ptr<AsyncMirFunction>{new AsyncMirFunction{
-	        .jit_engine        = this,
-	        .script_function   = fn.script_function,
-	        .jit_entry_args    = std::move(jit_entry_args),
-	        .deferred_bindings = std::move(deferred_bindings),
-	        .c_name            = c_name,
-	        .c_source          = m_c_generator.finalize_context(),
-	        .pretty_name       = name,
-	        .compiled          = {}
+	        .jit_engine         = this,
+	        .script_function    = fn.script_function,
+	        .jit_entry_args     = std::move(jit_entry_args),
+	        .deferred_bindings  = std::move(deferred_bindings),
+	        .c_name             = c_name,
+	        .typed_entry_c_name = std::move(typed_entry_c_name),
+	        .c_source           = direct_mir != nullptr ? TranspiledCode{} : m_c_generator.finalize_context(),
+	        .direct_mir         = std::move(direct_mir),
+	        .pretty_name        = name,
+	        .cost_estimate      = cost_estimate,
+	        .compiled           = {}
 	    }}
 	);
 	auto& async_fn = *async_fn_it->second;
 
 	if (config().debug.dump_c_code || (config().debug.allow_function_metadata_debug && fn_config.dump_c)) {
 		angelsea_assert(config().debug.dump_c_code_file != nullptr);
+		if (async_fn.direct_mir != nullptr) {
+			// there is no C to dump, but knowing which functions skipped it is still useful
+			const std::string note = fmt::format(
+			    "/* {}: translated directly to MIR */\n",
+			    fn.script_function->GetDeclaration(true, true, true)
+			);
+			std::ignore = fputs(note.c_str(), config().debug.dump_c_code_file);
+		}
 		for (const char* block : async_fn.c_source.source_bits) {
 			std::ignore = fputs(block, config().debug.dump_c_code_file);
 		}
@@ -306,43 +442,63 @@ bool MirJit::translate_lazy_function(LazyMirFunction& fn) {
 }
 
 void MirJit::codegen_async_function(AsyncMirFunction& fn) {
-	Mir compile_mir;
+	const auto compile_start = std::chrono::steady_clock::now();
+
+	// functions translated directly to MIR already come with their own context holding the module
+	const bool           is_direct_mir = fn.direct_mir != nullptr;
+	std::unique_ptr<Mir> compile_mir_storage
+	    = is_direct_mir ? std::move(fn.direct_mir) : std::make_unique<Mir>();
+	Mir& compile_mir = *compile_mir_storage;
 	{
-		C2Mir c2mir{compile_mir};
+		std::optional<C2Mir> c2mir;
+		if (!is_direct_mir) {
+			c2mir.emplace(compile_mir);
 
-		std::array macros{
-		    // Trigger the various definitions and macros of the generated header
-		    c2mir_macro_command{.def_p = int(true), .name = "ASEA_SUPPORT", .def = "1"},
+			std::array macros{
+			    // Trigger the various definitions and macros of the generated header
+			    c2mir_macro_command{.def_p = int(true), .name = "ASEA_SUPPORT", .def = "1"},
 #ifdef _MSC_VER
-		    c2mir_macro_command{.def_p = int(true), .name = "ASEA_ABI_MSVC", .def = "1"},
+			    c2mir_macro_command{.def_p = int(true), .name = "ASEA_ABI_MSVC", .def = "1"},
 #endif
-		};
-
-		c2mir_options c_options{
-		    .message_file       = config().debug.c2mir_diagnostic_file,
-		    .debug_p            = int(false),
-		    .verbose_p          = int(false),
-		    .ignore_warnings_p  = int(false),
-		    .no_prepro_p        = int(false),
-		    .prepro_only_p      = int(false),
-		    .syntax_only_p      = int(false),
-		    .pedantic_p         = int(false), // seems to break compile..?
-		    .asm_p              = int(false),
-		    .object_p           = int(false),
-		    .module_num         = 0, // ?
-		    .prepro_output_file = nullptr,
-		    .output_file_name   = nullptr,
-		    .macro_commands_num = macros.size(),
-		    .include_dirs_num   = 0,
-		    .macro_commands     = macros.data(),
-		    .include_dirs       = nullptr,
-		};
-
-		InputData input_data(fn.c_source);
-		if (c2mir_compile(compile_mir, &c_options, c2mir_getc_callback, &input_data, fn.pretty_name.c_str(), nullptr)
-		    == 0) {
-			log(config(), engine(), LogSeverity::ASEA_ERROR, "Failed to compile C for \"{}\"", fn.pretty_name.c_str());
-			angelsea_assert(false); // FIXME: error handling
+			};
+
+			c2mir_options c_options{
+			    .message_file       = config().debug.c2mir_diagnostic_file,
+			    .debug_p            = int(false),
+			    .verbose_p          = int(false),
+			    .ignore_warnings_p  = int(false),
+			    .no_prepro_p        = int(false),
+			    .prepro_only_p      = int(false),
+			    .syntax_only_p      = int(false),
+			    .pedantic_p         = int(false), // seems to break compile..?
+			    .asm_p              = int(false),
+			    .object_p           = int(false),
+			    .module_num         = 0, // ?
+			    .prepro_output_file = nullptr,
+			    .output_file_name   = nullptr,
+			    .macro_commands_num = macros.size(),
+			    .include_dirs_num   = 0,
+			    .macro_commands     = macros.data(),
+			    .include_dirs       = nullptr,
+			};
+
+			InputData input_data(fn.c_source);
+			if (c2mir_compile(
+			        compile_mir,
+			        &c_options,
+			        c2mir_getc_callback,
+			        &input_data,
+			        fn.pretty_name.c_str(),
+			        nullptr
+			    )
+			    == 0) {
+				log(config(),
+				    engine(),
+				    LogSeverity::ASEA_ERROR,
+				    "Failed to compile C for \"{}\"",
+				    fn.pretty_name.c_str());
+				angelsea_assert(false); // FIXME: error handling
+			}
 		}
 
 		fn.compiled.module = DLIST_TAIL(MIR_module_t, *MIR_get_module_list(compile_mir));
@@ -368,13 +524,18 @@ void MirJit::codegen_async_function(AsyncMirFunction& fn) {
 			MIR_load_module(m_mir, fn.compiled.module);
 
 			MIR_item_t mir_entry_fn;
-			bool       found = false;
+			MIR_item_t mir_typed_entry_fn = nullptr;
+			bool       found              = false;
 			for (MIR_item_t mir_fn = DLIST_HEAD(MIR_item_t, fn.compiled.module->items); mir_fn != nullptr;
 			     mir_fn            = DLIST_NEXT(MIR_item_t, mir_fn)) {
-				if (mir_fn->item_type == MIR_func_item && std::string_view{mir_fn->u.func->name} == fn.c_name) {
+				if (mir_fn->item_type != MIR_func_item) {
+					continue;
+				}
+				if (std::string_view{mir_fn->u.func->name} == fn.c_name) {
 					found        = true;
 					mir_entry_fn = mir_fn;
-					break;
+				} else if (std::string_view{mir_fn->u.func->name} == fn.typed_entry_c_name) {
+					mir_typed_entry_fn = mir_fn;
 				}
 			}
 
@@ -399,6 +560,7 @@ void MirJit::codegen_async_function(AsyncMirFunction& fn) {
 			MIR_link(m_mir, MIR_set_gen_interface, nullptr);
 
 			fn.compiled.jit_function = std::bit_cast<asJITFunction>(MIR_gen(m_mir, mir_entry_fn));
+			fn.compiled.typed_entry  = mir_typed_entry_fn != nullptr ? MIR_gen(m_mir, mir_typed_entry_fn) : nullptr;
 
 			if (config().debug.dump_mir_code) {
 				angelsea_assert(config().debug.dump_mir_code_file != nullptr);
@@ -407,6 +569,27 @@ void MirJit::codegen_async_function(AsyncMirFunction& fn) {
 
 			MIR_gen_finish(m_mir);
 
+			if (config().compile_cost.log_calibration) {
+				const auto compile_time = std::chrono::duration_cast<std::chrono::microseconds>(
+				    std::chrono::steady_clock::now() - compile_start
+				);
+				log(config(),
+				    engine(),
+				    LogSeverity::ASEA_VERBOSE,
+				    "Compiled \"{}\" in {}us (estimated cost {:.0f}, {:.3f}us per unit; {} instructions, {} branch "
+				    "targets, {} switch cases, {} calls, {} allocations, {} variable slots)",
+				    fn.pretty_name,
+				    compile_time.count(),
+				    fn.cost_estimate.cost,
+				    fn.cost_estimate.cost > 0.0 ? double(compile_time.count()) / fn.cost_estimate.cost : 0.0,
+				    fn.cost_estimate.instruction_count,
+				    fn.cost_estimate.branch_target_count,
+				    fn.cost_estimate.switch_case_count,
+				    fn.cost_estimate.call_count,
+				    fn.cost_estimate.allocation_count,
+				    fn.cost_estimate.variable_count);
+			}
+
 			if (config().hack_mir_minimize) {
 				MIR_minimize_module(m_mir, fn.compiled.module);
 				MIR_minimize(m_mir);
@@ -452,12 +635,28 @@ void MirJit::link_function(AsyncMirFunction& fn) {
 		*ptr = arg;
 	}
 
+	// from now on, other functions may call the typed entry point directly
+	if (fn.compiled.typed_entry != nullptr) {
+		std::atomic_ref{*get_typed_entry_slot(*fn.script_function)}.store(
+		    fn.compiled.typed_entry,
+		    std::memory_order_release
+		);
+	}
+
 	m_ignore_unregister             = fn.script_function;
 	[[maybe_unused]] const auto err = fn.script_function->SetJITFunction(fn.compiled.jit_function);
 	angelsea_assert(err == asSUCCESS);
 	m_ignore_unregister = nullptr;
 }
 
+void** MirJit::get_typed_entry_slot(asIScriptFunction& script_function) {
+	auto& slot = m_typed_entry_slots[&script_function];
+	if (slot == nullptr) {
+		slot = std::make_unique<void*>(nullptr);
+	}
+	return slot.get();
+}
+
 void MirJit::setup_jit_callback(asIScriptFunction& function, asJITFunction callback, void* ud, bool ignore_unregister) {
 	for (InsRef ins : get_bytecode(function)) {
 		if (ins.opcode() == asBC_JitEntry) {
@@ -474,6 +673,19 @@ void MirJit::setup_jit_callback(asIScriptFunction& function, asJITFunction callb
 	}
 }
 
+FnConfig MirJit::get_fn_config(asIScriptFunction& script_function) {
+	if (auto it = m_fn_configs.find(&script_function); it != m_fn_configs.end()) {
+		return it->second;
+	}
+
+	// the function may not be registered yet, e.g. if it is declared later in the module of the caller
+	if (!m_fn_config_manual_discovery && m_request_fn_config_callback) {
+		return m_request_fn_config_callback(script_function);
+	}
+
+	return {};
+}
+
 void MirJit::discover_fn_config() {
 	if (!m_request_fn_config_callback) {
 		return;
@@ -484,7 +696,8 @@ void MirJit::discover_fn_config() {
 			continue;
 		}
 
-		lazy_fn.fn_config = m_request_fn_config_callback(*script_fn);
+		lazy_fn.fn_config       = m_request_fn_config_callback(*script_fn);
+		m_fn_configs[script_fn] = *lazy_fn.fn_config;
 	}
 
 	if (m_config.triggers.eager) {
@@ -2,23 +2,59 @@
 
 #include <angelsea/detail/runtime.hpp>
 
+#include <algorithm>
 #include <angelscript.h>
 #include <angelsea/detail/debug.hpp>
 #include <as_context.h>
 #include <as_memory.h>
+#include <as_module.h>
 #include <as_objecttype.h>
 #include <as_scriptengine.h>
 #include <as_scriptfunction.h>
 #include <as_scriptobject.h>
 #include <as_texts.h>
+#include <atomic>
 #include <bit>
+#include <cmath>
+#include <cstring>
 #include <fmt/core.h>
+#include <mutex>
+#include <string>
 
 static asCContext&      asea_get_context(asSVMRegisters* regs) { return static_cast<asCContext&>(*regs->ctx); }
 static asCScriptEngine& asea_get_engine(asSVMRegisters* regs) {
 	return static_cast<asCScriptEngine&>(*asea_get_context(regs).GetEngine());
 }
 
+template<class Ret>
+static Ret asea_call_native_guarded_common(asSVMRegisters* vm_registers, void* fn, const asQWORD* args, int arg_count) {
+	using Q = asQWORD;
+	try {
+		switch (arg_count) {
+		case 0: return std::bit_cast<Ret (*)()>(fn)();
+		case 1: return std::bit_cast<Ret (*)(Q)>(fn)(args[0]);
+		case 2: return std::bit_cast<Ret (*)(Q, Q)>(fn)(args[0], args[1]);
+		case 3: return std::bit_cast<Ret (*)(Q, Q, Q)>(fn)(args[0], args[1], args[2]);
+		case 4: return std::bit_cast<Ret (*)(Q, Q, Q, Q)>(fn)(args[0], args[1], args[2], args[3]);
+		case 5: return std::bit_cast<Ret (*)(Q, Q, Q, Q, Q)>(fn)(args[0], args[1], args[2], args[3], args[4]);
+		case 6:
+			return std::bit_cast<Ret (*)(Q, Q, Q, Q, Q, Q)>(fn)(args[0], args[1], args[2], args[3], args[4], args[5]);
+		case 7:
+			return std::bit_cast<Ret (*)(Q, Q, Q, Q, Q, Q, Q)>(
+			    fn
+			)(args[0], args[1], args[2], args[3], args[4], args[5], args[6]);
+		case 8:
+			return std::bit_cast<Ret (*)(Q, Q, Q, Q, Q, Q, Q, Q)>(
+			    fn
+			)(args[0], args[1], args[2], args[3], args[4], args[5], args[6], args[7]);
+		default: angelsea_assert(false && "rejected when emitting the call"); return Ret{};
+		}
+	} catch (...) {
+		asea_get_context(vm_registers).HandleAppException();
+	}
+	return Ret{};
+}
+
 extern "C" {
 void asea_call_script_function(asSVMRegisters* vm_registers, asCScriptFunction& fn) {
 	asea_get_context(vm_registers).CallScriptFunction(&fn);
@@ -28,6 +64,26 @@ int asea_call_system_function(asSVMRegisters* vm_registers, int fn) {
 	return CallSystemFunction(fn, &asea_get_context(vm_registers));
 }
 
+void asea_call_generic_guarded(asSVMRegisters* vm_registers, asGENFUNC_t fn, asIScriptGeneric* generic) {
+	try {
+		fn(generic);
+	} catch (...) {
+		asea_get_context(vm_registers).HandleAppException();
+	}
+}
+
+asQWORD asea_call_native_guarded(asSVMRegisters* vm_registers, void* fn, const asQWORD* args, int arg_count) {
+	return asea_call_native_guarded_common<asQWORD>(vm_registers, fn, args, arg_count);
+}
+
+float asea_call_native_guarded_f32(asSVMRegisters* vm_registers, void* fn, const asQWORD* args, int arg_count) {
+	return asea_call_native_guarded_common<float>(vm_registers, fn, args, arg_count);
+}
+
+double asea_call_native_guarded_f64(asSVMRegisters* vm_registers, void* fn, const asQWORD* args, int arg_count) {
+	return asea_call_native_guarded_common<double>(vm_registers, fn, args, arg_count);
+}
+
 void asea_call_object_method(asSVMRegisters* vm_registers, void* obj, int fn) {
 	asea_get_engine(vm_registers).CallObjectMethod(obj, fn);
 }
@@ -41,7 +97,8 @@ inline int asea_prepare_script_stack_common(
     asCScriptFunction& fn,
     asDWORD*           pc,
     asDWORD*           sp,
-    asDWORD*           fp
+    asDWORD*           fp,
+    asea_shadow_frame* shadow_frame
 ) {
 	asCContext& ctx = asea_get_context(vm_registers);
 
@@ -49,19 +106,42 @@ inline int asea_prepare_script_stack_common(
 	auto& callstack   = ctx.m_callStack;
 	auto& script_data = *fn.scriptData;
 
-	// update stack size if needed
-	asUINT old_length = callstack.GetLength();
-	if (old_length >= callstack.GetCapacity()) [[unlikely]] {
-		if (engine.ep.maxCallStackSize > 0 && old_length >= engine.ep.maxCallStackSize * CALLSTACK_FRAME_SIZE) {
-			// the call stack is too big to grow further
+	asPWORD* target;
+
+	if (shadow_frame != nullptr) {
+		// same limit as below, counting the shadow frames that would be pushed along with this one
+		if (engine.ep.maxCallStackSize > 0
+		    && callstack.GetLength() + (shadow_frame->depth * CALLSTACK_FRAME_SIZE)
+		           > engine.ep.maxCallStackSize * CALLSTACK_FRAME_SIZE) [[unlikely]] {
+			// as with the regular call stack, the frame is not pushed, but the callers must be visible to the
+			// exception. marking the frame as materialized makes the caller skip it.
+			asea_materialize_shadow_frames(vm_registers, shadow_frame->parent);
+			shadow_frame->materialized = 1;
+
+			// the exception is raised past the call instruction of the caller, as in the VM
+			vm_registers->programPointer = pc;
+			vm_registers->stackPointer   = sp;
 			ctx.SetInternalException(TXT_STACK_OVERFLOW);
 			return 1;
 		}
-		callstack.AllocateNoConstruct(old_length + (10 * CALLSTACK_FRAME_SIZE), true);
-	}
-	callstack.SetLengthNoAllocate(old_length + CALLSTACK_FRAME_SIZE);
 
-	asPWORD* target = callstack.AddressOf() + old_length;
+		// the call stack is left untouched, see asea_materialize_shadow_frames
+		target = shadow_frame->state;
+	} else {
+		// update stack size if needed
+		asUINT old_length = callstack.GetLength();
+		if (old_length >= callstack.GetCapacity()) [[unlikely]] {
+			if (engine.ep.maxCallStackSize > 0 && old_length >= engine.ep.maxCallStackSize * CALLSTACK_FRAME_SIZE) {
+				// the call stack is too big to grow further
+				ctx.SetInternalException(TXT_STACK_OVERFLOW);
+				return 1;
+			}
+			callstack.AllocateNoConstruct(old_length + (10 * CALLSTACK_FRAME_SIZE), true);
+		}
+		callstack.SetLengthNoAllocate(old_length + CALLSTACK_FRAME_SIZE);
+
+		target = callstack.AddressOf() + old_length;
+	}
 
 	// store call state
 	target[0] = std::bit_cast<asPWORD>(fp);
@@ -108,7 +188,7 @@ int asea_prepare_script_stack(
     asDWORD*           sp,
     asDWORD*           fp
 ) {
-	return asea_prepare_script_stack_common(vm_registers, fn, pc, sp, fp);
+	return asea_prepare_script_stack_common(vm_registers, fn, pc, sp, fp, nullptr);
 }
 
 int asea_prepare_script_stack_and_vars(
@@ -118,7 +198,7 @@ int asea_prepare_script_stack_and_vars(
     asDWORD*           sp,
     asDWORD*           fp
 ) {
-	if (asea_prepare_script_stack_common(vm_registers, fn, pc, sp, fp) != 0) {
+	if (asea_prepare_script_stack_common(vm_registers, fn, pc, sp, fp, nullptr) != 0) {
 		return 1;
 	}
 
@@ -127,6 +207,146 @@ int asea_prepare_script_stack_and_vars(
 	return 0;
 }
 
+int asea_prepare_script_stack_shadow(
+    asSVMRegisters*    vm_registers,
+    asCScriptFunction& fn,
+    asDWORD*           pc,
+    asDWORD*           sp,
+    asDWORD*           fp,
+    asea_shadow_frame* frame,
+    asea_shadow_frame* parent
+) {
+	frame->parent       = parent;
+	frame->materialized = 0;
+	frame->depth        = parent != nullptr && parent->materialized == 0 ? parent->depth + 1 : 1;
+	return asea_prepare_script_stack_common(vm_registers, fn, pc, sp, fp, frame);
+}
+
+int asea_prepare_script_stack_shadow_and_vars(
+    asSVMRegisters*    vm_registers,
+    asCScriptFunction& fn,
+    asDWORD*           pc,
+    asDWORD*           sp,
+    asDWORD*           fp,
+    asea_shadow_frame* frame,
+    asea_shadow_frame* parent
+) {
+	frame->parent       = parent;
+	frame->materialized = 0;
+	frame->depth        = parent != nullptr && parent->materialized == 0 ? parent->depth + 1 : 1;
+	if (asea_prepare_script_stack_common(vm_registers, fn, pc, sp, fp, frame) != 0) {
+		return 1;
+	}
+
+	memset(vm_registers->stackPointer, 0, fn.scriptData->variableSpace * sizeof(asDWORD));
+
+	return 0;
+}
+
+void asea_materialize_shadow_frames(asSVMRegisters* vm_registers, asea_shadow_frame* frame) {
+	asUINT frame_count = 0;
+	for (asea_shadow_frame* it = frame; it != nullptr && it->materialized == 0; it = it->parent) {
+		++frame_count;
+	}
+
+	if (frame_count == 0) {
+		return;
+	}
+
+	// NOTE: maxCallStackSize is not enforced here: we cannot raise an exception from an arbitrary point, and the
+	// stack size limit is still enforced by ReserveStackSpace
+	auto&  callstack  = asea_get_context(vm_registers).m_callStack;
+	asUINT old_length = callstack.GetLength();
+	asUINT new_length = old_length + (frame_count * CALLSTACK_FRAME_SIZE);
+	if (new_length > callstack.GetCapacity()) {
+		callstack.AllocateNoConstruct(new_length + (10 * CALLSTACK_FRAME_SIZE), true);
+	}
+	callstack.SetLengthNoAllocate(new_length);
+
+	// the list goes from the innermost call to the outermost one, so fill the call stack from the top
+	asPWORD* target = callstack.AddressOf() + new_length;
+	for (asea_shadow_frame* it = frame; frame_count > 0; it = it->parent, --frame_count) {
+		target -= CALLSTACK_FRAME_SIZE;
+		std::memcpy(target, it->state, sizeof(it->state));
+		it->materialized = 1;
+	}
+}
+
+int asea_remaining_call_depth(asSVMRegisters* vm_registers, asea_shadow_frame* shadow, int max_depth) {
+	const asUINT max_call_stack_size = asea_get_engine(vm_registers).ep.maxCallStackSize;
+	if (max_call_stack_size == 0) {
+		return max_depth;
+	}
+
+	// same condition as the overflow check of asea_prepare_script_stack_common
+	asUINT frame_count = asea_get_context(vm_registers).m_callStack.GetLength() / CALLSTACK_FRAME_SIZE;
+	if (shadow != nullptr && shadow->materialized == 0) {
+		frame_count += shadow->depth;
+	}
+	if (frame_count >= max_call_stack_size) {
+		return 0;
+	}
+
+	return int(std::min<asUINT>(max_call_stack_size - frame_count, asUINT(max_depth)));
+}
+
+asQWORD
+asea_call_script_nested(asSVMRegisters* vm_registers, asea_typed_call* call, asCScriptFunction* fn, asDWORD* args) {
+	asCContext& ctx = asea_get_context(vm_registers);
+
+	// the nested state is pushed on top of the outermost caller, whose frame must be complete
+	asea_materialize_shadow_frames(vm_registers, call->shadow);
+	vm_registers->programPointer = call->pc;
+	vm_registers->stackPointer   = call->sp;
+
+	if (ctx.PushState() < 0) {
+		ctx.SetInternalException(TXT_STACK_OVERFLOW);
+		call->failed = 1;
+		return 0;
+	}
+
+	asQWORD ret       = 0;
+	bool    suspended = false;
+	int     status    = ctx.Prepare(fn);
+	if (status >= 0) {
+		// typed entries only take primitives, and never take an object pointer or return on the stack
+		if (const int arg_space = fn->GetSpaceNeededForArguments(); arg_space > 0) {
+			std::memcpy(ctx.GetAddressOfArg(0), args, arg_space * sizeof(asDWORD));
+		}
+		status = ctx.Execute();
+
+		// the nested state cannot be kept around once we return to the caller, so finish the call and suspend the
+		// caller instead
+		while (status == asEXECUTION_SUSPENDED) {
+			suspended = true;
+			status    = ctx.Execute();
+		}
+
+		if (const int return_size = fn->returnType.GetSizeInMemoryBytes();
+		    status == asEXECUTION_FINISHED && return_size > 0) {
+			std::memcpy(&ret, ctx.GetAddressOfReturnValue(), return_size);
+		}
+	}
+
+	// the exception of the nested state is lost when popping it
+	const std::string exception
+	    = status == asEXECUTION_EXCEPTION ? ctx.GetExceptionString() : "Nested script call did not finish";
+	ctx.PopState();
+
+	if (status == asEXECUTION_ABORTED) {
+		// the VM aborts the caller as soon as it checks for suspends
+		ctx.Abort();
+		call->failed = 1;
+	} else if (status != asEXECUTION_FINISHED) {
+		ctx.SetInternalException(exception.c_str());
+		call->failed = 1;
+	} else if (suspended) {
+		ctx.Suspend();
+	}
+
+	return ret;
+}
+
 void asea_debug_message(asSVMRegisters* vm_registers, const char* text) {
 	asea_get_engine(vm_registers).WriteMessage("<angelsea_debug>", 0, 0, asMSGTYPE_INFORMATION, text);
 }
@@ -146,6 +366,163 @@ void asea_set_internal_exception(asSVMRegisters* vm_registers, const char* text)
 	asea_get_context(vm_registers).SetInternalException(text);
 }
 
+int asea_process_suspend(asSVMRegisters* vm_registers) {
+	asCContext& ctx = asea_get_context(vm_registers);
+
+	if (ctx.m_lineCallback) {
+		ctx.CallLineCallback();
+	}
+
+	if (ctx.m_doSuspend) {
+		ctx.m_status = asEXECUTION_SUSPENDED;
+		return 1;
+	}
+
+	return 0;
+}
+
+int asea_check_call_status(asSVMRegisters* vm_registers) {
+	asCContext& ctx = asea_get_context(vm_registers);
+
+	if (ctx.m_doSuspend) {
+		ctx.m_status = asEXECUTION_SUSPENDED;
+		return 1;
+	}
+
+	return ctx.m_status != asEXECUTION_ACTIVE ? 1 : 0;
+}
+
+asCScriptFunction* asea_resolve_function_handle(asCScriptFunction* fn, void** delegate_object) {
+	*delegate_object = nullptr;
+
+	if (fn == nullptr) {
+		return nullptr;
+	}
+
+	switch (fn->funcType) {
+	case asFUNC_SCRIPT:
+	case asFUNC_SYSTEM:   return fn;
+	case asFUNC_DELEGATE: {
+		asCScriptFunction* method = fn->funcForDelegate;
+		// methods of final classes and final methods are not virtual, and are called as is, like system methods
+		if (method->funcType == asFUNC_VIRTUAL) {
+			// same as what asCContext::CallInterfaceMethod does for virtual methods
+			auto* obj = static_cast<asCScriptObject*>(fn->objForDelegate);
+			method    = obj->objType->virtualFunctionTable[method->vfTableIdx];
+		} else if (method->funcType != asFUNC_SCRIPT && method->funcType != asFUNC_SYSTEM) {
+			return nullptr;
+		}
+		*delegate_object = fn->objForDelegate;
+		return method;
+	}
+	default: return nullptr;
+	}
+}
+
+asCScriptFunction*
+asea_resolve_interface_method(asea_method_cache* cache, asCScriptObject* obj, asCScriptFunction* interface_fn) {
+	asCObjectType& type = *obj->objType;
+
+	// same as what asCContext::CallInterfaceMethod does
+	asCScriptFunction* method = nullptr;
+	for (asUINT i = 0; i < type.interfaces.GetLength(); ++i) {
+		if (type.interfaces[i] == interface_fn->objectType) {
+			method = type.virtualFunctionTable[interface_fn->vfTableIdx + type.interfaceVFTOffsets[i]];
+			break;
+		}
+	}
+
+	if (method == nullptr) {
+		return nullptr;
+	}
+
+	// misses are rare enough that serializing insertions across all caches is not a concern
+	static std::mutex         insertion_mutex;
+	const std::lock_guard     lk{insertion_mutex};
+	asea_method_cache_entry** slot = nullptr;
+	for (auto& entry : cache->entries) {
+		if (entry == nullptr) {
+			slot = slot != nullptr ? slot : &entry;
+		} else if (entry->type == &type) {
+			return method; // cached by another thread in the meantime
+		}
+	}
+
+	if (cache->allocation_count >= asea_method_cache_max_allocations) {
+		return method;
+	}
+
+	if (slot == nullptr) {
+		slot                 = &cache->entries[cache->next_replaced];
+		cache->next_replaced = (cache->next_replaced + 1) % asea_method_cache_size;
+	}
+
+	// the reference is released when the cache is, which prevents the address of a type that was destroyed in the
+	// meantime to be reused by a new type that would then match a stale entry
+	type.AddRef();
+	auto* entry = new asea_method_cache_entry{.type = &type, .fn = method, .next_allocated = cache->allocated};
+	cache->allocated = entry;
+	++cache->allocation_count;
+
+	std::atomic_ref{*slot}.store(entry, std::memory_order_release);
+
+	return method;
+}
+
+asCScriptFunction* asea_resolve_bound_function(asSVMRegisters* vm_registers, int import_id) {
+	asCScriptEngine& engine   = asea_get_engine(vm_registers);
+	const int        bound_id = engine.importedFunctions[import_id & ~FUNC_IMPORTED]->boundFunctionId;
+	return bound_id != -1 ? engine.scriptFunctions[bound_id] : nullptr;
+}
+
+int asea_powi(int base, int exponent, int* overflow) {
+	bool      is_overflow = false;
+	const int result      = as_powi(base, exponent, is_overflow);
+	*overflow             = int(is_overflow);
+	return result;
+}
+
+asDWORD asea_powu(asDWORD base, asDWORD exponent, int* overflow) {
+	bool          is_overflow = false;
+	const asDWORD result      = as_powu(base, exponent, is_overflow);
+	*overflow                 = int(is_overflow);
+	return result;
+}
+
+asINT64 asea_powi64(asINT64 base, asINT64 exponent, int* overflow) {
+	bool          is_overflow = false;
+	const asINT64 result      = as_powi64(base, exponent, is_overflow);
+	*overflow                 = int(is_overflow);
+	return result;
+}
+
+asQWORD asea_powu64(asQWORD base, asQWORD exponent, int* overflow) {
+	bool          is_overflow = false;
+	const asQWORD result      = as_powu64(base, exponent, is_overflow);
+	*overflow                 = int(is_overflow);
+	return result;
+}
+
+// the VM only reports overflow to +inf for floating-point exponentiation, which we match exactly
+
+float asea_powf(float base, float exponent, int* overflow) {
+	const float result = powf(base, exponent);
+	*overflow          = int(result == float(HUGE_VAL));
+	return result;
+}
+
+double asea_powd(double base, double exponent, int* overflow) {
+	const double result = pow(base, exponent);
+	*overflow           = int(result == HUGE_VAL);
+	return result;
+}
+
+double asea_powdi(double base, int exponent, int* overflow) {
+	const double result = pow(base, exponent);
+	*overflow           = int(result == HUGE_VAL);
+	return result;
+}
+
 void asea_clean_args(asSVMRegisters* vm_registers, asCScriptFunction& fn, asDWORD* args) {
 	asCScriptEngine& engine = asea_get_engine(vm_registers);
 
@@ -186,6 +563,10 @@ void* asea_new_script_object(asCObjectType* obj_type) {
 	return mem;
 }
 
+void asea_destroy_list(asSVMRegisters* vm_registers, void* list, asCObjectType* list_type) {
+	asea_get_engine(vm_registers).DestroyList(static_cast<asBYTE*>(list), list_type);
+}
+
 void* asea_alloc(asQWORD size) { return userAlloc(size); }
 
 void asea_free(void* ptr) { userFree(ptr); }
@@ -0,0 +1,109 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+#include <angelsea/intrinsics.hpp>
+#include <angelsea/jit.hpp>
+#include <as_callfunc.h>
+#include <as_scriptfunction.h>
+#include <bit>
+#include <fmt/format.h>
+#include <math.h>
+#include <string>
+
+namespace angelsea {
+
+namespace {
+
+/// A C math library function as registered by the `scriptmath` add-on, which has a `float` and a `double` variant.
+struct MathFunction {
+	const char* script_name;
+	int         param_count;
+
+	struct Variant {
+		const char* type;
+		const char* c_name;
+		void*       address;
+	};
+	Variant variants[2];
+};
+
+template<class T> void* math_fn_address(T (*fn)(T)) { return std::bit_cast<void*>(fn); }
+template<class T> void* math_fn_address(T (*fn)(T, T)) { return std::bit_cast<void*>(fn); }
+
+#define ASEA_MATH_FN(script_name, c_name, param_count)                                                                 \
+	MathFunction {                                                                                                     \
+		script_name, param_count, {                                                                                    \
+			{"float", #c_name "f", math_fn_address<float>(&::c_name##f)},                                              \
+			{"double", #c_name, math_fn_address<double>(&::c_name)},                                                   \
+		}                                                                                                              \
+	}
+
+const MathFunction script_math_functions[] = {
+    ASEA_MATH_FN("cos", cos, 1),
+    ASEA_MATH_FN("sin", sin, 1),
+    ASEA_MATH_FN("tan", tan, 1),
+    ASEA_MATH_FN("acos", acos, 1),
+    ASEA_MATH_FN("asin", asin, 1),
+    ASEA_MATH_FN("atan", atan, 1),
+    ASEA_MATH_FN("atan2", atan2, 2),
+    ASEA_MATH_FN("cosh", cosh, 1),
+    ASEA_MATH_FN("sinh", sinh, 1),
+    ASEA_MATH_FN("tanh", tanh, 1),
+    ASEA_MATH_FN("log", log, 1),
+    ASEA_MATH_FN("log10", log10, 1),
+    ASEA_MATH_FN("pow", pow, 2),
+    ASEA_MATH_FN("sqrt", sqrt, 1),
+    ASEA_MATH_FN("ceil", ceil, 1),
+    ASEA_MATH_FN("abs", fabs, 1),
+    ASEA_MATH_FN("floor", floor, 1),
+};
+
+#undef ASEA_MATH_FN
+
+} // namespace
+
+void register_script_math_intrinsics(Jit& jit, asIScriptEngine& engine) {
+	for (const MathFunction& math_fn : script_math_functions) {
+		for (const MathFunction::Variant& variant : math_fn.variants) {
+			const std::string params = math_fn.param_count == 1 ? fmt::format("{}", variant.type)
+			                                                    : fmt::format("{0}, {0}", variant.type);
+			const std::string decl   = fmt::format("{} {}({})", variant.type, math_fn.script_name, params);
+
+			// only replace the function if calling it is exactly equivalent to calling the C function
+			auto* fn = static_cast<asCScriptFunction*>(engine.GetGlobalFunctionByDecl(decl.c_str()));
+			if (fn == nullptr || fn->sysFuncIntf == nullptr || fn->sysFuncIntf->callConv != ICC_CDECL
+			    || std::bit_cast<void*>(fn->sysFuncIntf->func) != variant.address) {
+				continue;
+			}
+
+			jit.SetSystemFunctionIntrinsic(
+			    fn->GetId(),
+			    {.expression  = math_fn.param_count == 1 ? fmt::format("{}($0)", variant.c_name)
+			                                             : fmt::format("{}($0, $1)", variant.c_name),
+			     .definitions = fmt::format("{} {}({});", variant.type, variant.c_name, params),
+			     .symbols     = {{variant.c_name, variant.address}}}
+			);
+		}
+	}
+}
+
+namespace detail {
+
+void set_intrinsic_if_bound_to(
+    Jit&                    jit,
+    asIScriptFunction*      fn,
+    const asSFuncPtr&       method,
+    SystemFunctionIntrinsic intrinsic
+) {
+	// like for math functions, only replace methods that exactly call `method` on the script object
+	auto* script_fn = static_cast<asCScriptFunction*>(fn);
+	if (script_fn == nullptr || script_fn->sysFuncIntf == nullptr || script_fn->sysFuncIntf->callConv != ICC_THISCALL
+	    || script_fn->sysFuncIntf->baseOffset != 0 || script_fn->sysFuncIntf->func != method.ptr.f.func) {
+		return;
+	}
+
+	jit.SetSystemFunctionIntrinsic(script_fn->GetId(), std::move(intrinsic));
+}
+
+} // namespace detail
+
+} // namespace angelsea
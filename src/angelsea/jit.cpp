@@ -28,4 +28,12 @@ void Jit::SetFnConfigRequestCallback(std::function<FnConfig(asIScriptFunction&)>
 
 void Jit::DiscoverFnConfig() { m_compiler->discover_fn_config(); }
 
+void Jit::SetSystemFunctionTraits(int function_id, SystemFunctionTraits traits) {
+	m_compiler->set_system_function_traits(function_id, traits);
+}
+
+void Jit::SetSystemFunctionIntrinsic(int function_id, SystemFunctionIntrinsic intrinsic) {
+	m_compiler->set_system_function_intrinsic(function_id, std::move(intrinsic));
+}
+
 } // namespace angelsea
\ No newline at end of file
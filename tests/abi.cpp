@@ -8,7 +8,10 @@
 #include <as_datatype.h>
 #include <as_generic.h>
 #include <autowrapper/aswrappedcall.h>
+#include <cstdarg>
 #include <nanobench.h>
+#include <string>
+#include <string_view>
 
 struct SomeClass {
 	int a = 0;
@@ -16,6 +19,72 @@ struct SomeClass {
 	void add_obj(int x) { a += x; }
 };
 
+struct DoublePair {
+	double x, y;
+};
+
+struct ShortTriple {
+	short a, b, c;
+};
+
+struct PointFlags {
+	float x, y;
+	int   flags;
+};
+
+struct TimedId {
+	double t;
+	int    id;
+};
+
+struct RefCounted {
+	int refs = 1;
+
+	void add_ref() { ++refs; }
+	void release() { --refs; } // never freed, owned by the test
+};
+
+struct Component {
+	int value = 0;
+
+	int get_value() { return value; }
+};
+
+struct Entity {
+	int        id = 0;
+	Component  direct;
+	Component* indirect = nullptr;
+};
+
+/// Object that registered functions are called on, either as global functions or as methods of `Entity`
+struct EntityManager {
+	int scale = 0;
+
+	int add_scale(int x) { return x + scale; }
+	int scaled_objlast(int x, Entity* e) { return e->id * scale + x; }
+	int scaled_objfirst(Entity* e, int x) { return e->id * scale - x; }
+};
+
+struct BaseA {
+	virtual ~BaseA() = default;
+	int a            = 1;
+
+	int get_a() { return a; }
+};
+
+struct BaseB {
+	virtual ~BaseB() = default;
+	int b            = 2;
+
+	int         get_b() { return b; }
+	virtual int get_virtual_b() { return b * 10; }
+};
+
+/// `BaseB` is not at offset 0, so its methods need their `this` adjusted
+struct MultipleBases : BaseA, BaseB {
+	int get_virtual_b() override { return b * 100; }
+};
+
 struct NoisyClass {
 	NoisyClass() { out << "Con" << c; }
 	NoisyClass(const NoisyClass& other) { out << "Cpy" << c; }
@@ -29,6 +98,12 @@ struct NoisyClass {
 	}
 };
 
+NoisyClass objfirst_returning_complex_type(NoisyClass* self) {
+	NoisyClass ret;
+	ret.c = "objfirst";
+	return ret;
+}
+
 void generic_noarg(asIScriptGeneric* gen) {
 	// asCGeneric* g = static_cast<asCGeneric*>(gen);
 	gen->SetReturnDWord(123);
@@ -195,6 +270,20 @@ SomeClass ret_trivial_by_value() { return {.a = 69420}; }
 
 int pass_trivial_by_value(SomeClass a, SomeClass b) { return a.a + b.a; }
 
+DoublePair ret_double_pair(double x) { return {.x = x, .y = x * 2.0}; }
+
+double pass_double_pair(int scale, DoublePair p, float offset) { return (p.x + p.y) * scale + offset; }
+
+ShortTriple ret_short_triple(int a) { return {.a = short(a), .b = short(a + 1), .c = short(a + 2)}; }
+
+int pass_short_triples(ShortTriple t, ShortTriple u) { return t.a + t.b + t.c + u.a + u.b + u.c; }
+
+PointFlags ret_point_flags(float x) { return {.x = x, .y = x * 2.0f, .flags = 7}; }
+
+TimedId ret_timed_id(int id) { return {.t = id * 0.5, .id = id}; }
+
+double pass_mixed(PointFlags p, int scale, TimedId t) { return (p.x + p.y) * scale + p.flags + t.t * t.id; }
+
 std::string return_string(int a, int b, const std::string& c) {
 	std::string ret("hello world! ");
 	ret += std::to_string(a);
@@ -204,8 +293,72 @@ std::string return_string(int a, int b, const std::string& c) {
 	return ret;
 }
 
+std::string concat_by_value(std::string a, int b, std::string c) { return a + " " + std::to_string(b) + " " + c; }
+
 void native_destruct_noisy(NoisyClass* c) { c->~NoisyClass(); }
 
+void print_var(std::ostream& stream, void* ref, int type_id) {
+	if (type_id == asTYPEID_INT32) {
+		stream << *static_cast<int*>(ref);
+	} else if (type_id == asTYPEID_DOUBLE) {
+		stream << *static_cast<double*>(ref);
+	} else {
+		stream << '?';
+	}
+}
+
+std::string describe_var(int prefix, void* ref, int type_id, float suffix) {
+	std::stringstream ss;
+	ss << prefix << ':';
+	print_var(ss, ref, type_id);
+	ss << ':' << suffix;
+	return ss.str();
+}
+
+/// Prints the variadic `?` arguments following `count`, and returns their count.
+int print_vars(int prefix, asUINT count, ...) {
+	std::va_list args;
+	va_start(args, count);
+	out << prefix << ':';
+	for (asUINT i = 0; i < count; ++i) {
+		void*     ref     = va_arg(args, void*);
+		const int type_id = va_arg(args, int);
+		out << (i != 0 ? "," : "");
+		print_var(out, ref, type_id);
+	}
+	out << '\n';
+	va_end(args);
+	return int(count);
+}
+
+void print_vars_generic(asIScriptGeneric* gen) {
+	out << gen->GetArgDWord(0) << ':';
+	for (int i = 1; i < gen->GetArgCount(); ++i) {
+		out << (i != 1 ? "," : "");
+		print_var(out, gen->GetArgAddress(i), gen->GetArgTypeId(i));
+	}
+	out << '\n';
+	gen->SetReturnDWord(gen->GetArgCount() - 1);
+}
+
+Entity        shared_entity;
+EntityManager shared_entity_manager;
+MultipleBases shared_multiple_bases;
+
+void callback_target() { out << "called\n"; }
+
+asIScriptFunction* get_callback() {
+	asIScriptFunction* fn = asGetActiveContext()->GetEngine()->GetGlobalFunctionByDecl("void callback_target()");
+	fn->AddRef();
+	return fn;
+}
+
+RefCounted shared_ref_counted;
+
+RefCounted* get_shared_auto_handle() { return &shared_ref_counted; }
+
+int peek_refs_auto_handle(RefCounted* r) { return r->refs; }
+
 void bind_native_functions(asIScriptEngine& e) {
 	e.RegisterGlobalFunction("int noarg()", asFUNCTION(native_noarg), asCALL_CDECL);
 	e.RegisterGlobalFunction("int sum3int(int, int, int)", asFUNCTION(native_sum3int), asCALL_CDECL);
@@ -231,6 +384,56 @@ void bind_native_functions(asIScriptEngine& e) {
 	    asCALL_CDECL
 	);
 
+	e.RegisterObjectType(
+	    "DoublePair",
+	    sizeof(DoublePair),
+	    asOBJ_VALUE | asOBJ_POD | asOBJ_APP_CLASS_ALLFLOATS | asOBJ_APP_CLASS_ALIGN8 | asGetTypeTraits<DoublePair>()
+	);
+	e.RegisterObjectProperty("DoublePair", "double x", asOFFSET(DoublePair, x));
+	e.RegisterObjectProperty("DoublePair", "double y", asOFFSET(DoublePair, y));
+	e.RegisterGlobalFunction("DoublePair ret_double_pair(double x)", asFUNCTION(ret_double_pair), asCALL_CDECL);
+	e.RegisterGlobalFunction(
+	    "double pass_double_pair(int scale, DoublePair p, float offset)",
+	    asFUNCTION(pass_double_pair),
+	    asCALL_CDECL
+	);
+
+	e.RegisterObjectType(
+	    "ShortTriple",
+	    sizeof(ShortTriple),
+	    asOBJ_VALUE | asOBJ_POD | asOBJ_APP_CLASS_ALLINTS | asGetTypeTraits<ShortTriple>()
+	);
+	e.RegisterObjectProperty("ShortTriple", "int16 a", asOFFSET(ShortTriple, a));
+	e.RegisterObjectProperty("ShortTriple", "int16 b", asOFFSET(ShortTriple, b));
+	e.RegisterObjectProperty("ShortTriple", "int16 c", asOFFSET(ShortTriple, c));
+	e.RegisterGlobalFunction("ShortTriple ret_short_triple(int a)", asFUNCTION(ret_short_triple), asCALL_CDECL);
+	e.RegisterGlobalFunction(
+	    "int pass_short_triples(ShortTriple t, ShortTriple u)",
+	    asFUNCTION(pass_short_triples),
+	    asCALL_CDECL
+	);
+
+	e.RegisterObjectType("PointFlags", sizeof(PointFlags), asOBJ_VALUE | asOBJ_POD | asGetTypeTraits<PointFlags>());
+	e.RegisterObjectProperty("PointFlags", "float x", asOFFSET(PointFlags, x));
+	e.RegisterObjectProperty("PointFlags", "float y", asOFFSET(PointFlags, y));
+	e.RegisterObjectProperty("PointFlags", "int flags", asOFFSET(PointFlags, flags));
+	e.RegisterGlobalFunction("PointFlags ret_point_flags(float x)", asFUNCTION(ret_point_flags), asCALL_CDECL);
+
+	e.RegisterObjectType(
+	    "TimedId",
+	    sizeof(TimedId),
+	    asOBJ_VALUE | asOBJ_POD | asOBJ_APP_CLASS_ALIGN8 | asGetTypeTraits<TimedId>()
+	);
+	e.RegisterObjectProperty("TimedId", "double t", asOFFSET(TimedId, t));
+	e.RegisterObjectProperty("TimedId", "int id", asOFFSET(TimedId, id));
+	e.RegisterGlobalFunction("TimedId ret_timed_id(int id)", asFUNCTION(ret_timed_id), asCALL_CDECL);
+
+	e.RegisterGlobalFunction(
+	    "double pass_mixed(PointFlags p, int scale, TimedId t)",
+	    asFUNCTION(pass_mixed),
+	    asCALL_CDECL
+	);
+
 	// TODO: cdecl behs?
 	e.RegisterObjectType("NoisyClass", sizeof(NoisyClass), asOBJ_VALUE | asGetTypeTraits<NoisyClass>());
 	e.RegisterObjectBehaviour("NoisyClass", asBEHAVE_CONSTRUCT, "void f()", WRAP_CON(NoisyClass, ()), asCALL_GENERIC);
@@ -254,9 +457,107 @@ void bind_native_functions(asIScriptEngine& e) {
 	    asMETHOD(NoisyClass, thiscall_returning_complex_type),
 	    asCALL_THISCALL
 	);
+	e.RegisterObjectMethod(
+	    "NoisyClass",
+	    "NoisyClass objfirst_returning_complex_type()",
+	    asFUNCTION(objfirst_returning_complex_type),
+	    asCALL_CDECL_OBJFIRST
+	);
 
 	e.RegisterGlobalFunction("void take_noisy(NoisyClass a, NoisyClass b)", asFUNCTION(take_noisy), asCALL_CDECL);
 
+	e.RegisterGlobalFunction(
+	    "string describe_var(int prefix, const ?&in value, float suffix)",
+	    asFUNCTION(describe_var),
+	    asCALL_CDECL
+	);
+
+	e.RegisterObjectType("Entity", 0, asOBJ_REF | asOBJ_NOCOUNT);
+	e.RegisterGlobalProperty("Entity entity", &shared_entity);
+	e.RegisterObjectMethod(
+	    "Entity",
+	    "int get_direct()",
+	    asMETHOD(Component, get_value),
+	    asCALL_THISCALL,
+	    nullptr,
+	    asOFFSET(Entity, direct),
+	    false
+	);
+	e.RegisterObjectMethod(
+	    "Entity",
+	    "int get_indirect()",
+	    asMETHOD(Component, get_value),
+	    asCALL_THISCALL,
+	    nullptr,
+	    asOFFSET(Entity, indirect),
+	    true
+	);
+	e.RegisterObjectMethod(
+	    "Entity",
+	    "int scaled_objlast(int x)",
+	    asMETHOD(EntityManager, scaled_objlast),
+	    asCALL_THISCALL_OBJLAST,
+	    &shared_entity_manager
+	);
+	e.RegisterObjectMethod(
+	    "Entity",
+	    "int scaled_objfirst(int x)",
+	    asMETHOD(EntityManager, scaled_objfirst),
+	    asCALL_THISCALL_OBJFIRST,
+	    &shared_entity_manager
+	);
+	e.RegisterGlobalFunction(
+	    "int add_scale(int x)",
+	    asMETHOD(EntityManager, add_scale),
+	    asCALL_THISCALL_ASGLOBAL,
+	    &shared_entity_manager
+	);
+
+	e.RegisterObjectType("MultipleBases", 0, asOBJ_REF | asOBJ_NOCOUNT);
+	e.RegisterGlobalProperty("MultipleBases multiple_bases", &shared_multiple_bases);
+	e.RegisterObjectMethod("MultipleBases", "int get_a()", asMETHODPR(MultipleBases, get_a, (), int), asCALL_THISCALL);
+	e.RegisterObjectMethod("MultipleBases", "int get_b()", asMETHODPR(MultipleBases, get_b, (), int), asCALL_THISCALL);
+	// pointer to the virtual method of `BaseB`, which adjusts `this` to that subobject before going through its vtable
+	e.RegisterObjectMethod(
+	    "MultipleBases",
+	    "int get_base_virtual_b()",
+	    asSMethodPtr<sizeof(void (MultipleBases::*)())>::Convert(
+	        static_cast<int (MultipleBases::*)()>(&BaseB::get_virtual_b)
+	    ),
+	    asCALL_THISCALL
+	);
+
+	e.RegisterFuncdef("void Callback()");
+	e.RegisterGlobalFunction("void callback_target()", asFUNCTION(callback_target), asCALL_CDECL);
+	e.RegisterGlobalFunction("Callback@ get_callback()", asFUNCTION(get_callback), asCALL_CDECL);
+
+	e.RegisterObjectType("RefCounted", 0, asOBJ_REF);
+	e.RegisterObjectBehaviour(
+	    "RefCounted",
+	    asBEHAVE_ADDREF,
+	    "void f()",
+	    asMETHOD(RefCounted, add_ref),
+	    asCALL_THISCALL
+	);
+	e.RegisterObjectBehaviour(
+	    "RefCounted",
+	    asBEHAVE_RELEASE,
+	    "void f()",
+	    asMETHOD(RefCounted, release),
+	    asCALL_THISCALL
+	);
+	e.RegisterGlobalFunction("RefCounted@+ get_shared_auto_handle()", asFUNCTION(get_shared_auto_handle), asCALL_CDECL);
+	e.RegisterGlobalFunction(
+	    "int peek_refs_auto_handle(RefCounted@+ r)",
+	    asFUNCTION(peek_refs_auto_handle),
+	    asCALL_CDECL
+	);
+	e.RegisterGlobalFunction(
+	    "string concat_by_value(string a, int b, string c)",
+	    asFUNCTION(concat_by_value),
+	    asCALL_CDECL
+	);
+
 	e.RegisterGlobalFunction(
 	    "int native_manyargs(int x0, int x1, int x2, int x3, int x4, int x5, int x6, int x7, int x8, float y1, "
 	    "float "
@@ -266,6 +567,29 @@ void bind_native_functions(asIScriptEngine& e) {
 	);
 }
 
+/// Whether every call to the system function `name` in the generated C code `code` was emitted as a direct call rather
+/// than falling back to the VM.
+bool emits_direct_system_call(const std::string& code, std::string_view name) {
+	constexpr std::string_view attempt_marker = "/* Attempt direct system call for `";
+
+	bool found = false;
+	for (std::size_t begin = code.find(attempt_marker); begin != std::string::npos;) {
+		const std::size_t decl_end = code.find("` */", begin);
+		const std::size_t end      = code.find(attempt_marker, begin + attempt_marker.size());
+
+		const std::string decl = code.substr(begin, decl_end - begin);
+		if (decl.find(std::string(name) + "(") != std::string::npos) {
+			if (code.substr(begin, end - begin).find("/* Fallback to VM call") != std::string::npos) {
+				return false;
+			}
+			found = true;
+		}
+
+		begin = end;
+	}
+	return found;
+}
+
 TEST_CASE("native calling convention", "[abi][conv_native]") {
 	EngineContext context;
 	bind_native_functions(*context.engine);
@@ -292,6 +616,12 @@ TEST_CASE("native calling convention return by value", "[abi][conv_native]") {
 	bind_native_functions(*context.engine);
 
 	REQUIRE(run_string(context, "print(''+ret_trivial_by_value().a)") == "69420\n");
+
+	// returned in two SSE registers
+	REQUIRE(run_string(context, "DoublePair p = ret_double_pair(1.5); print(''+p.x+','+p.y)") == "1.5,3\n");
+
+	// packed into one integer register
+	REQUIRE(run_string(context, "ShortTriple t = ret_short_triple(10); print(''+t.a+','+t.b+','+t.c)") == "10,11,12\n");
 }
 
 TEST_CASE("native calling convention pass by value", "[abi][conv_native]") {
@@ -303,10 +633,49 @@ TEST_CASE("native calling convention pass by value", "[abi][conv_native]") {
 	    == "579\n"
 	);
 
+	REQUIRE(
+	    run_string(context, "DoublePair p; p.x = 0.5; p.y = 1.0; print(''+pass_double_pair(4, p, 0.25));") == "6.25\n"
+	);
+	REQUIRE(
+	    run_string(
+	        context,
+	        "ShortTriple t; t.a = 1; t.b = 2; t.c = 3; ShortTriple u; u.a = 10; u.b = 20; u.c = 30;"
+	        "print(''+pass_short_triples(t, u));"
+	    )
+	    == "66\n"
+	);
+
 	// involves cleanargs
 	REQUIRE(run_string(context, "take_noisy(NoisyClass(), NoisyClass());") == "ConCpyDesConCpyDesDesDes");
 }
 
+TEST_CASE("native calling convention mixed members by value", "[abi][conv_native]") {
+	angelsea::JitConfig config = get_test_jit_config();
+	GeneratedCCapture   c_code(config);
+
+	EngineContext context(config);
+	bind_native_functions(*context.engine);
+
+	// one SSE eightbyte for the floats and one INTEGER eightbyte for the int
+	REQUIRE(
+	    run_string(context, "PointFlags p = ret_point_flags(1.5); print(''+p.x+','+p.y+','+p.flags)") == "1.5,3,7\n"
+	);
+	REQUIRE(run_string(context, "TimedId t = ret_timed_id(3); print(''+t.t+','+t.id)") == "1.5,3\n");
+	REQUIRE(
+	    run_string(
+	        context,
+	        "PointFlags p; p.x = 0.5; p.y = 1.0; p.flags = 2; TimedId t; t.t = 0.25; t.id = 4;"
+	        "print(''+pass_mixed(p, 2, t));"
+	    )
+	    == "6\n"
+	);
+
+	// the dummy structs declare the registered members rather than falling back to the VM
+	const std::string code = c_code.take();
+	REQUIRE(code.find("float _0; float _4; asDWORD _8; }") != std::string::npos);
+	REQUIRE(code.find("double _0; asDWORD _8; }") != std::string::npos);
+}
+
 TEST_CASE("native calling convention complex return with thiscall", "[abi][conv_native]") {
 	EngineContext context;
 	bind_native_functions(*context.engine);
@@ -317,6 +686,156 @@ TEST_CASE("native calling convention complex return with thiscall", "[abi][conv_
 	REQUIRE(run_string(context, "NoisyClass().thiscall_returning_complex_type()") == "ConConDesDesret");
 }
 
+TEST_CASE("native calling convention complex types by value", "[abi][conv_native]") {
+	EngineContext context;
+	bind_native_functions(*context.engine);
+
+	// the return pointer goes before any argument, and complex arguments are passed by pointer among primitive ones
+	REQUIRE(run_string(context, "print(concat_by_value('hello', 42, 'world'))") == "hello 42 world\n");
+
+	// the return pointer goes before the object pointer, which is a regular argument for cdecl
+	REQUIRE(run_string(context, "NoisyClass().objfirst_returning_complex_type()") == "ConConDesDesobjfirst");
+}
+
+TEST_CASE("native calling convention variable types", "[abi][conv_native]") {
+	EngineContext context;
+	bind_native_functions(*context.engine);
+
+	// the reference and the type ID are passed as two arguments in between the other ones
+	REQUIRE(
+	    run_string(
+	        context,
+	        "print(describe_var(1, 42, 0.5)); print(describe_var(2, 1.5, 1.0)); print(describe_var(3, 'str', 2.0));"
+	    )
+	    == "1:42:0.5\n2:1.5:1\n3:?:2\n"
+	);
+}
+
+TEST_CASE("variadic functions", "[abi][conv_native][conv_generic]") {
+	angelsea::JitConfig config = get_test_jit_config();
+	GeneratedCCapture   c_code(config);
+
+	EngineContext context(config);
+	REQUIRE(
+	    context.engine
+	        ->RegisterGlobalFunction("int print_vars(int, const ?&in ...)", asFUNCTION(print_vars), asCALL_CDECL)
+	    >= 0
+	);
+	REQUIRE(
+	    context.engine->RegisterGlobalFunction(
+	        "int print_vars_generic(int, const ?&in ...)",
+	        asFUNCTION(print_vars_generic),
+	        asCALL_GENERIC
+	    )
+	    >= 0
+	);
+
+	// the count and the reference and type ID pairs follow the fixed arguments
+	REQUIRE(
+	    run_string(context, "print(print_vars(1, 42, 0.5, 'str')); print(print_vars(2));")
+	    == "1:42,0.5,?\n3\n2:\n0\n"
+	);
+	REQUIRE(run_string(context, "print(print_vars_generic(3, 7, 1.5));") == "3:7,1.5\n2\n");
+
+	// native calls declare the variadic argument list rather than falling back to the VM
+	CHECK(c_code.take().find(",...);") != std::string::npos);
+}
+
+TEST_CASE("native calling convention composite members", "[abi][conv_native]") {
+	angelsea::JitConfig config = get_test_jit_config();
+	GeneratedCCapture   c_code(config);
+
+	EngineContext context(config);
+	bind_native_functions(*context.engine);
+
+	static Component indirect{.value = 456};
+	shared_entity.direct.value = 123;
+	shared_entity.indirect     = &indirect;
+	REQUIRE(run_string(context, "print(''+entity.get_direct()); print(''+entity.get_indirect());") == "123\n456\n");
+
+	const std::string code = c_code.take();
+	CHECK(emits_direct_system_call(code, "get_direct"));
+	CHECK(emits_direct_system_call(code, "get_indirect"));
+}
+
+TEST_CASE("native calling convention methods of auxiliary objects", "[abi][conv_native]") {
+	angelsea::JitConfig config = get_test_jit_config();
+	GeneratedCCapture   c_code(config);
+
+	EngineContext context(config);
+	bind_native_functions(*context.engine);
+
+	shared_entity.id            = 7;
+	shared_entity_manager.scale = 10;
+	REQUIRE(
+	    run_string(
+	        context,
+	        "print(''+add_scale(5)); print(''+entity.scaled_objlast(3)); print(''+entity.scaled_objfirst(3));"
+	    )
+	    == "15\n73\n67\n"
+	);
+
+	const std::string code = c_code.take();
+	CHECK(emits_direct_system_call(code, "add_scale"));
+	CHECK(emits_direct_system_call(code, "scaled_objlast"));
+	CHECK(emits_direct_system_call(code, "scaled_objfirst"));
+}
+
+TEST_CASE("native calling convention multiple inheritance", "[abi][conv_native]") {
+	angelsea::JitConfig config = get_test_jit_config();
+	GeneratedCCapture   c_code(config);
+
+	EngineContext context(config);
+	bind_native_functions(*context.engine);
+
+	// the virtual call goes through the vtable of the `BaseB` subobject, which still dispatches to the override
+	REQUIRE(
+	    run_string(
+	        context,
+	        "print(''+multiple_bases.get_a()); print(''+multiple_bases.get_b());"
+	        "print(''+multiple_bases.get_base_virtual_b());"
+	    )
+	    == "1\n2\n200\n"
+	);
+
+	const std::string code = c_code.take();
+	CHECK(emits_direct_system_call(code, "get_a"));
+	CHECK(emits_direct_system_call(code, "get_b"));
+	CHECK(emits_direct_system_call(code, "get_base_virtual_b"));
+}
+
+TEST_CASE("native calling convention funcdef return", "[abi][conv_native]") {
+	angelsea::JitConfig config = get_test_jit_config();
+	GeneratedCCapture   c_code(config);
+
+	EngineContext context(config);
+	bind_native_functions(*context.engine);
+
+	REQUIRE(run_string(context, "Callback@ cb = get_callback(); cb();") == "called\n");
+
+	CHECK(emits_direct_system_call(c_code.take(), "get_callback"));
+}
+
+TEST_CASE("native calling convention auto handles", "[abi][conv_native]") {
+	angelsea::JitConfig config = get_test_jit_config();
+	GeneratedCCapture   c_code(config);
+
+	EngineContext context(config);
+	bind_native_functions(*context.engine);
+
+	// the returned handle gets a reference added for `r`, and the argument holds another one for the duration of the
+	// call only
+	shared_ref_counted.refs = 1;
+	REQUIRE(
+	    run_string(context, "RefCounted@ r = get_shared_auto_handle(); print(''+peek_refs_auto_handle(r));") == "3\n"
+	);
+	REQUIRE(shared_ref_counted.refs == 1);
+
+	const std::string code = c_code.take();
+	CHECK(emits_direct_system_call(code, "get_shared_auto_handle"));
+	CHECK(emits_direct_system_call(code, "peek_refs_auto_handle"));
+}
+
 TEST_CASE("native abi benchmark", "[abi][conv_native][benchmark]") {
 	EngineContext context;
 	bind_native_functions(*context.engine);
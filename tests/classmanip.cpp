@@ -2,6 +2,7 @@
 
 #include "angelscript.h"
 #include "common.hpp"
+#include <string>
 
 TEST_CASE("string handling", "[str]") {
 	REQUIRE(run("scripts/stringmanip.as", "void string_ref()") == "hello\n");
@@ -21,11 +22,10 @@ TEST_REQUIRE(
     run("scripts/arrays/userclass.as") == "123\n456\n789\n"
 );
 
-TEST_REQUIRE(
-    "arrays and initialization lists",
-    "[array][factory]",
-    run("scripts/arrays/initializationlists.as") == "123\n456\n789\nhello\nhi\n123\n"
-);
+TEST_CASE("arrays and initialization lists", "[array][factory]") {
+	REQUIRE(run("scripts/arrays/initializationlists.as") == "123\n456\n789\nhello\nhi\n123\n");
+	REQUIRE(run("scripts/arrays/initializationlists.as", "void nested()") == "3\n2\n3\n0\n100\n");
+}
 
 TEST_CASE("user classes", "[userclass][simpleuserclass]") {
 	REQUIRE(run("scripts/userclasses.as", "void test()") == "hello\n");
@@ -45,6 +45,7 @@ TEST_CASE("user classes", "[userclass][simpleuserclass]") {
 
 TEST_CASE("user class chkref", "[chkref][userclass]") {
 	REQUIRE(run("scripts/userclasses.as", "void null_test()", asEXECUTION_EXCEPTION) == "");
+	REQUIRE(run("scripts/userclasses.as", "void null_after_check_test()", asEXECUTION_EXCEPTION) == "hello\n0\n1\n");
 }
 
 TEST_CASE("globals with user classes", "[userclass][globals][globalswithclasses]") {
@@ -86,7 +87,51 @@ TEST_CASE("push global address variable", "[asBC_PGA]") {
 	REQUIRE(out.str() == "123\n");
 }
 
-TEST_CASE("devirtualization", "[devirt]") { REQUIRE(run("scripts/devirt.as") == "hello\n"); }
+TEST_CASE("interface method calls", "[interface]") {
+	REQUIRE(run("scripts/interfaces.as", "void polymorphic()") == "4\n16\n40\n4\ncounter\n");
+	REQUIRE(run("scripts/interfaces.as", "void null_call()", asEXECUTION_EXCEPTION) == "");
+}
+
+TEST_CASE("interface method calls across module rebuilds", "[interface]") {
+	EngineContext context;
+
+	asIScriptModule* caller = context.engine->GetModule("caller", asGM_ALWAYS_CREATE);
+	REQUIRE(caller->AddScriptSection("caller", R"(
+		shared interface IValue { int get(); }
+		import IValue@ make() from "impl";
+		void main() { print(make().get()); }
+	)") >= 0);
+	REQUIRE(caller->Build() >= 0);
+
+	// every rebuild creates a new implementing type, which is likely to reuse the address of the type that was
+	// discarded; more types are seen than the call site can cache at once
+	for (int i = 0; i < 8; ++i) {
+		asIScriptModule* impl = context.engine->GetModule("impl", asGM_ALWAYS_CREATE);
+		const std::string code
+		    = "shared interface IValue { int get(); }\n"
+		      "class Impl : IValue { int get() { return "
+		    + std::to_string(i)
+		    + "; } }\n"
+		      "IValue@ make() { return Impl(); }\n";
+		REQUIRE(impl->AddScriptSection("impl", code.c_str()) >= 0);
+		REQUIRE(impl->Build() >= 0);
+		REQUIRE(caller->BindAllImportedFunctions() >= 0);
+
+		out = {};
+		context.run(*caller, "void main()");
+		REQUIRE(out.str() == std::to_string(i) + "\n");
+
+		caller->UnbindAllImportedFunctions();
+		impl->Discard();
+		context.engine->GarbageCollect();
+	}
+}
+
+TEST_CASE("devirtualization", "[devirt]") {
+	REQUIRE(run("scripts/devirt.as") == "hello\n");
+	REQUIRE(run("scripts/devirt.as", "void speculated()") == "16\nshape\n1\n3\n");
+	REQUIRE(run("scripts/devirt.as", "void null_call()", asEXECUTION_EXCEPTION) == "");
+}
 
 TEST_CASE("virtual system functions", "[sysvirt]") {
 	class Base {
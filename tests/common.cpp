@@ -8,6 +8,7 @@
 #include <scriptarray/scriptarray.h>
 #include <scriptbuilder/scriptbuilder.h>
 #include <scriptstdstring/scriptstdstring.h>
+#include <tuple>
 
 std::stringstream out;
 
@@ -82,6 +83,9 @@ angelsea::JitConfig get_test_jit_config() {
 		},
 	};
 
+	// tests tagged [directmir] are also run with the direct MIR backend, see tests/CMakeLists.txt
+	config.experimental_direct_mir = is_env_set("ASEA_DIRECT_MIR");
+
 #ifndef ASEA_NO_DEBUG
 	set_env_int_variable("ASEA_MIR_DEBUG_LEVEL", config.debug.mir_debug_level);
 	set_env_int_variable("ASEA_MIR_OPT_LEVEL", config.mir_optimization_level);
@@ -90,6 +94,35 @@ angelsea::JitConfig get_test_jit_config() {
 	return config;
 }
 
+GeneratedCCapture::GeneratedCCapture(angelsea::JitConfig& config) : file{std::tmpfile()} {
+	ANGELSEA_TEST_CHECK(file != nullptr);
+	config.debug.dump_c_code      = true;
+	config.debug.dump_c_code_file = file;
+}
+
+GeneratedCCapture::~GeneratedCCapture() { std::ignore = std::fclose(file); }
+
+std::string GeneratedCCapture::take() {
+	ANGELSEA_TEST_CHECK(std::fseek(file, 0, SEEK_END) == 0);
+	const long end = std::ftell(file);
+
+	std::string code(std::size_t(end - read_offset), '\0');
+	ANGELSEA_TEST_CHECK(std::fseek(file, read_offset, SEEK_SET) == 0);
+	ANGELSEA_TEST_CHECK(std::fread(code.data(), 1, code.size(), file) == code.size());
+	read_offset = end;
+
+	// the JIT keeps appending to the file
+	ANGELSEA_TEST_CHECK(std::fseek(file, 0, SEEK_END) == 0);
+	return code;
+}
+
+std::string function_code(const std::string& code, std::string_view decl) {
+	const std::size_t begin = code.find(std::string{": "} + std::string{decl} + " */");
+	ANGELSEA_TEST_CHECK(begin != std::string::npos);
+	const std::size_t end = code.find("extern asDWORD ", code.find("extern asDWORD ", begin) + 1);
+	return code.substr(begin, end == std::string::npos ? std::string::npos : end - begin);
+}
+
 EngineContext::EngineContext(const angelsea::JitConfig& config) : engine{asCreateScriptEngine()}, jit{config, *engine} {
 	engine->SetEngineProperty(asEP_INCLUDE_JIT_INSTRUCTIONS, true);
 	engine->SetEngineProperty(asEP_JIT_INTERFACE_VERSION, 2);
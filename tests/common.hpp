@@ -7,8 +7,10 @@
 #include <angelscript.h>
 #include <angelsea/jit.hpp>
 #include <catch2/catch_all.hpp>
+#include <cstdio>
 #include <sstream>
 #include <string>
+#include <string_view>
 
 #define TEST_REQUIRE(name, tag, cond)                                                                                  \
 	TEST_CASE(name, tag) { REQUIRE(cond); }
@@ -23,6 +25,23 @@ extern std::stringstream out;
 
 angelsea::JitConfig get_test_jit_config();
 
+/// Collects the C code generated by a JIT, so that tests can check which code paths were taken.
+struct GeneratedCCapture {
+	/// Makes `config` dump its generated C code into this capture.
+	explicit GeneratedCCapture(angelsea::JitConfig& config);
+
+	~GeneratedCCapture();
+
+	/// Returns the C code generated since the last call.
+	std::string take();
+
+	FILE* file;
+	long  read_offset = 0;
+};
+
+/// Returns the C code generated for the function declared as `decl`, out of the code generated for a whole module.
+std::string function_code(const std::string& code, std::string_view decl);
+
 struct EngineContext {
 	EngineContext(const angelsea::JitConfig& config = get_test_jit_config());
 
@@ -4,7 +4,15 @@
 #include <angelscript.h>
 #include <angelsea/config.hpp>
 #include <angelsea/fnconfig.hpp>
+#include <angelsea/intrinsics.hpp>
+#include <scriptarray/scriptarray.h>
 #include <scriptbuilder/scriptbuilder.h>
+#include <algorithm>
+#include <math.h>
+#include <regex>
+#include <stdexcept>
+#include <string>
+#include <vector>
 
 TEST_CASE("per-function script config", "[config]") {
 	angelsea::JitConfig config                 = get_test_jit_config();
@@ -40,4 +48,423 @@ TEST_CASE("per-function script config", "[config]") {
 	context.jit.SetFnConfigRequestCallback({}, false);
 
 	context.run(*context.engine->GetModule("build"), "void main()", asEXECUTION_FINISHED);
-}
\ No newline at end of file
+}
+
+static void suspend_line_callback(asIScriptContext* ctx, int* line_count) {
+	++*line_count;
+	if (*line_count % 5 == 0) {
+		ctx->Suspend();
+	}
+}
+
+static void suspend_yield() { asGetActiveContext()->Suspend(); }
+
+TEST_CASE("line callbacks and suspends", "[config][suspend]") {
+	angelsea::JitConfig config = get_test_jit_config();
+	config.hack_ignore_suspend = false;
+
+	EngineContext context(config);
+	context.engine->SetEngineProperty(asEP_BUILD_WITHOUT_LINE_CUES, false);
+	REQUIRE(context.engine->RegisterGlobalFunction("void yield()", asFUNCTION(suspend_yield), asCALL_CDECL) >= 0);
+	out = {};
+
+	asIScriptModule&  module = context.build("suspend", "scripts/suspend.as");
+	asIScriptContext* ctx    = context.engine->CreateContext();
+
+	int line_count = 0;
+	REQUIRE(ctx->SetLineCallback(asFUNCTION(suspend_line_callback), &line_count, asCALL_CDECL) >= 0);
+	REQUIRE(ctx->Prepare(module.GetFunctionByDecl("void main()")) >= 0);
+
+	int suspend_count = 0;
+	while (ctx->Execute() == asEXECUTION_SUSPENDED) {
+		++suspend_count;
+	}
+
+	REQUIRE(ctx->GetState() == asEXECUTION_FINISHED);
+	REQUIRE(out.str() == "45\n");
+	REQUIRE(line_count > 10);
+	REQUIRE(suspend_count == line_count / 5);
+
+	ctx->ClearLineCallback();
+	out = {};
+	REQUIRE(ctx->Prepare(module.GetFunctionByDecl("void yielding()")) >= 0);
+
+	suspend_count = 0;
+	while (ctx->Execute() == asEXECUTION_SUSPENDED) {
+		// every suspend must happen right after the call, before the following print
+		REQUIRE(out.str().size() == std::size_t(suspend_count) * 2);
+		++suspend_count;
+	}
+
+	REQUIRE(ctx->GetState() == asEXECUTION_FINISHED);
+	REQUIRE(out.str() == "0\n1\n2\n");
+	REQUIRE(suspend_count == 3);
+
+	ctx->Release();
+}
+
+TEST_CASE("suspends in direct script calls", "[config][suspend]") {
+	angelsea::JitConfig config = get_test_jit_config();
+	config.hack_ignore_suspend = false;
+	GeneratedCCapture c_code(config);
+
+	EngineContext context(config);
+	REQUIRE(context.engine->RegisterGlobalFunction("void yield()", asFUNCTION(suspend_yield), asCALL_CDECL) >= 0);
+	out = {};
+
+	asIScriptModule&  module = context.build("suspend", "scripts/suspend.as");
+	asIScriptContext* ctx    = context.engine->CreateContext();
+	REQUIRE(ctx->Prepare(module.GetFunctionByDecl("void nested_yielding()")) >= 0);
+
+	// the callee suspends in the middle of its loop, and its caller must resume with its own state once it returns
+	int suspend_count = 0;
+	while (ctx->Execute() == asEXECUTION_SUSPENDED) {
+		REQUIRE(ctx->GetCallstackSize() == 2);
+		REQUIRE(out.str().size() == std::size_t(suspend_count / 4) * 4);
+		++suspend_count;
+	}
+
+	REQUIRE(ctx->GetState() == asEXECUTION_FINISHED);
+	REQUIRE(out.str() == "106\n112\n118\n");
+	REQUIRE(suspend_count == 12);
+
+	// the caller resumes in place when the callee returns into it
+	CHECK(c_code.take().find("if (regs->pc != base_pc + ") != std::string::npos);
+
+	ctx->Release();
+}
+
+static void collect_message(const asSMessageInfo* info, void* messages) {
+	static_cast<std::vector<std::string>*>(messages)->emplace_back(info->message);
+}
+
+TEST_CASE("compile cost model", "[config][cost]") {
+	// only count the given metrics, so that the cost of the script is predictable
+	const auto make_config = [](double max_cost, double per_instruction, double per_call) {
+		const angelsea::JitConfig::CompileCostModel model{
+		    .max_cost                   = max_cost,
+		    .per_instruction            = per_instruction,
+		    .per_branch_target          = 0.0,
+		    .per_switch_case            = 0.0,
+		    .per_call                   = per_call,
+		    .per_allocation             = 0.0,
+		    .per_variable               = 0.0,
+		    .per_variable_branch_target = 0.0,
+		};
+
+		angelsea::JitConfig config = get_test_jit_config();
+		config.compile_cost        = model;
+		return config;
+	};
+
+	std::vector<std::string> messages;
+
+	// returns whether the script was compiled
+	const auto compile = [&](angelsea::JitConfig config) {
+		GeneratedCCapture c_code(config);
+		messages.clear();
+
+		EngineContext context(config);
+		REQUIRE(context.engine->SetMessageCallback(asFUNCTION(collect_message), &messages, asCALL_CDECL) >= 0);
+		REQUIRE(run_string(context, "print(1); print(2)") == "1\n2\n");
+		return c_code.take().find(": void main() */") != std::string::npos;
+	};
+
+	const auto find_message = [&](std::string_view text) {
+		return std::any_of(messages.begin(), messages.end(), [&](const std::string& message) {
+			return message.find(text) != std::string::npos;
+		});
+	};
+
+	// the script performs two system calls
+	REQUIRE(!compile(make_config(1999.0, 0.0, 1000.0)));
+	CHECK(find_message("too complex (estimated cost 2000 > 1999;"));
+	CHECK(find_message(", 2 calls,"));
+	REQUIRE(compile(make_config(2000.0, 0.0, 1000.0)));
+
+	REQUIRE(!compile(make_config(0.0, 1.0, 0.0)));
+	const auto instruction_message = std::find_if(messages.begin(), messages.end(), [](const std::string& message) {
+		return message.find("too complex") != std::string::npos;
+	});
+	REQUIRE(instruction_message != messages.end());
+	std::smatch match;
+	const std::regex instruction_regex{R"(estimated cost (\d+) > 0; (\d+) instructions)"};
+	REQUIRE(std::regex_search(*instruction_message, match, instruction_regex));
+	CHECK(match[1].str() == match[2].str());
+
+	// negative costs disable the check
+	REQUIRE(compile(make_config(-1.0, 1e9, 1e9)));
+
+	// the bytecode size limit still applies on its own
+	angelsea::JitConfig size_config = make_config(-1.0, 1.0, 1.0);
+	size_config.max_bytecode_bytes = 4;
+	REQUIRE(!compile(size_config));
+	CHECK(find_message("because its bytecode is too large"));
+	CHECK(!find_message("too complex"));
+
+	size_config.max_bytecode_bytes = 0;
+	REQUIRE(compile(size_config));
+}
+
+static int    push_mix(int a, int b, int c, double d) { return a * 1000 + b * 100 + c * 10 + int(d); }
+static int    push_id(int x) { return x; }
+static double push_half(int x) { return x / 2.0; }
+
+TEST_CASE("coalesced stack pushes", "[config][stack]") {
+	const auto register_push_functions = [](asIScriptEngine& engine) {
+		REQUIRE(
+		    engine.RegisterGlobalFunction("int mix(int, int, int, double)", asFUNCTION(push_mix), asCALL_CDECL) >= 0
+		);
+		REQUIRE(engine.RegisterGlobalFunction("int id(int)", asFUNCTION(push_id), asCALL_CDECL) >= 0);
+		REQUIRE(engine.RegisterGlobalFunction("double half(int)", asFUNCTION(push_half), asCALL_CDECL) >= 0);
+	};
+
+	// arguments computed by calls, between pushes and around branch targets
+	const char* const script
+	    = "int x = 2; print(mix(1, x, 3, 4.0));"
+	      "print(mix(id(1), 2, id(3), half(8)));"
+	      "print(mix(x > 1 ? 5 : 6, x, x < 1 ? 7 : 8, 9.0));"
+	      "int total = 0; for (int i = 0; mix(i, 0, 0, 0.0) < 3000; ++i) { total += mix(i, i, i, double(i)); }"
+	      "print(total);";
+	const char* const expected = "1234\n1234\n5289\n3333\n";
+
+	SECTION("coalesced") {
+		angelsea::JitConfig config = get_test_jit_config();
+		GeneratedCCapture   c_code(config);
+
+		EngineContext context(config);
+		register_push_functions(*context.engine);
+		REQUIRE(run_string(context, script) == expected);
+		CHECK(c_code.take().find("((asea_var*)((asDWORD*)sp - ") != std::string::npos);
+	}
+
+	SECTION("without stack elision") {
+		angelsea::JitConfig config        = get_test_jit_config();
+		config.experimental_stack_elision = false;
+
+		EngineContext context(config);
+		register_push_functions(*context.engine);
+		REQUIRE(run(context, "scripts/functions.as") == "10000\n");
+		REQUIRE(run_string(context, script) == expected);
+	}
+
+#ifndef ASEA_NO_DEBUG
+	// some pushes of a sequence are left to the VM, which must see the pushes coalesced before them
+	SECTION("blacklisted pushes") {
+		angelsea::JitConfig config          = get_test_jit_config();
+		config.debug.blacklist_instructions = {asBC_PshC4};
+
+		EngineContext context(config);
+		register_push_functions(*context.engine);
+		REQUIRE(run_string(context, script) == expected);
+	}
+
+	SECTION("fallback after a push") {
+		angelsea::JitConfig config              = get_test_jit_config();
+		config.debug.fallback_after_instruction = asBC_PshV4;
+
+		EngineContext context(config);
+		register_push_functions(*context.engine);
+		REQUIRE(run_string(context, script) == expected);
+	}
+#endif
+}
+
+static void exception_throw_generic(asIScriptGeneric* gen) {
+	if (gen->GetArgDWord(0) != 0) {
+		throw std::runtime_error{"thrown from generic"};
+	}
+}
+
+static void exception_throw_native(int should_throw) {
+	if (should_throw != 0) {
+		throw std::runtime_error{"thrown from native"};
+	}
+}
+
+static double exception_half_native(int x) {
+	if (x < 0) {
+		throw std::runtime_error{"thrown from native"};
+	}
+	return x / 2.0;
+}
+
+TEST_CASE("exceptions from system functions", "[config][exceptions]") {
+	angelsea::JitConfig config    = get_test_jit_config();
+	config.hack_ignore_exceptions = false;
+	GeneratedCCapture c_code(config);
+
+	EngineContext    context(config);
+	asIScriptEngine& engine = *context.engine;
+	REQUIRE(
+	    engine.RegisterGlobalFunction("void throw_generic(int)", asFUNCTION(exception_throw_generic), asCALL_GENERIC)
+	    >= 0
+	);
+	REQUIRE(engine.RegisterGlobalFunction("void throw_native(int)", asFUNCTION(exception_throw_native), asCALL_CDECL)
+	        >= 0);
+
+	REQUIRE(engine.RegisterGlobalFunction("double half(int)", asFUNCTION(exception_half_native), asCALL_CDECL) >= 0);
+
+	REQUIRE(run_string(context, "throw_generic(0); print(1); throw_native(0); print(2)") == "1\n2\n");
+	REQUIRE(run_string(context, "print(1); throw_generic(1); print(2)", asEXECUTION_EXCEPTION) == "1\n");
+	REQUIRE(run_string(context, "print(1); throw_native(1); print(2)", asEXECUTION_EXCEPTION) == "1\n");
+
+	// native calls are guarded by the runtime rather than made through the VM
+	const std::string guarded_code = c_code.take();
+	CHECK(guarded_code.find("asea_call_native_guarded(") != std::string::npos);
+	CHECK(guarded_code.find("asea_call_system_function") == std::string::npos);
+
+	REQUIRE(run_string(context, "print(int(half(5) * 2)); print(int(half(-1))); print(2)", asEXECUTION_EXCEPTION)
+	        == "5\n");
+	CHECK(c_code.take().find("asea_call_native_guarded_f64(") != std::string::npos);
+}
+
+static int traits_square(int x) { return x * x; }
+static int traits_cube(int x) { return x * x * x; }
+
+static void traits_add_generic(asIScriptGeneric* gen) {
+	gen->SetReturnDWord(gen->GetArgDWord(0) + gen->GetArgDWord(1));
+}
+
+static int  traits_recorded = 0;
+static void traits_record(int x) { traits_recorded = x; }
+
+TEST_CASE("system function traits", "[config][traits]") {
+	angelsea::JitConfig config    = get_test_jit_config();
+	config.hack_ignore_exceptions = false;
+	config.hack_ignore_suspend    = false;
+	GeneratedCCapture c_code(config);
+
+	EngineContext    context(config);
+	asIScriptEngine& engine = *context.engine;
+
+	const int square_id = engine.RegisterGlobalFunction("int square(int)", asFUNCTION(traits_square), asCALL_CDECL);
+	REQUIRE(square_id >= 0);
+	REQUIRE(engine.RegisterGlobalFunction("int cube(int)", asFUNCTION(traits_cube), asCALL_CDECL) >= 0);
+	const int add_id
+	    = engine.RegisterGlobalFunction("int add(int, int)", asFUNCTION(traits_add_generic), asCALL_GENERIC);
+	REQUIRE(add_id >= 0);
+	const int record_id = engine.RegisterGlobalFunction("void record(int)", asFUNCTION(traits_record), asCALL_CDECL);
+	REQUIRE(record_id >= 0);
+	REQUIRE(engine.RegisterGlobalFunction("void throw_native(int)", asFUNCTION(exception_throw_native), asCALL_CDECL)
+	        >= 0);
+
+	for (const int fn_id : {square_id, add_id, record_id}) {
+		context.jit.SetSystemFunctionTraits(fn_id, {.nothrow = true, .no_context_access = true});
+	}
+
+	// only calls to functions with traits: none of them needs to catch exceptions or to check the context afterwards
+	REQUIRE(run_string(context, "int x = 0; for (int i = 0; i < 10; ++i) { x = add(x, square(i)); } record(x);") == "");
+	REQUIRE(traits_recorded == 285);
+	const std::string traits_code = c_code.take();
+	CHECK(traits_code.find("asea_call_generic_guarded") == std::string::npos);
+	CHECK(traits_code.find("asea_call_system_function") == std::string::npos);
+	CHECK(traits_code.find("asea_check_call_status") == std::string::npos);
+
+	// `cube` has no traits, so the context is checked after calling it
+	REQUIRE(run_string(context, "record(cube(2));") == "");
+	REQUIRE(traits_recorded == 8);
+	CHECK(c_code.take().find("asea_check_call_status") != std::string::npos);
+
+	// functions without traits keep raising exceptions
+	REQUIRE(run_string(context, "print(square(3)); throw_native(1); print(2)", asEXECUTION_EXCEPTION) == "9\n");
+}
+
+static int intrinsic_clamp(int x, int min, int max) { return x < min ? min : (x > max ? max : x); }
+
+static float intrinsic_lerp(float a, float b, float t) { return a + (b - a) * t; }
+
+/// Not the C library function, so calls to it must not be replaced by \ref angelsea::register_script_math_intrinsics
+static float marker_floor(float x) { return x + 100.0f; }
+
+TEST_CASE("system function intrinsics", "[config][intrinsics]") {
+	angelsea::JitConfig config    = get_test_jit_config();
+	config.hack_ignore_exceptions = false;
+	GeneratedCCapture c_code(config);
+
+	EngineContext    context(config);
+	asIScriptEngine& engine = *context.engine;
+
+	const int clamp_id
+	    = engine.RegisterGlobalFunction("int clamp(int, int, int)", asFUNCTION(intrinsic_clamp), asCALL_CDECL);
+	REQUIRE(clamp_id >= 0);
+	const int lerp_id
+	    = engine.RegisterGlobalFunction("float lerp(float, float, float)", asFUNCTION(intrinsic_lerp), asCALL_CDECL);
+	REQUIRE(lerp_id >= 0);
+	const int bad_clamp_id
+	    = engine.RegisterGlobalFunction("int bad_clamp(int, int, int)", asFUNCTION(intrinsic_clamp), asCALL_CDECL);
+	REQUIRE(bad_clamp_id >= 0);
+	REQUIRE(engine.RegisterGlobalFunction("float sqrt(float)", asFUNCTIONPR(sqrtf, (float), float), asCALL_CDECL) >= 0);
+	REQUIRE(engine.RegisterGlobalFunction("float floor(float)", asFUNCTION(marker_floor), asCALL_CDECL) >= 0);
+
+	// the intrinsic adds 100 to the result so that the output shows whether it was used over the regular call
+	context.jit.SetSystemFunctionIntrinsic(clamp_id, {.expression = "(100 + ($0 < $1 ? $1 : ($0 > $2 ? $2 : $0)))"});
+	context.jit.SetSystemFunctionIntrinsic(
+	    lerp_id,
+	    {.expression  = "asea_test_lerp($0, $1, $2)",
+	     .definitions = "static inline float asea_test_lerp(float a, float b, float t) { return a + (b - a) * t; }"}
+	);
+	// refers to a nonexistent argument, so the regular call is used instead
+	context.jit.SetSystemFunctionIntrinsic(bad_clamp_id, {.expression = "$3"});
+	angelsea::register_script_math_intrinsics(context.jit, engine);
+	angelsea::register_script_array_intrinsics<CScriptArray>(context.jit, engine);
+
+	REQUIRE(
+	    run_string(context, "print(clamp(-5, 0, 10)); print(clamp(5, 0, 10)); print(clamp(15, 0, 10))")
+	    == "100\n105\n110\n"
+	);
+	REQUIRE(run_string(context, "print(bad_clamp(-5, 0, 10)); print(bad_clamp(15, 0, 10))") == "0\n10\n");
+	REQUIRE(
+	    run_string(context, "print(int(lerp(10.0f, 20.0f, 0.5f))); print(int(sqrt(lerp(0.0f, 32.0f, 0.5f))))")
+	    == "15\n4\n"
+	);
+	c_code.take(); // only check the code of the following runs
+
+	// `sqrt` is bound to the C library, so it is replaced with a call to `sqrtf`, but `floor` is not
+	REQUIRE(run_string(context, "print(int(sqrt(16.0f))); print(int(floor(1.5f)))") == "4\n101\n");
+	const std::string math_code = c_code.take();
+	CHECK(math_code.find("float sqrtf(float);") != std::string::npos);
+	CHECK(math_code.find("floorf") == std::string::npos);
+
+	REQUIRE(
+	    run_string(context, "array<int> a = {1, 2, 3}; array<int> b; print(a.length()); print(b.isEmpty() ? 1 : 0)")
+	    == "3\n1\n"
+	);
+	CHECK(c_code.take().find("asea_script_array_size(") != std::string::npos);
+}
+
+TEST_CASE("direct MIR backend", "[config][directmir]") {
+	struct Variant {
+		bool fast_script_return;
+		bool shadow_call_stack;
+		bool promote_frame_variables;
+	};
+
+	// returns through the VM, a shadow frame and the context call stack, with and without promoted variables
+	const Variant variants[] = {
+	    Variant{false, true, true},
+	    Variant{true, true, true},
+	    Variant{true, false, true},
+	    Variant{true, true, false},
+	};
+	for (const Variant variant : variants) {
+		angelsea::JitConfig config                  = get_test_jit_config();
+		config.experimental_direct_mir              = true;
+		config.experimental_fast_script_return      = variant.fast_script_return;
+		config.experimental_shadow_call_stack       = variant.shadow_call_stack;
+		config.experimental_promote_frame_variables = variant.promote_frame_variables;
+		GeneratedCCapture c_code(config);
+
+		EngineContext context(config);
+		REQUIRE(run(context, "scripts/directmir.as") == "100\n50\n10\n");
+
+		// everything but main should have skipped C generation
+		const std::string code         = c_code.take();
+		std::size_t       direct_count = 0;
+		for (std::size_t pos = 0; (pos = code.find("translated directly to MIR", pos)) != std::string::npos; ++pos) {
+			++direct_count;
+		}
+		CHECK(direct_count == 3);
+		CHECK(code.find(": void main() */") != std::string::npos);
+	}
+}
@@ -24,6 +24,10 @@ TEST_CASE("32-bit float math", "[floatmath32]") {
 
 	REQUIRE(run_string("float a = 10.0f; float b = 0.0f; print(''+ a/b);\n", asEXECUTION_EXCEPTION) == "");
 	REQUIRE(run_string("float a = 10.0f; float b = 0.0f; print(''+ a%b);\n", asEXECUTION_EXCEPTION) == "");
+
+	REQUIRE(run_string("float a = 2.0f, b = 10.0f; print(''+(a ** b));") == "1024\n");
+	REQUIRE(run_string("float a = 4.0f, b = 0.5f; print(''+(a ** b));") == "2\n");
+	REQUIRE(run_string("float a = 10.0f, b = 100.0f; print(''+(a ** b));\n", asEXECUTION_EXCEPTION) == "");
 }
 
 TEST_CASE("64-bit float math", "[floatmath64]") {
@@ -48,6 +52,11 @@ TEST_CASE("64-bit float math", "[floatmath64]") {
 
 	REQUIRE(run_string("double a = 10.0f; double b = 0.0f; print(''+ a/b);\n", asEXECUTION_EXCEPTION) == "");
 	REQUIRE(run_string("double a = 10.0f; double b = 0.0f; print(''+ a%b);\n", asEXECUTION_EXCEPTION) == "");
+
+	REQUIRE(run_string("double a = 2.0, b = 10.0; print(''+(a ** b));") == "1024\n");
+	REQUIRE(run_string("double a = 2.0; int b = -2; print(''+(a ** b));") == "0.25\n");
+	REQUIRE(run_string("double a = 10.0, b = 400.0; print(''+(a ** b));\n", asEXECUTION_EXCEPTION) == "");
+	REQUIRE(run_string("double a = 10.0; int b = 400; print(''+(a ** b));\n", asEXECUTION_EXCEPTION) == "");
 }
 
 TEST_CASE("Floating-point to floating-point conversions", "[castfpfp]") {
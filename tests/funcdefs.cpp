@@ -1,10 +1,45 @@
 // SPDX-License-Identifier: BSD-2-Clause
 
 #include "common.hpp"
-/*
-TEST_CASE("function pointer calls", "[funcdef]")
-{
-    REQUIRE(run("scripts/funcdefs.as", "void test_system()") == "hello\n");
-    REQUIRE(run("scripts/funcdefs.as", "void test_script()") == "hello\n");
+
+#include <angelsea/config.hpp>
+#include <angelsea/detail/runtime.hpp>
+#include <as_scriptfunction.h>
+#include <string>
+
+TEST_CASE("function pointer calls", "[funcdef]") {
+	REQUIRE(run("scripts/funcdefs.as", "void test_system()") == "hello\n");
+	REQUIRE(run("scripts/funcdefs.as", "void test_script()") == "hello\n");
+	REQUIRE(run("scripts/funcdefs.as", "void test_delegate()") == "hello world\n");
+	REQUIRE(run("scripts/funcdefs.as", "void test_handle_argument()") == "5\n9\n");
+	REQUIRE(run("scripts/funcdefs.as", "void test_null()", asEXECUTION_EXCEPTION) == "");
+}
+
+TEST_CASE("function pointer calls to final methods", "[funcdef]") {
+	angelsea::JitConfig config = get_test_jit_config();
+	GeneratedCCapture   c_code(config);
+
+	EngineContext context(config);
+	REQUIRE(run(context, "scripts/funcdefs.as", "void test_delegate_final()") == "hello final\nhello world!\n");
+	const std::string code = function_code(c_code.take(), "void test_delegate_final()");
+	CHECK(code.find("asea_resolve_function_handle(") != std::string::npos);
+
+	// the delegate must be resolved to the method itself, rather than be left to the VM
+	asIScriptModule&   module         = *context.engine->GetModule("scripts/funcdefs.as");
+	asIScriptFunction* make_fn        = module.GetFunctionByDecl("SOME_FUNCDEF@ make_final_delegate()");
+	asIScriptContext*  script_context = context.engine->CreateContext();
+	ANGELSEA_TEST_CHECK(make_fn != nullptr);
+	ANGELSEA_TEST_CHECK(script_context->Prepare(make_fn) >= 0);
+	ANGELSEA_TEST_CHECK(script_context->Execute() == asEXECUTION_FINISHED);
+
+	auto* delegate = static_cast<asCScriptFunction*>(script_context->GetReturnObject());
+	REQUIRE(delegate != nullptr);
+	REQUIRE(delegate->GetFuncType() == asFUNC_DELEGATE);
+	REQUIRE(delegate->GetDelegateFunction()->GetFuncType() == asFUNC_SCRIPT);
+
+	void* delegate_object = nullptr;
+	CHECK(asea_resolve_function_handle(delegate, &delegate_object) == delegate->GetDelegateFunction());
+	CHECK(delegate_object == delegate->GetDelegateObject());
+
+	script_context->Release();
 }
-*/
@@ -2,12 +2,54 @@
 
 #include "common.hpp"
 
+#include <angelsea/config.hpp>
+#include <string>
+
 TEST_CASE("simple parameterized function", "[params]") { REQUIRE(run("scripts/functions.as") == "10000\n"); }
 
 TEST_CASE("references to primitives in parameters", "[refparams]") {
 	REQUIRE(run("scripts/refprimitives.as") == "10\n");
 }
 
+TEST_CASE("inlined script functions", "[inlining]") {
+	angelsea::JitConfig config = get_test_jit_config();
+	GeneratedCCapture   c_code(config);
+
+	EngineContext context(config);
+	REQUIRE(run(context, "scripts/inlining.as") == "25\n1\n4\n3\n0\n0\n10\n5\n2\n");
+
+	// the output is the same without inlining, so check that the getters, setters and math helpers were inlined
+	const std::string main_code = function_code(c_code.take(), "void main()");
+	CHECK(main_code.find("/* inlined call to float Vec2::length_squared()") != std::string::npos);
+	CHECK(main_code.find("/* inlined call to void Vec2::set_x(") != std::string::npos);
+	CHECK(main_code.find("/* inlined call to float Vec2::get_y()") != std::string::npos);
+	CHECK(main_code.find("/* inlined call to int add(") != std::string::npos);
+	CHECK(main_code.find("_deopt:") != std::string::npos);
+
+	REQUIRE(run("scripts/inlining.as", "void divide_by_zero()", asEXECUTION_EXCEPTION) == "");
+	REQUIRE(run("scripts/inlining.as", "void null_this()", asEXECUTION_EXCEPTION) == "");
+}
+
+TEST_CASE("inlined script functions with side effects before an exception", "[inlining]") {
+	angelsea::JitConfig config = get_test_jit_config();
+	GeneratedCCapture   c_code(config);
+
+	EngineContext context(config);
+
+	asIScriptModule& module = context.build("inlining", "scripts/inlining.as");
+	context.run(module, "void bump_then_divide_by_zero()", asEXECUTION_EXCEPTION);
+
+	// the increment must not be repeated if the callee is run again after it raised
+	const int counter_idx = module.GetGlobalVarIndexByName("counter");
+	REQUIRE(counter_idx >= 0);
+	REQUIRE(*static_cast<int*>(module.GetAddressOfGlobalVar(counter_idx)) == 1);
+
+	// the callee may raise after its side effect, so it must not be inlined at all
+	const std::string code = function_code(c_code.take(), "void bump_then_divide_by_zero()");
+	CHECK(code.find("/* inlined call to") == std::string::npos);
+	CHECK(code.find("_deopt:") == std::string::npos);
+}
+
 TEST_CASE("shared functions", "[shared][sharedfuncs]") {
 	EngineContext context;
 
@@ -33,3 +75,21 @@ TEST_CASE("shared functions", "[shared][sharedfuncs]") {
 
 	REQUIRE(out.str() == "10\n10\n");
 }
+
+TEST_CASE("imported functions", "[imports]") {
+	EngineContext context;
+
+	out = {};
+
+	context.build("exporter", "scripts/exports.as");
+	asIScriptModule& importer = context.build("importer", "scripts/imports.as");
+
+	// calling an unbound function raises an exception
+	context.run(importer, "void main()", asEXECUTION_EXCEPTION);
+	REQUIRE(out.str() == "hello\n");
+
+	out = {};
+	REQUIRE(importer.BindAllImportedFunctions() >= 0);
+	context.run(importer, "void main()");
+	REQUIRE(out.str() == "hello\n144\nhello from exporter\nhello\n");
+}
@@ -84,6 +84,23 @@ TEST_CASE("64-bit unsigned division math", "[unsignedmathdiv64]") {
 	REQUIRE(run_string("uint64 a = 10, b = 0; print(''+ a%b);\n", asEXECUTION_EXCEPTION) == "");
 }
 
+TEST_CASE("Integral exponentiation", "[intpow]") {
+	REQUIRE(run_string("int a = 3, b = 4; print(a ** b)") == "81\n");
+	REQUIRE(run_string("int a = -2, b = 3; print(a ** b)") == "-8\n");
+	REQUIRE(run_string("int a = 5, b = -1; print(a ** b)") == "0\n");
+	REQUIRE(run_string("int a = -1, b = 1001; print(a ** b)") == "-1\n");
+	REQUIRE(run_string("uint a = 2, b = 31; print(a ** b)") == "2147483648\n");
+	REQUIRE(run_string("int64 a = 3, b = 39; print(a ** b)") == "4052555153018976267\n");
+	REQUIRE(run_string("uint64 a = 2, b = 63; print(a ** b)") == "9223372036854775808\n");
+
+	REQUIRE(run_string("int a = 2, b = 31; print(''+ a**b);\n", asEXECUTION_EXCEPTION) == "");
+	REQUIRE(run_string("int a = 0, b = 0; print(''+ a**b);\n", asEXECUTION_EXCEPTION) == "");
+	REQUIRE(run_string("int a = 0, b = -1; print(''+ a**b);\n", asEXECUTION_EXCEPTION) == "");
+	REQUIRE(run_string("uint a = 2, b = 32; print(''+ a**b);\n", asEXECUTION_EXCEPTION) == "");
+	REQUIRE(run_string("int64 a = 2, b = 63; print(''+ a**b);\n", asEXECUTION_EXCEPTION) == "");
+	REQUIRE(run_string("uint64 a = 2, b = 64; print(''+ a**b);\n", asEXECUTION_EXCEPTION) == "");
+}
+
 TEST_CASE("32-bit bitwise logic", "[bitwise32]") {
 	REQUIRE(run_string("int32 a = 4354352, b = 1213516; print(a & b)") == "131072\n");
 	REQUIRE(run_string("int32 a = 4354352, b = 1213516; print(a | b)") == "5436796\n");
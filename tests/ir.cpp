@@ -0,0 +1,45 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+#include "common.hpp"
+
+#include <angelsea/config.hpp>
+#include <string>
+
+static constexpr const char* ir_expected_output = "42\n30\n20\n9\n";
+
+TEST_CASE("IR optimizations", "[ir]") {
+	for (const bool promote : {true, false}) {
+		angelsea::JitConfig config                  = get_test_jit_config();
+		config.experimental_promote_frame_variables = promote;
+		GeneratedCCapture c_code(config);
+
+		EngineContext context(config);
+		out = {};
+
+		asIScriptModule& module = context.build("ir", "scripts/ir.as");
+		context.run(module, "void main()");
+		REQUIRE(out.str() == ir_expected_output);
+
+		// the result is stored as a constant, and the variables it was computed from are never written
+		const std::string code = function_code(c_code.take(), "int constants()");
+		CHECK(code.find("= (asDWORD)42;") != std::string::npos);
+		CHECK(code.find("/* eliminated dead store */") != std::string::npos);
+	}
+}
+
+TEST_CASE("IR optimizations disabled", "[ir]") {
+	angelsea::JitConfig config           = get_test_jit_config();
+	config.experimental_ir_optimizations = false;
+	GeneratedCCapture c_code(config);
+
+	EngineContext context(config);
+	out = {};
+
+	asIScriptModule& module = context.build("ir", "scripts/ir.as");
+	context.run(module, "void main()");
+	REQUIRE(out.str() == ir_expected_output);
+
+	const std::string code = function_code(c_code.take(), "int constants()");
+	CHECK(code.find("= (asDWORD)42;") == std::string::npos);
+	CHECK(code.find("/* eliminated dead store */") == std::string::npos);
+}
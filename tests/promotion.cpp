@@ -0,0 +1,151 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+#include "common.hpp"
+
+#include <angelsea/config.hpp>
+#include <as_scriptfunction.h>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+/// Adds 1000 to the `total` variable of the calling script function.
+static void promotion_poke() {
+	asIScriptContext* ctx = asGetActiveContext();
+	for (asUINT i = 0; i < asUINT(ctx->GetVarCount(0)); ++i) {
+		if (std::string_view{ctx->GetVarName(i, 0)} == "total") {
+			*static_cast<int*>(ctx->GetAddressOfVar(i, 0)) += 1000;
+		}
+	}
+}
+
+/// Returns the offset in the stack frame of the variable `name` of `fn`.
+static int variable_offset(asIScriptFunction& fn, std::string_view name) {
+	const auto& variables = static_cast<asCScriptFunction&>(fn).scriptData->variables;
+	for (asUINT i = 0; i < variables.GetLength(); ++i) {
+		if (std::string_view{variables[i]->name.AddressOf()} == name) {
+			return variables[i]->stackOffset;
+		}
+	}
+	throw std::runtime_error{"variable not found"};
+}
+
+/// Returns the start of the declaration of the C local that holds the promoted variable `name` of `fn`, or only of its
+/// name if `c_type` is empty.
+static std::string promoted_declaration(asIScriptFunction& fn, std::string_view name, std::string_view c_type = {}) {
+	const int offset = variable_offset(fn, name);
+	return std::string{c_type.empty() ? "" : "\t"} + std::string{c_type} + ' '
+	     + (offset > 0 ? "var" + std::to_string(offset) : "var_arg" + std::to_string(-offset)) + " = ";
+}
+
+static angelsea::JitConfig get_promotion_test_config() {
+	angelsea::JitConfig config                  = get_test_jit_config();
+	config.experimental_promote_frame_variables = true;
+	config.hack_ignore_context_inspect          = false;
+	// make sure that calls are actual script calls
+	config.experimental_script_inlining   = false;
+	config.experimental_typed_script_call = false;
+	return config;
+}
+
+static void register_promotion_interface(EngineContext& context) {
+	context.engine->SetEngineProperty(asEP_ALLOW_UNSAFE_REFERENCES, true);
+	ANGELSEA_TEST_CHECK(
+	    context.engine->RegisterGlobalFunction("void poke()", asFUNCTION(promotion_poke), asCALL_CDECL) >= 0
+	);
+}
+
+TEST_CASE("promoted frame variable types", "[promotion]") {
+	angelsea::JitConfig config = get_promotion_test_config();
+	GeneratedCCapture   c_code(config);
+
+	EngineContext context(config);
+	register_promotion_interface(context);
+	out = {};
+
+	asIScriptModule& module = context.build("promotion", "scripts/promotion.as");
+	context.run(module, "void types()");
+	REQUIRE(out.str() == "45\n5\n10\n45\n");
+
+	asIScriptFunction& types = *module.GetFunctionByDecl("void types()");
+	const std::string  code  = function_code(c_code.take(), "void types()");
+	CHECK(code.find(promoted_declaration(types, "i", "asINT32")) != std::string::npos);
+	CHECK(code.find(promoted_declaration(types, "f", "float")) != std::string::npos);
+	CHECK(code.find(promoted_declaration(types, "d", "double")) != std::string::npos);
+	CHECK(code.find(promoted_declaration(types, "l", "asINT64")) != std::string::npos);
+}
+
+TEST_CASE("rejected frame variable promotions", "[promotion]") {
+	angelsea::JitConfig config = get_promotion_test_config();
+	GeneratedCCapture   c_code(config);
+
+	EngineContext context(config);
+	register_promotion_interface(context);
+	out = {};
+
+	asIScriptModule& module = context.build("promotion", "scripts/promotion.as");
+	context.run(module, "void address_taken()");
+	context.run(module, "void narrow()");
+	REQUIRE(out.str() == "16\n6\n");
+
+	const std::string code = c_code.take();
+
+	asIScriptFunction& address_taken      = *module.GetFunctionByDecl("void address_taken()");
+	const std::string  address_taken_code = function_code(code, "void address_taken()");
+	CHECK(address_taken_code.find(promoted_declaration(address_taken, "escaping")) == std::string::npos);
+	REQUIRE(variable_offset(address_taken, "escaping") == variable_offset(address_taken, "kept") + 1);
+	CHECK(address_taken_code.find(promoted_declaration(address_taken, "kept")) == std::string::npos);
+
+	asIScriptFunction& narrow = *module.GetFunctionByDecl("void narrow()");
+	CHECK(function_code(code, "void narrow()").find(promoted_declaration(narrow, "small")) == std::string::npos);
+}
+
+TEST_CASE("promoted frame variables around calls", "[promotion]") {
+	angelsea::JitConfig config = get_promotion_test_config();
+	GeneratedCCapture   c_code(config);
+
+	EngineContext context(config);
+	register_promotion_interface(context);
+	out = {};
+
+	asIScriptModule& module = context.build("promotion", "scripts/promotion.as");
+
+	// the system function sees the value of `total` and the script sees the value it wrote
+	context.run(module, "void across_calls()");
+	REQUIRE(out.str() == "1285\n");
+
+	asIScriptFunction& across_calls = *module.GetFunctionByDecl("void across_calls()");
+	CHECK(
+	    function_code(c_code.take(), "void across_calls()").find(promoted_declaration(across_calls, "total", "asINT32"))
+	    != std::string::npos
+	);
+}
+
+#ifndef ASEA_NO_DEBUG
+TEST_CASE("promoted frame variables around VM fallbacks", "[promotion]") {
+	// every iteration of the loops falls back to the VM, which must see and update the promoted variables
+	for (const asEBCInstr instruction : {asBC_ADDi, asBC_ADDd, asBC_CALL}) {
+		angelsea::JitConfig config          = get_promotion_test_config();
+		config.debug.blacklist_instructions = {instruction};
+
+		EngineContext context(config);
+		register_promotion_interface(context);
+		out = {};
+
+		asIScriptModule& module = context.build("promotion", "scripts/promotion.as");
+		context.run(module, "void types()");
+		context.run(module, "void across_calls()");
+		REQUIRE(out.str() == "45\n5\n10\n45\n1285\n");
+	}
+
+	angelsea::JitConfig config              = get_promotion_test_config();
+	config.debug.fallback_after_instruction = asBC_ADDi;
+
+	EngineContext context(config);
+	register_promotion_interface(context);
+	out = {};
+
+	asIScriptModule& module = context.build("promotion", "scripts/promotion.as");
+	context.run(module, "void types()");
+	REQUIRE(out.str() == "45\n5\n10\n45\n");
+}
+#endif
@@ -3,6 +3,8 @@
 #include "benchmark.hpp"
 #include "common.hpp"
 
+#include <string>
+#include <string_view>
 #include <thread>
 
 TEST_CASE("recursive fibonacci", "[fib]") {
@@ -52,6 +54,178 @@ uint64_t fib_iterative(uint64_t n) {
 	return last;
 }
 
+TEST_CASE("recursion with mixed argument types", "[recursion]") {
+	REQUIRE(run("scripts/typedrecursion.as") == "-22\n5\n");
+}
+
+TEST_CASE("deep recursion through typed calls", "[recursion]") {
+	angelsea::JitConfig config         = get_test_jit_config();
+	config.typed_script_call_max_depth = 16;
+	GeneratedCCapture c_code(config);
+
+	// past the maximum depth of typed calls, recursion continues through regular calls
+	EngineContext context(config);
+	REQUIRE(run(context, "scripts/typedrecursion.as", "void deep()") == "2000\n");
+
+	// the typed entry point is only emitted along with the function, and other functions call it through its slot
+	const std::string code      = c_code.take();
+	const std::string entry_tag = "/* typed entry for int depth(int) */";
+	const auto        entry_pos = code.find(entry_tag);
+	REQUIRE(entry_pos != std::string::npos);
+	CHECK(code.find(entry_tag, entry_pos + 1) == std::string::npos);
+	CHECK(code.find("_typedslot") != std::string::npos);
+
+	// the regular calls happen at the maximum depth, so the calls that are already done are not repeated
+	REQUIRE(run(context, "scripts/typedrecursion.as", "void deep_counted()") == "100\n101\n");
+
+	// the call stack size limit of the engine must be enforced, including for calls that were not pushed to the call
+	// stack yet
+	for (const bool shadow_call_stack : {false, true}) {
+		angelsea::JitConfig limited_config            = get_test_jit_config();
+		limited_config.experimental_shadow_call_stack = shadow_call_stack;
+
+		EngineContext limited_context(limited_config);
+		limited_context.engine->SetEngineProperty(asEP_MAX_CALL_STACK_SIZE, 100);
+		REQUIRE(run(limited_context, "scripts/typedrecursion.as", "void deep()", asEXECUTION_EXCEPTION) == "");
+	}
+}
+
+TEST_CASE("call stack on exception in nested script calls", "[recursion]") {
+	EngineContext context;
+
+	out = {};
+
+	asIScriptModule& module = context.build("build", "scripts/callstack.as");
+	context.prepare_execution();
+
+	asIScriptFunction* divide_deep = module.GetFunctionByDecl("int divide_deep(int, int)");
+	ANGELSEA_TEST_CHECK(divide_deep != nullptr);
+
+	asIScriptContext* script_context = context.engine->CreateContext();
+
+	const auto run_divide_deep = [&](int depth, int divisor) -> int {
+		ANGELSEA_TEST_CHECK(script_context->Prepare(divide_deep) >= 0);
+		ANGELSEA_TEST_CHECK(script_context->SetArgDWord(0, depth) >= 0);
+		ANGELSEA_TEST_CHECK(script_context->SetArgDWord(1, divisor) >= 0);
+		return script_context->Execute();
+	};
+
+	REQUIRE(run_divide_deep(10, 5) == asEXECUTION_FINISHED);
+	REQUIRE(script_context->GetReturnDWord() == 30);
+
+	// every call should be visible once the exception is raised
+	REQUIRE(run_divide_deep(10, 0) == asEXECUTION_EXCEPTION);
+	REQUIRE(script_context->GetCallstackSize() == 11);
+	REQUIRE(script_context->GetExceptionFunction() == divide_deep);
+
+	// the context should remain usable after the exception
+	REQUIRE(run_divide_deep(3, 1) == asEXECUTION_FINISHED);
+	REQUIRE(script_context->GetReturnDWord() == 103);
+
+	script_context->Release();
+}
+
+TEST_CASE("call stack size limit in nested script calls", "[recursion]") {
+	EngineContext context;
+	context.engine->SetEngineProperty(asEP_MAX_CALL_STACK_SIZE, 50);
+
+	out = {};
+
+	asIScriptModule& module = context.build("build", "scripts/callstack.as");
+	context.prepare_execution();
+
+	asIScriptFunction* divide_deep = module.GetFunctionByDecl("int divide_deep(int, int)");
+	ANGELSEA_TEST_CHECK(divide_deep != nullptr);
+
+	asIScriptContext* script_context = context.engine->CreateContext();
+
+	ANGELSEA_TEST_CHECK(script_context->Prepare(divide_deep) >= 0);
+	ANGELSEA_TEST_CHECK(script_context->SetArgDWord(0, 100) >= 0);
+	ANGELSEA_TEST_CHECK(script_context->SetArgDWord(1, 5) >= 0);
+	REQUIRE(script_context->Execute() == asEXECUTION_EXCEPTION);
+	REQUIRE(std::string_view{script_context->GetExceptionString()} == "Stack overflow");
+	REQUIRE(script_context->GetExceptionFunction() == divide_deep);
+	REQUIRE(script_context->GetCallstackSize() > 1);
+
+	script_context->Release();
+}
+
+static void inspect_context() {
+	asIScriptContext* ctx = asGetActiveContext();
+	out << ctx->GetCallstackSize() << ' ' << ctx->GetLineNumber(0) << '\n';
+
+	for (asUINT i = 0; i < asUINT(ctx->GetVarCount(0)); ++i) {
+		if (std::string_view{ctx->GetVarName(i, 0)} == "counter") {
+			out << *static_cast<int*>(ctx->GetAddressOfVar(i, 0)) << '\n';
+		}
+	}
+
+	// variables of the caller, which are held in C locals by the JIT if promoted
+	if (ctx->GetCallstackSize() > 1) {
+		for (asUINT i = 0; i < asUINT(ctx->GetVarCount(1)); ++i) {
+			if (std::string_view{ctx->GetVarName(i, 1)} == "outer") {
+				out << *static_cast<int*>(ctx->GetAddressOfVar(i, 1)) << '\n';
+			}
+		}
+	}
+}
+
+TEST_CASE("context inspection from system functions", "[recursion]") {
+	angelsea::JitConfig config         = get_test_jit_config();
+	config.hack_ignore_context_inspect = false;
+
+	EngineContext context(config);
+	ANGELSEA_TEST_CHECK(
+	    context.engine->RegisterGlobalFunction("void inspect()", asFUNCTION(inspect_context), asCALL_CDECL) >= 0
+	);
+
+	out = {};
+
+	asIScriptModule& module = context.build("build", "scripts/inspect.as");
+	context.prepare_execution();
+
+	asIScriptFunction* inspect_nested = module.GetFunctionByDecl("void inspect_nested(int)");
+	ANGELSEA_TEST_CHECK(inspect_nested != nullptr);
+
+	asIScriptContext* script_context = context.engine->CreateContext();
+
+	const auto run_inspect_nested = [&](int depth) {
+		out = {};
+		ANGELSEA_TEST_CHECK(script_context->Prepare(inspect_nested) >= 0);
+		ANGELSEA_TEST_CHECK(script_context->SetArgDWord(0, depth) >= 0);
+		ANGELSEA_TEST_CHECK(script_context->Execute() == asEXECUTION_FINISHED);
+		return out.str();
+	};
+
+	REQUIRE(run_inspect_nested(0) == "1 15\n10\n");
+
+	// every script call should be visible from the system function, along with the variables of its caller
+	REQUIRE(run_inspect_nested(3) == "4 15\n10\n10\n");
+
+	script_context->Release();
+}
+
+static void walk_call_stack() {
+	asIScriptContext* ctx = asGetActiveContext();
+	for (asUINT i = 0; i < ctx->GetCallstackSize(); ++i) {
+		out << (i == 0 ? "" : " ") << ctx->GetFunction(i)->GetName();
+	}
+	out << '\n';
+}
+
+TEST_CASE("call stack walk from system functions", "[recursion]") {
+	// with the default configuration, the registers of the context are left stale, but the call stack is complete
+	EngineContext context;
+	ANGELSEA_TEST_CHECK(
+	    context.engine->RegisterGlobalFunction("void walk()", asFUNCTION(walk_call_stack), asCALL_CDECL) >= 0
+	);
+
+	REQUIRE(
+	    run(context, "scripts/callstackwalk.as", "void walk_from_entry()")
+	    == "walk_nested walk_nested walk_nested walk_from_entry\nwalk_from_entry\n"
+	);
+}
+
 TEST_CASE("fib benchmark", "[fib][benchmark]") {
 	EngineContext context;
 
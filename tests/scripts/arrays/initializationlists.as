@@ -26,3 +26,21 @@ void main()
         print(foos[i].m_value);
     }
 }
+
+void nested()
+{
+    int[][] grid = {{1, 2}, {3}, {}};
+
+    uint total = 0;
+    for (uint i = 0; i < 100; ++i)
+    {
+        int[] row = {int(i), 1};
+        total += row[1];
+    }
+
+    print(grid.length());
+    print(grid[0][1]);
+    print(grid[1][0]);
+    print(grid[2].length());
+    print(total);
+}
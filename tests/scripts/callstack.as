@@ -0,0 +1,13 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// Recursive script calls where the innermost call may raise an exception.
+
+int divide_deep(int depth, int divisor)
+{
+    if (depth == 0)
+    {
+        return 100 / divisor;
+    }
+
+    return divide_deep(depth - 1, divisor) + 1;
+}
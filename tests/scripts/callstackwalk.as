@@ -0,0 +1,20 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// Nested script calls where the innermost call walks the call stack from a system function.
+
+void walk_nested(int depth)
+{
+    if (depth == 0)
+    {
+        walk();
+        return;
+    }
+
+    walk_nested(depth - 1);
+}
+
+void walk_from_entry()
+{
+    walk_nested(2);
+    walk();
+}
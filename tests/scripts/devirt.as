@@ -14,3 +14,55 @@ void main()
 {
     B().foo();
 }
+
+class Shape
+{
+    int area() { return 0; }
+    string name() { return "shape"; }
+}
+
+class Square : Shape
+{
+    int side;
+    Square(int s) { side = s; }
+    int area() override { return side * side; }
+}
+
+final class Circle : Shape
+{
+    int area() override { return 3; }
+}
+
+class Base
+{
+    int value = 1;
+    int get() { return value; }
+}
+
+class Derived : Base {}
+
+void speculated()
+{
+    Shape@[] shapes = {Shape(), Square(3), Circle(), Square(2)};
+    int total = 0;
+    for (uint i = 0; i < shapes.length(); ++i)
+    {
+        total += shapes[i].area();
+    }
+    print(total);
+
+    // never overridden
+    print(shapes[1].name());
+
+    Base@ b = Derived();
+    print(b.get());
+
+    Circle c;
+    print(c.area());
+}
+
+void null_call()
+{
+    Shape@ s = null;
+    s.area();
+}
@@ -0,0 +1,37 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// Functions only made of primitive arithmetic and branches, which the direct MIR backend can translate.
+
+int clamp_add(int a, int b)
+{
+    int sum = a + b;
+    if (sum > 100)
+    {
+        return 100;
+    }
+
+    return sum;
+}
+
+double lerp(double a, double b, double t)
+{
+    return a + (b - a) * t;
+}
+
+int64 mix(int64 a, int64 b)
+{
+    return (a ^ b) * 3 - (a & b);
+}
+
+void main()
+{
+    int total = 0;
+    for (int i = 0; i < 60; ++i)
+    {
+        total = clamp_add(total, i);
+    }
+
+    print(total);
+    print(int64(lerp(10, 20, 0.25) * 4));
+    print(mix(12, 10));
+}
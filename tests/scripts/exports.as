@@ -0,0 +1,16 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+void exported_print(const string &in str)
+{
+    print(str);
+}
+
+int square(int x)
+{
+    return x * x;
+}
+
+void greet()
+{
+    print("hello from exporter");
+}
@@ -18,3 +18,91 @@ void test_script()
     SOME_FUNCDEF@ printer = @print_proxy_test;
     printer("hello");
 }
+
+class Greeter
+{
+    string name;
+
+    Greeter(const string &in name)
+    {
+        this.name = name;
+    }
+
+    void greet(const string &in str)
+    {
+        print(str + " " + name);
+    }
+
+    void greet_final(const string &in str) final
+    {
+        print(str + " " + name + "!");
+    }
+}
+
+final class FinalGreeter
+{
+    string name;
+
+    FinalGreeter(const string &in name)
+    {
+        this.name = name;
+    }
+
+    void greet(const string &in str)
+    {
+        print(str + " " + name);
+    }
+}
+
+void test_delegate()
+{
+    Greeter greeter("world");
+    SOME_FUNCDEF@ printer = SOME_FUNCDEF(greeter.greet);
+    printer("hello");
+}
+
+SOME_FUNCDEF@ make_final_delegate()
+{
+    FinalGreeter greeter("final");
+    return SOME_FUNCDEF(greeter.greet);
+}
+
+void test_delegate_final()
+{
+    SOME_FUNCDEF@ printer = make_final_delegate();
+    printer("hello");
+
+    Greeter greeter("world");
+    @printer = SOME_FUNCDEF(greeter.greet_final);
+    printer("hello");
+}
+
+void test_null()
+{
+    SOME_FUNCDEF@ printer;
+    printer("hello");
+}
+
+funcdef int BINOP(int, int);
+
+int add(int a, int b)
+{
+    return a + b;
+}
+
+int apply_first(BINOP@ op, int a, int b)
+{
+    return op(a, b);
+}
+
+int apply_last(int a, int b, BINOP@ op)
+{
+    return op(a, b);
+}
+
+void test_handle_argument()
+{
+    // arguments are pushed from last to first, so the handle is pushed after the integers here
+    print("" + apply_first(@add, 2, 3));
+    print("" + apply_last(4, 5, @add));
+}
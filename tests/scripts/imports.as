@@ -0,0 +1,13 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+import void exported_print(const string &in) from "exporter";
+import int square(int) from "exporter";
+import void greet() from "exporter";
+
+void main()
+{
+    print("hello");
+    print(square(12));
+    greet();
+    exported_print("hello");
+}
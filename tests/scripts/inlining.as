@@ -0,0 +1,60 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// Small functions that are candidates for inlining into their callers.
+
+class Vec2
+{
+    float x;
+    float y;
+
+    float length_squared() const { return x * x + y * y; }
+    void set_x(float value) { x = value; }
+    float get_y() const { return y; }
+}
+
+int counter = 0;
+
+int add(int a, int b) { return a + b; }
+bool is_positive(int a) { return a > 0; }
+int clamp_positive(int a) { if (a < 0) { return 0; } return a; }
+int divide(int a, int b) { return a / b; }
+void bump() { counter += 1; }
+int bump_and_divide(int a, int b) { counter++; return a / b; }
+
+void main()
+{
+    Vec2 v;
+    v.x = 3;
+    v.y = 4;
+    print(int(v.length_squared()));
+    v.set_x(1);
+    print(int(v.x));
+    print(int(v.get_y()));
+
+    print(add(1, 2));
+    print(is_positive(-5) ? 1 : 0);
+    print(clamp_positive(-10));
+    print(clamp_positive(10));
+    print(divide(10, 2));
+
+    bump();
+    bump();
+    print(counter);
+}
+
+void divide_by_zero()
+{
+    print(divide(1, 0));
+}
+
+void null_this()
+{
+    Vec2@ v = null;
+    print(int(v.get_y()));
+}
+
+void bump_then_divide_by_zero()
+{
+    counter = 0;
+    print(bump_and_divide(1, 0));
+}
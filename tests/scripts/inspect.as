@@ -0,0 +1,25 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// Nested script calls where the innermost call inspects the context from a system function.
+
+void inspect_nested(int depth)
+{
+    int outer = depth * 10;
+    if (depth == 0)
+    {
+        int counter = 0;
+        for (int i = 0; i < 5; ++i)
+        {
+            counter += i;
+        }
+        inspect();
+        return;
+    }
+
+    inspect_nested(depth - 1);
+
+    if (outer != depth * 10)
+    {
+        print("stale");
+    }
+}
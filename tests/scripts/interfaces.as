@@ -0,0 +1,65 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+interface IComponent
+{
+    void update();
+    int get_value();
+}
+
+interface INamed
+{
+    string get_name();
+}
+
+class Counter : IComponent, INamed
+{
+    int value = 0;
+
+    void update() { value += 1; }
+    int get_value() { return value; }
+    string get_name() { return "counter"; }
+}
+
+class Doubler : IComponent
+{
+    int value = 1;
+
+    void update() { value *= 2; }
+    int get_value() { return value; }
+}
+
+class FastCounter : Counter
+{
+    void update() override { value += 10; }
+}
+
+void polymorphic()
+{
+    Counter a;
+    Doubler b;
+    FastCounter c;
+    Counter d;
+    IComponent@[] components = {@a, @b, @c, @d};
+
+    for (int frame = 0; frame < 4; ++frame)
+    {
+        for (uint i = 0; i < components.length(); ++i)
+        {
+            components[i].update();
+        }
+    }
+
+    for (uint i = 0; i < components.length(); ++i)
+    {
+        print(components[i].get_value());
+    }
+
+    INamed@ named = cast<INamed>(components[2]);
+    print(named.get_name());
+}
+
+void null_call()
+{
+    IComponent@ component;
+    component.update();
+}
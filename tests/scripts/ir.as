@@ -0,0 +1,48 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// Arithmetic over frame variables that is optimized in the IR, see JitConfig::experimental_ir_optimizations.
+
+// Folds to a constant, leaving every intermediate variable dead.
+int constants()
+{
+    int a = 6;
+    int b = a * 7;
+    int c = b - 2;
+    return c + 2;
+}
+
+// `y` is only ever a copy of `x`.
+int copies(int x)
+{
+    int y = x;
+    int z = y + 1;
+    return z * y;
+}
+
+// `step` stays constant across the back edge of the loop, while `total` does not.
+int loop_sum(int n)
+{
+    int step = 2;
+    int total = 0;
+    for (int i = 0; i < n; ++i)
+    {
+        total += step;
+    }
+    return total;
+}
+
+// Floating-point arithmetic is never folded, but its constant operands are still propagated.
+float float_constants()
+{
+    float f = 1.5f;
+    float g = f * 2.0f;
+    return g + f;
+}
+
+void main()
+{
+    print(constants());
+    print(copies(5));
+    print(loop_sum(10));
+    print(int(float_constants() * 2));
+}
@@ -0,0 +1,67 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// Frame variables that are candidates for being held in C locals, see JitConfig::experimental_promote_frame_variables.
+
+// Variables of every type that can be promoted.
+void types()
+{
+    int i = 0;
+    float f = 0;
+    double d = 0;
+    int64 l = 0;
+    for (int n = 0; n < 10; ++n)
+    {
+        i += n;
+        f += 0.5f;
+        d += 0.25;
+        l += n;
+    }
+    print(i);
+    print(int(f));
+    print(int(d * 4));
+    print(l);
+}
+
+void bump(int &v)
+{
+    v += 1;
+}
+
+// `escaping` has its address taken. As the size of its accesses is then unknown, it is assumed to overlap with `kept`,
+// which is right below it in the stack frame.
+void address_taken()
+{
+    int kept = 10;
+    int escaping = 5;
+    bump(escaping);
+    kept += escaping;
+    print(kept);
+}
+
+// `small` is only ever accessed as a single byte.
+void narrow()
+{
+    int8 small = 0;
+    for (int n = 0; n < 4; ++n)
+    {
+        small += int8(n);
+    }
+    print(small);
+}
+
+int square(int x)
+{
+    return x * x;
+}
+
+// `total` is live across script calls and a system call that modifies it through the context.
+void across_calls()
+{
+    int total = 0;
+    for (int i = 0; i < 10; ++i)
+    {
+        total += square(i);
+    }
+    poke();
+    print(total);
+}
@@ -0,0 +1,46 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+int sum(int n)
+{
+    int total = 0;
+    for (int i = 0; i < n; ++i)
+    {
+        total += i;
+    }
+    return total;
+}
+
+void main()
+{
+    print(sum(10));
+}
+
+void yielding()
+{
+    for (int i = 0; i < 3; ++i)
+    {
+        yield();
+        print(i);
+    }
+}
+
+int accumulate(int n)
+{
+    int total = 0;
+    for (int i = 0; i < n; ++i)
+    {
+        yield();
+        total += i;
+    }
+    return total;
+}
+
+void nested_yielding()
+{
+    int grand_total = 100;
+    for (int round = 0; round < 3; ++round)
+    {
+        grand_total += accumulate(4);
+        print(grand_total);
+    }
+}
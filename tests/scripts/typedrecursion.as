@@ -0,0 +1,64 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// Recursive functions with primitive arguments of various types.
+
+double sum_scaled(double x, int n, int8 sign)
+{
+    if (n == 0)
+    {
+        return 0;
+    }
+
+    return sign * x + sum_scaled(x * 2, n - 1, sign);
+}
+
+int64 count_down(int64 n, bool flag)
+{
+    if (n <= 0)
+    {
+        return flag ? 1 : 0;
+    }
+
+    return count_down(n - 1, !flag) + 1;
+}
+
+int depth(int n)
+{
+    if (n <= 0)
+    {
+        return 0;
+    }
+
+    return depth(n - 1) + 1;
+}
+
+void deep()
+{
+    print(depth(2000));
+}
+
+int calls = 0;
+
+int counted(int n)
+{
+    calls += 1;
+
+    if (n <= 0)
+    {
+        return 0;
+    }
+
+    return counted(n - 1) + 1;
+}
+
+void deep_counted()
+{
+    print(counted(100));
+    print(calls);
+}
+
+void main()
+{
+    print(int64(sum_scaled(1.5, 4, -1)));
+    print(count_down(5, true));
+}
@@ -110,6 +110,19 @@ void null_test()
     by_ref(f);
 }
 
+// The handle is checked in every iteration, but only the first checks may be assumed to pass.
+void null_after_check_test()
+{
+    Foo f;
+    Foo@ h = @f;
+    for (int i = 0; i < 3; ++i)
+    {
+        h.m4 = i;
+        print(h.m4);
+        if (i == 1) { @h = null; }
+    }
+}
+
 void is_test()
 {
     Foo f1, f2;